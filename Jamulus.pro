@@ -365,7 +365,13 @@ FORMS_GUI = src/aboutdlgbase.ui \
 
 HEADERS += src/buffer.h \
     src/channel.h \
+    src/frameworkerpool.h \
+    src/chanaddrtable.h \
+    src/iouring.h \
     src/global.h \
+    src/lockfreequeue.h \
+    src/mixkernels.h \
+    src/packettrace.h \
     src/protocol.h \
     src/recorder/jamcontroller.h \
     src/threadpool.h \
@@ -376,6 +382,7 @@ HEADERS += src/buffer.h \
     src/rpcserver.h \
     src/settings.h \
     src/socket.h \
+    src/timerwheel.h \
     src/util.h \
     src/recorder/jamrecorder.h \
     src/recorder/creaperproject.h \
@@ -476,7 +483,12 @@ HEADERS_OPUS_X86 = libs/opus/celt/x86/celt_lpc_sse.h \
 
 SOURCES += src/buffer.cpp \
     src/channel.cpp \
+    src/frameworkerpool.cpp \
+    src/chanaddrtable.cpp \
+    src/iouring.cpp \
     src/main.cpp \
+    src/mixkernels.cpp \
+    src/packettrace.cpp \
     src/protocol.cpp \
     src/recorder/jamcontroller.cpp \
     src/server.cpp \
@@ -487,6 +499,7 @@ SOURCES += src/buffer.cpp \
     src/settings.cpp \
     src/signalhandler.cpp \
     src/socket.cpp \
+    src/timerwheel.cpp \
     src/util.cpp \
     src/recorder/jamrecorder.cpp \
     src/recorder/creaperproject.cpp \
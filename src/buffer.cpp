@@ -33,11 +33,9 @@ void CNetBuf::Init ( const int iNewBlockSize, const int iNewNumBlocks, const boo
     // store the sequence number activation flag
     bUseSequenceNumber = bNUseSequenceNumber;
 
-    // in simulation mode the size is not changed during operation -> we do
-    // not have to implement special code for this case
     // only enter the "preserve" branch, if object was already initialized
     // and the block sizes are the same
-    if ( bPreserve && ( !bIsSimulation ) && bIsInitialized && ( iBlockSize == iNewBlockSize ) )
+    if ( bPreserve && bIsInitialized && ( iBlockSize == iNewBlockSize ) )
     {
         // extract all data from buffer in temporary storage
         CVector<CVector<uint8_t>> vecvecTempMemory = vecvecMemory; // allocate worst case memory by copying
@@ -113,12 +111,9 @@ void CNetBuf::Resize ( const int iNewNumBlocks, const int iNewBlockSize )
     vecvecMemory.Init ( iNewNumBlocks );
     veciBlockValid.Init ( iNewNumBlocks, 0 ); // initialize with zeros = invalid
 
-    if ( !bIsSimulation )
+    for ( int iBlock = 0; iBlock < iNewNumBlocks; iBlock++ )
     {
-        for ( int iBlock = 0; iBlock < iNewNumBlocks; iBlock++ )
-        {
-            vecvecMemory[iBlock].Init ( iNewBlockSize );
-        }
+        vecvecMemory[iBlock].Init ( iNewBlockSize );
     }
 
     // init buffer pointers and buffer state (empty buffer) and store buffer properties
@@ -241,12 +236,8 @@ bool CNetBuf::Put ( const CVector<uint8_t>& vecbyData, int iInSize )
                 }
             }
 
-            // for simulation buffer only update pointer, no data copying
-            if ( !bIsSimulation )
-            {
-                // copy one block of data in buffer
-                std::copy ( vecbyData.begin() + iBlockOffset, vecbyData.begin() + iBlockOffset + iBlockSize, vecvecMemory[iBlockPutPos].begin() );
-            }
+            // copy one block of data in buffer
+            std::copy ( vecbyData.begin() + iBlockOffset, vecbyData.begin() + iBlockOffset + iBlockSize, vecvecMemory[iBlockPutPos].begin() );
 
             // valid packet added, set flag
             veciBlockValid[iBlockPutPos] = 1;
@@ -266,15 +257,11 @@ bool CNetBuf::Put ( const CVector<uint8_t>& vecbyData, int iInSize )
 
         for ( int iBlock = 0; iBlock < iNumBlocks; iBlock++ )
         {
-            // for simultion buffer only update pointer, no data copying
-            if ( !bIsSimulation )
-            {
-                // calculate the block offset once per loop instead of repeated multiplying
-                const int iBlockOffset = iBlock * iBlockSize;
+            // calculate the block offset once per loop instead of repeated multiplying
+            const int iBlockOffset = iBlock * iBlockSize;
 
-                // copy one block of data in buffer
-                std::copy ( vecbyData.begin() + iBlockOffset, vecbyData.begin() + iBlockOffset + iBlockSize, vecvecMemory[iBlockPutPos].begin() );
-            }
+            // copy one block of data in buffer
+            std::copy ( vecbyData.begin() + iBlockOffset, vecbyData.begin() + iBlockOffset + iBlockSize, vecvecMemory[iBlockPutPos].begin() );
 
             // set the put position one block further
             iBlockPutPos++;
@@ -320,8 +307,8 @@ bool CNetBuf::Get ( CVector<uint8_t>& vecbyData, const int iOutSize )
         veciBlockValid[iBlockGetPos] = 0; // zero means invalid
     }
 
-    // for simultion buffer or invalid block only update pointer, no data copying
-    if ( !bIsSimulation && bReturn )
+    // for an invalid block only update pointer, no data copying
+    if ( bReturn )
     {
         // copy data from internal buffer in output buffer
         std::copy ( vecvecMemory[iBlockGetPos].begin(), vecvecMemory[iBlockGetPos].begin() + iBlockSize, vecbyData.begin() );
@@ -399,11 +386,190 @@ int CNetBuf::GetAvailData() const
     return iAvBlocks * iBlockSize;
 }
 
-/* Network buffer with statistic calculations implementation ******************/
-CNetBufWithStats::CNetBufWithStats() :
-    CNetBuf ( false ), // base class init: no simulation mode
+/* Network buffer simulation implementation ***********************************/
+CNetBufSimulation::CNetBufSimulation() : iBlockSize ( 0 ), bUseSequenceNumber ( false ) {}
+
+void CNetBufSimulation::Init ( const int iNewBlockSize, const int* piNewNumBlocks, const bool bNUseSequenceNumber )
+{
+    iBlockSize         = iNewBlockSize;
+    bUseSequenceNumber = bNUseSequenceNumber;
+
+    // same as the resize of CNetBuf (the sequence number is not reset)
+    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+    {
+        Q_ASSERT ( piNewNumBlocks[i] <= 32 ); // one bit per block in the valid mask
+
+        SimState[i].iNumBlocks      = piNewNumBlocks[i];
+        SimState[i].iNumAvailBlocks = 0;
+        SimState[i].iBlockGetPos    = 0;
+        SimState[i].iBlockValidMask = 0;
+    }
+}
+
+void CNetBufSimulation::Put ( const CVector<uint8_t>& vecbyData, const int iInSize, bool* pbErrors )
+{
+    if ( bUseSequenceNumber )
+    {
+        // check that the input size is a multiple of the block size
+        if ( ( iInSize % ( iBlockSize + iNumBytesSeqNum ) ) != 0 )
+        {
+            for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+            {
+                pbErrors[i] = true;
+            }
+            return;
+        }
+
+        // the sequence numbers are extracted once for all simulation buffers
+        // (same number of blocks as in CNetBuf::Put)
+        const int iNumBlocks = /* floor */ ( iInSize / iBlockSize );
+
+        for ( int iBlock = 0; iBlock < iNumBlocks; iBlock++ )
+        {
+            const int iCurrentSequenceNumber = vecbyData[iBlock * ( iBlockSize + iNumBytesSeqNum ) + iBlockSize];
+
+            for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+            {
+                PutSequenceNumber ( SimState[i], iCurrentSequenceNumber );
+            }
+        }
+
+        for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+        {
+            pbErrors[i] = false;
+        }
+    }
+    else
+    {
+        const bool bIsMultiple = ( ( iInSize % iBlockSize ) == 0 );
+        const int  iNumBlocks  = iInSize / iBlockSize;
+
+        for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+        {
+            // check if there is not enough space available
+            if ( !bIsMultiple || ( ( SimState[i].iNumBlocks - SimState[i].iNumAvailBlocks ) * iBlockSize < iInSize ) )
+            {
+                pbErrors[i] = true;
+            }
+            else
+            {
+                SimState[i].iNumAvailBlocks += iNumBlocks;
+                pbErrors[i] = false;
+            }
+        }
+    }
+}
+
+void CNetBufSimulation::PutSequenceNumber ( CSimState& CurState, const int iCurrentSequenceNumber )
+{
+    // this is the sequence number handling of CNetBuf::Put, see there for details
+    int iSeqNumDiff = iCurrentSequenceNumber - static_cast<int> ( CurState.iSequenceNumberAtGetPos );
+
+    if ( iSeqNumDiff < -128 )
+    {
+        iSeqNumDiff += 256;
+    }
+    else if ( iSeqNumDiff >= 128 )
+    {
+        iSeqNumDiff -= 256;
+    }
+
+    int iBlockPutPos;
+
+    if ( iSeqNumDiff < 0 )
+    {
+        // the received packet comes too late, shift the "buffer window" to the past
+        for ( int i = iSeqNumDiff; i < 0; i++ )
+        {
+            CurState.iBlockValidMask &= ~( 1u << CurState.iBlockGetPos );
+
+            CurState.iSequenceNumberAtGetPos--;
+            CurState.iBlockGetPos--;
+
+            if ( CurState.iBlockGetPos < 0 )
+            {
+                CurState.iBlockGetPos += CurState.iNumBlocks;
+            }
+        }
+
+        iBlockPutPos = CurState.iBlockGetPos;
+    }
+    else if ( iSeqNumDiff >= CurState.iNumBlocks )
+    {
+        // the received packet comes too early, move the "buffer window" in the future
+        for ( int i = 0; i < iSeqNumDiff - CurState.iNumBlocks + 1; i++ )
+        {
+            CurState.iBlockValidMask &= ~( 1u << CurState.iBlockGetPos );
+
+            CurState.iSequenceNumberAtGetPos++;
+            CurState.iBlockGetPos++;
+
+            if ( CurState.iBlockGetPos >= CurState.iNumBlocks )
+            {
+                CurState.iBlockGetPos -= CurState.iNumBlocks;
+            }
+        }
+
+        iBlockPutPos = CurState.iBlockGetPos + CurState.iNumBlocks - 1;
+    }
+    else
+    {
+        // regular case: the received packet fits into the buffer
+        iBlockPutPos = CurState.iBlockGetPos + iSeqNumDiff;
+    }
+
+    if ( iBlockPutPos >= CurState.iNumBlocks )
+    {
+        iBlockPutPos -= CurState.iNumBlocks;
+    }
+
+    CurState.iBlockValidMask |= 1u << iBlockPutPos;
+}
+
+void CNetBufSimulation::Get ( const int iOutSize, bool* pbErrors )
+{
+    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+    {
+        CSimState& CurState = SimState[i];
+
+        // check requested output size and available buffer data (with sequence
+        // numbers the complete buffer is available per definition)
+        const int iNumAvailBlocks = bUseSequenceNumber ? CurState.iNumBlocks : CurState.iNumAvailBlocks;
+
+        if ( ( iOutSize == 0 ) || ( iOutSize != iBlockSize ) || ( iNumAvailBlocks * iBlockSize < iOutSize ) )
+        {
+            pbErrors[i] = true;
+            continue;
+        }
+
+        if ( bUseSequenceNumber )
+        {
+            const uint32_t iGetPosMask = 1u << CurState.iBlockGetPos;
+
+            // take the block from the buffer and invalidate it
+            pbErrors[i] = ( CurState.iBlockValidMask & iGetPosMask ) == 0;
+            CurState.iBlockValidMask &= ~iGetPosMask;
+
+            CurState.iBlockGetPos++;
+
+            if ( CurState.iBlockGetPos == CurState.iNumBlocks )
+            {
+                CurState.iBlockGetPos = 0;
+            }
+        }
+        else
+        {
+            CurState.iNumAvailBlocks--;
+            pbErrors[i] = false;
+        }
+
+        CurState.iSequenceNumberAtGetPos++; // wraps around automatically
+    }
+}
+
+/* Jitter buffer size estimators implementation ******************************/
+CNetBufErrorRateEstimator::CNetBufErrorRateEstimator() :
     iMaxStatisticCount ( MAX_STATISTIC_COUNT ),
-    bUseDoubleSystemFrameSize ( false ),
     dAutoFilt_WightUpNormal ( IIR_WEIGTH_UP_NORMAL ),
     dAutoFilt_WightDownNormal ( IIR_WEIGTH_DOWN_NORMAL ),
     dAutoFilt_WightUpFast ( IIR_WEIGTH_UP_FAST ),
@@ -426,15 +592,9 @@ CNetBufWithStats::CNetBufWithStats() :
     viBufSizesForSim[7] = 9;
     viBufSizesForSim[8] = 10;
     viBufSizesForSim[9] = 11;
-
-    // set all simulation buffers in simulation mode
-    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
-    {
-        SimulationBuffer[i].SetIsSimulation ( true );
-    }
 }
 
-void CNetBufWithStats::GetErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
+void CNetBufErrorRateEstimator::GetErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
 {
     // get all the averages of the error statistic
     vecErrRates.Init ( NUM_STAT_SIMULATION_BUFFERS );
@@ -449,58 +609,51 @@ void CNetBufWithStats::GetErrorRates ( CVector<double>& vecErrRates, double& dLi
     dMaxUpLimit = dUpMaxErrorBound;
 }
 
-void CNetBufWithStats::Init ( const int iNewBlockSize, const int iNewNumBlocks, const bool bNUseSequenceNumber, const bool bPreserve )
+void CNetBufErrorRateEstimator::Init ( const int iNewBlockSize, const bool bNUseSequenceNumber, const bool bNUseDoubleSystemFrameSize )
 {
-    // call base class Init
-    CNetBuf::Init ( iNewBlockSize, iNewNumBlocks, bNUseSequenceNumber, bPreserve );
-
-    // inits for statistics calculation
-    if ( !bPreserve )
+    // set the auto filter weights and max statistic count
+    if ( bNUseDoubleSystemFrameSize )
     {
-        // set the auto filter weights and max statistic count
-        if ( bUseDoubleSystemFrameSize )
-        {
-            dAutoFilt_WightUpNormal   = IIR_WEIGTH_UP_NORMAL_DOUBLE_FRAME_SIZE;
-            dAutoFilt_WightDownNormal = IIR_WEIGTH_DOWN_NORMAL_DOUBLE_FRAME_SIZE;
-            dAutoFilt_WightUpFast     = IIR_WEIGTH_UP_FAST_DOUBLE_FRAME_SIZE;
-            dAutoFilt_WightDownFast   = IIR_WEIGTH_DOWN_FAST_DOUBLE_FRAME_SIZE;
-            iMaxStatisticCount        = MAX_STATISTIC_COUNT_DOUBLE_FRAME_SIZE;
-            dErrorRateBound           = ERROR_RATE_BOUND_DOUBLE_FRAME_SIZE;
-            dUpMaxErrorBound          = UP_MAX_ERROR_BOUND_DOUBLE_FRAME_SIZE;
-        }
-        else
-        {
-            dAutoFilt_WightUpNormal   = IIR_WEIGTH_UP_NORMAL;
-            dAutoFilt_WightDownNormal = IIR_WEIGTH_DOWN_NORMAL;
-            dAutoFilt_WightUpFast     = IIR_WEIGTH_UP_FAST;
-            dAutoFilt_WightDownFast   = IIR_WEIGTH_DOWN_FAST;
-            iMaxStatisticCount        = MAX_STATISTIC_COUNT;
-            dErrorRateBound           = ERROR_RATE_BOUND;
-            dUpMaxErrorBound          = UP_MAX_ERROR_BOUND;
-        }
+        dAutoFilt_WightUpNormal   = IIR_WEIGTH_UP_NORMAL_DOUBLE_FRAME_SIZE;
+        dAutoFilt_WightDownNormal = IIR_WEIGTH_DOWN_NORMAL_DOUBLE_FRAME_SIZE;
+        dAutoFilt_WightUpFast     = IIR_WEIGTH_UP_FAST_DOUBLE_FRAME_SIZE;
+        dAutoFilt_WightDownFast   = IIR_WEIGTH_DOWN_FAST_DOUBLE_FRAME_SIZE;
+        iMaxStatisticCount        = MAX_STATISTIC_COUNT_DOUBLE_FRAME_SIZE;
+        dErrorRateBound           = ERROR_RATE_BOUND_DOUBLE_FRAME_SIZE;
+        dUpMaxErrorBound          = UP_MAX_ERROR_BOUND_DOUBLE_FRAME_SIZE;
+    }
+    else
+    {
+        dAutoFilt_WightUpNormal   = IIR_WEIGTH_UP_NORMAL;
+        dAutoFilt_WightDownNormal = IIR_WEIGTH_DOWN_NORMAL;
+        dAutoFilt_WightUpFast     = IIR_WEIGTH_UP_FAST;
+        dAutoFilt_WightDownFast   = IIR_WEIGTH_DOWN_FAST;
+        iMaxStatisticCount        = MAX_STATISTIC_COUNT;
+        dErrorRateBound           = ERROR_RATE_BOUND;
+        dUpMaxErrorBound          = UP_MAX_ERROR_BOUND;
+    }
 
-        for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
-        {
-            // init simulation buffers with the correct size
-            SimulationBuffer[i].Init ( iNewBlockSize, viBufSizesForSim[i], bNUseSequenceNumber );
+    // init simulation buffers with the correct size
+    SimulationBuffers.Init ( iNewBlockSize, viBufSizesForSim, bNUseSequenceNumber );
 
-            // init statistics
-            ErrorRateStatistic[i].Init ( iMaxStatisticCount, true );
-        }
+    for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
+    {
+        // init statistics
+        ErrorRateStatistic[i].Init ( iMaxStatisticCount, true );
+    }
 
-        // reset the initialization counter which controls the initialization
-        // phase length
-        ResetInitCounter();
+    // reset the initialization counter which controls the initialization
+    // phase length
+    ResetInitCounter();
 
-        // init auto buffer setting with a meaningful value, also init the
-        // IIR parameter with this value
-        iCurAutoBufferSizeSetting = 6;
-        dCurIIRFilterResult       = iCurAutoBufferSizeSetting;
-        iCurDecidedResult         = iCurAutoBufferSizeSetting;
-    }
+    // init auto buffer setting with a meaningful value, also init the
+    // IIR parameter with this value
+    iCurAutoBufferSizeSetting = 6;
+    dCurIIRFilterResult       = iCurAutoBufferSizeSetting;
+    iCurDecidedResult         = iCurAutoBufferSizeSetting;
 }
 
-void CNetBufWithStats::ResetInitCounter()
+void CNetBufErrorRateEstimator::ResetInitCounter()
 {
     // start initialization phase of IIR filtering, use a quarter the size
     // of the error rate statistic buffers which should be ok for a good
@@ -509,38 +662,32 @@ void CNetBufWithStats::ResetInitCounter()
     iInitCounter = iMaxStatisticCount / 4;
 }
 
-bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData, const int iInSize )
+void CNetBufErrorRateEstimator::Put ( const CVector<uint8_t>& vecbyData, const int iInSize )
 {
-    // call base class Put
-    const bool bPutOK = CNetBuf::Put ( vecbyData, iInSize );
-
     // update statistics calculations
+    SimulationBuffers.Put ( vecbyData, iInSize, vbSimulationErrors );
+
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        ErrorRateStatistic[i].Update ( !SimulationBuffer[i].Put ( vecbyData, iInSize ) );
+        ErrorRateStatistic[i].Update ( vbSimulationErrors[i] );
     }
-
-    return bPutOK;
 }
 
-bool CNetBufWithStats::Get ( CVector<uint8_t>& vecbyData, const int iOutSize )
+void CNetBufErrorRateEstimator::Get ( const int iOutSize )
 {
-    // call base class Get
-    const bool bGetOK = CNetBuf::Get ( vecbyData, iOutSize );
-
     // update statistics calculations
+    SimulationBuffers.Get ( iOutSize, vbSimulationErrors );
+
     for ( int i = 0; i < NUM_STAT_SIMULATION_BUFFERS; i++ )
     {
-        ErrorRateStatistic[i].Update ( !SimulationBuffer[i].Get ( vecbyData, iOutSize ) );
+        ErrorRateStatistic[i].Update ( vbSimulationErrors[i] );
     }
 
     // update auto setting
     UpdateAutoSetting();
-
-    return bGetOK;
 }
 
-void CNetBufWithStats::UpdateAutoSetting()
+void CNetBufErrorRateEstimator::UpdateAutoSetting()
 {
     int  iCurDecision      = 0; // dummy initialization
     int  iCurMaxUpDecision = 0; // dummy initialization
@@ -675,3 +822,207 @@ else
         }
     }
 }
+
+CNetBufDelayPercentileEstimator::CNetBufDelayPercentileEstimator() :
+    iWindowPos ( 0 ),
+    iNumWindow ( 0 ),
+    iUpdateCnt ( 0 ),
+    iCurAutoBufferSizeSetting ( 6 ),
+    dBlockDurationNs ( 0 ),
+    bChangeTimeValid ( false ),
+    iLastChangeTimeNs ( 0 )
+{
+    vecDelayBins.Init ( DELAY_PERC_WINDOW_LEN, 0 );
+    veciBinCounts.Init ( DELAY_PERC_NUM_BINS, 0 );
+}
+
+void CNetBufDelayPercentileEstimator::Init ( const int iNewBlockSize, const bool bNUseSequenceNumber, const bool bNUseDoubleSystemFrameSize )
+{
+    Q_UNUSED ( iNewBlockSize )
+    Q_UNUSED ( bNUseSequenceNumber )
+
+    const int iBlockSizeSamples = bNUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
+
+    dBlockDurationNs = iBlockSizeSamples * 1e9 / SYSTEM_SAMPLE_RATE_HZ;
+
+    // start with an empty window and the same initial value as the error
+    // rate estimator
+    veciBinCounts.Reset ( 0 );
+
+    iWindowPos                = 0;
+    iNumWindow                = 0;
+    iUpdateCnt                = 0;
+    iCurAutoBufferSizeSetting = 6;
+    bChangeTimeValid          = false;
+}
+
+void CNetBufDelayPercentileEstimator::PutArrivalDelay ( const int64_t iArrivalTimeNs, const double dDelayNs, const int iNumBlocks )
+{
+    // the packet which restarts the delay reference has no delay value
+    if ( dDelayNs < 0 )
+    {
+        return;
+    }
+
+    if ( !bChangeTimeValid )
+    {
+        iLastChangeTimeNs = iArrivalTimeNs;
+        bChangeTimeValid  = true;
+    }
+
+    // replace the oldest packet of the window in the histogram
+    const int iBin = std::min ( static_cast<int> ( dDelayNs / DELAY_PERC_BIN_NS ), DELAY_PERC_NUM_BINS - 1 );
+
+    if ( iNumWindow == DELAY_PERC_WINDOW_LEN )
+    {
+        veciBinCounts[vecDelayBins[iWindowPos]]--;
+    }
+    else
+    {
+        iNumWindow++;
+    }
+
+    vecDelayBins[iWindowPos] = static_cast<uint16_t> ( iBin );
+    veciBinCounts[iBin]++;
+
+    iWindowPos = ( iWindowPos + 1 ) % DELAY_PERC_WINDOW_LEN;
+
+    if ( ++iUpdateCnt >= DELAY_PERC_UPDATE_INTERVAL )
+    {
+        iUpdateCnt = 0;
+        UpdateAutoSetting ( iArrivalTimeNs, iNumBlocks );
+    }
+}
+
+void CNetBufDelayPercentileEstimator::UpdateAutoSetting ( const int64_t iArrivalTimeNs, const int iNumBlocks )
+{
+    // search the percentile from the top of the histogram (only a few packets
+    // may have a larger delay)
+    const int iMaxNumAbove = static_cast<int> ( iNumWindow * ( 1.0 - DELAY_PERC_PERCENTILE ) );
+    int       iNumAbove    = 0;
+    int       iBin         = DELAY_PERC_NUM_BINS - 1;
+
+    while ( iBin > 0 )
+    {
+        iNumAbove += veciBinCounts[iBin];
+
+        if ( iNumAbove > iMaxNumAbove )
+        {
+            break;
+        }
+
+        iBin--;
+    }
+
+    // the buffer has to cover the delay (upper edge of the bin), the
+    // additional blocks of a packet and a safety margin
+    const double dPercDelayNs = static_cast<double> ( iBin + 1 ) * DELAY_PERC_BIN_NS;
+    const int    iNewSetting  = std::max ( DELAY_PERC_MIN_NUM_BLOCKS,
+                                       std::min ( MAX_NET_BUF_SIZE_NUM_BL,
+                                                  static_cast<int> ( ceil ( dPercDelayNs / dBlockDurationNs ) ) + iNumBlocks - 1 + DELAY_PERC_SAFETY_BLOCKS ) );
+
+    // fast attack, slow release
+    const int64_t iReleaseTimeNs = ( iNumWindow < DELAY_PERC_WINDOW_LEN ) ? DELAY_PERC_INIT_RELEASE_TIME_NS : DELAY_PERC_RELEASE_TIME_NS;
+
+    if ( iNewSetting > iCurAutoBufferSizeSetting )
+    {
+        iCurAutoBufferSizeSetting = iNewSetting;
+        iLastChangeTimeNs         = iArrivalTimeNs;
+    }
+    else if ( iNewSetting == iCurAutoBufferSizeSetting )
+    {
+        // the current size is still needed
+        iLastChangeTimeNs = iArrivalTimeNs;
+    }
+    else if ( iArrivalTimeNs - iLastChangeTimeNs >= iReleaseTimeNs )
+    {
+        iCurAutoBufferSizeSetting--;
+        iLastChangeTimeNs = iArrivalTimeNs;
+    }
+}
+
+/* Network buffer with statistic calculations implementation ******************/
+CNetBufWithStats::CNetBufWithStats() :
+    CNetBuf(),
+    pEstimator ( &ErrorRateEstimator ),
+    eStrategy ( JS_ERROR_RATE ),
+    bUseDoubleSystemFrameSize ( false )
+{}
+
+void CNetBufWithStats::SetStrategy ( const EJitBufStrategy eNewStrategy )
+{
+    if ( eNewStrategy == eStrategy )
+    {
+        return;
+    }
+
+    eStrategy = eNewStrategy;
+
+    switch ( eStrategy )
+    {
+    case JS_DELAY_PERCENTILE:
+        pEstimator = &DelayPercentileEstimator;
+        break;
+
+    default: // JS_ERROR_RATE
+        pEstimator = &ErrorRateEstimator;
+        break;
+    }
+
+    // the new estimator starts from scratch
+    if ( bIsInitialized )
+    {
+        pEstimator->Init ( iBlockSize, bUseSequenceNumber, bUseDoubleSystemFrameSize );
+    }
+}
+
+void CNetBufWithStats::Init ( const int iNewBlockSize, const int iNewNumBlocks, const bool bNUseSequenceNumber, const bool bPreserve )
+{
+    // call base class Init
+    CNetBuf::Init ( iNewBlockSize, iNewNumBlocks, bNUseSequenceNumber, bPreserve );
+
+    // inits for statistics calculation
+    if ( !bPreserve )
+    {
+        pEstimator->Init ( iNewBlockSize, bNUseSequenceNumber, bUseDoubleSystemFrameSize );
+
+        ArrivalJitterStatistic.Reset();
+    }
+}
+
+bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData, const int iInSize )
+{
+    // call base class Put
+    const bool bPutOK = CNetBuf::Put ( vecbyData, iInSize );
+
+    // update statistics calculations
+    pEstimator->Put ( vecbyData, iInSize );
+
+    return bPutOK;
+}
+
+bool CNetBufWithStats::Put ( const CVector<uint8_t>& vecbyData, const int iInSize, const int64_t iArrivalTimeNs )
+{
+    // the nominal packet interval follows from the number of blocks in the
+    // packet (one block has 64 or 128 samples)
+    const int    iNumBlocks         = iBlockSize > 0 ? iInSize / iBlockSize : 1;
+    const int    iBlockSizeSamples  = bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
+    const double dNominalIntervalNs = iNumBlocks * iBlockSizeSamples * 1e9 / SYSTEM_SAMPLE_RATE_HZ;
+
+    const double dDelayNs = ArrivalJitterStatistic.Update ( iArrivalTimeNs, dNominalIntervalNs );
+
+    pEstimator->PutArrivalDelay ( iArrivalTimeNs, dDelayNs, iNumBlocks );
+
+    return Put ( vecbyData, iInSize );
+}
+
+bool CNetBufWithStats::Get ( CVector<uint8_t>& vecbyData, const int iOutSize )
+{
+    // call base class Get
+    const bool bGetOK = CNetBuf::Get ( vecbyData, iOutSize );
+
+    // update statistics calculations
+    pEstimator->Get ( iOutSize );
+
+    return bGetOK;
+}
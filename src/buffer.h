@@ -68,6 +68,23 @@
 #define IIR_WEIGTH_UP_FAST     0.9997499687422
 #define IIR_WEIGTH_DOWN_FAST   0.999499875
 
+// The delay percentile estimator sizes the buffer so that it covers the
+// DELAY_PERC_PERCENTILE of the packet arrival delays of the last
+// DELAY_PERC_WINDOW_LEN packets. The delays are collected in a histogram with
+// a resolution of DELAY_PERC_BIN_NS, the percentile is evaluated every
+// DELAY_PERC_UPDATE_INTERVAL packets. A larger buffer is applied at once (fast
+// attack), a smaller one only after no larger buffer was needed for
+// DELAY_PERC_RELEASE_TIME_NS and then only one block at a time (slow release).
+#define DELAY_PERC_WINDOW_LEN           4096
+#define DELAY_PERC_PERCENTILE           0.998
+#define DELAY_PERC_BIN_NS               125000
+#define DELAY_PERC_NUM_BINS             512
+#define DELAY_PERC_UPDATE_INTERVAL      16
+#define DELAY_PERC_RELEASE_TIME_NS      5000000000LL
+#define DELAY_PERC_INIT_RELEASE_TIME_NS 1000000000LL // until the window is filled
+#define DELAY_PERC_SAFETY_BLOCKS        1
+#define DELAY_PERC_MIN_NUM_BLOCKS       2
+
 /* Classes ********************************************************************/
 // Buffer base class -----------------------------------------------------------
 template<class TData>
@@ -233,12 +250,10 @@ protected:
 class CNetBuf
 {
 public:
-    CNetBuf ( const bool bNIsSim = false ) : iSequenceNumberAtGetPos ( 0 ), bIsSimulation ( bNIsSim ), bIsInitialized ( false ) {}
+    CNetBuf() : iSequenceNumberAtGetPos ( 0 ), bIsInitialized ( false ) {}
 
     void Init ( const int iNewBlockSize, const int iNewNumBlocks, const bool bNUseSequenceNumber, const bool bPreserve = false );
 
-    void SetIsSimulation ( const bool bNIsSim ) { bIsSimulation = bNIsSim; }
-
     virtual bool Put ( const CVector<uint8_t>& vecbyData, int iInSize );
     virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
 
@@ -263,26 +278,95 @@ protected:
     uint8_t                   iSequenceNumberAtGetPos; // uint8_t so that it wraps automatically
     EBufState                 eBufState;
     bool                      bUseSequenceNumber;
-    bool                      bIsSimulation;
     bool                      bIsInitialized;
 
     static constexpr int iNumBytesSeqNum = 1; // per definition 1 byte sequence counter
 };
 
-// Network buffer (jitter buffer) with statistic calculations ------------------
-class CNetBufWithStats : public CNetBuf
+// Simulation of the network buffers for the statistic -------------------------
+// Simulates NUM_STAT_SIMULATION_BUFFERS network buffers of different sizes at
+// once. Only the buffer state (fill level or get position, sequence number and
+// valid blocks) is tracked, no audio data is copied. The Put()/Get() results
+// are identical to the ones of CNetBuf objects with the same sizes.
+class CNetBufSimulation
 {
 public:
-    CNetBufWithStats();
+    CNetBufSimulation();
 
-    void Init ( const int iNewBlockSize, const int iNewNumBlocks, const bool bNUseSequenceNumber, const bool bPreserve = false );
+    void Init ( const int iNewBlockSize, const int* piNewNumBlocks, const bool bNUseSequenceNumber );
 
-    void SetUseDoubleSystemFrameSize ( const bool bNDSFSize ) { bUseDoubleSystemFrameSize = bNDSFSize; }
+    // the results are stored per simulation buffer (true means error)
+    void Put ( const CVector<uint8_t>& vecbyData, const int iInSize, bool* pbErrors );
+    void Get ( const int iOutSize, bool* pbErrors );
 
-    virtual bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
-    virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
+protected:
+    class CSimState
+    {
+    public:
+        CSimState() : iNumBlocks ( 0 ), iNumAvailBlocks ( 0 ), iBlockGetPos ( 0 ), iBlockValidMask ( 0 ), iSequenceNumberAtGetPos ( 0 ) {}
+
+        int      iNumBlocks;
+        int      iNumAvailBlocks; // without sequence numbers
+        int      iBlockGetPos;    // with sequence numbers
+        uint32_t iBlockValidMask; // with sequence numbers, one bit per block of the memory
+        uint8_t  iSequenceNumberAtGetPos;
+    };
+
+    void PutSequenceNumber ( CSimState& CurState, const int iCurrentSequenceNumber );
+
+    CSimState SimState[NUM_STAT_SIMULATION_BUFFERS];
+    int       iBlockSize;
+    bool      bUseSequenceNumber;
+
+    static constexpr int iNumBytesSeqNum = 1; // per definition 1 byte sequence counter
+};
+
+// Jitter buffer size estimators ----------------------------------------------
+// Interface of the strategies for the automatic jitter buffer size. The
+// estimator is informed about each packet which is put in the buffer and each
+// block which is read from the buffer, the functions which are not needed by
+// an estimator can be left at their default.
+class CNetBufSizeEstimator
+{
+public:
+    virtual ~CNetBufSizeEstimator() {}
+
+    // called on each (not preserving) initialization of the buffer
+    virtual void Init ( const int iNewBlockSize, const bool bNUseSequenceNumber, const bool bNUseDoubleSystemFrameSize ) = 0;
+
+    // arrival delay of a packet compared to the fastest packets (a negative
+    // delay means that the delay reference was restarted with this packet)
+    virtual void PutArrivalDelay ( const int64_t iArrivalTimeNs, const double dDelayNs, const int iNumBlocks )
+    {
+        Q_UNUSED ( iArrivalTimeNs )
+        Q_UNUSED ( dDelayNs )
+        Q_UNUSED ( iNumBlocks )
+    }
+
+    virtual void Put ( const CVector<uint8_t>& vecbyData, const int iInSize )
+    {
+        Q_UNUSED ( vecbyData )
+        Q_UNUSED ( iInSize )
+    }
+
+    virtual void Get ( const int iOutSize ) { Q_UNUSED ( iOutSize ) }
+
+    // the buffer size in blocks which is applied by the channel
+    virtual int GetAutoSetting() = 0;
+};
+
+// Estimator based on the error rates of simulated buffers of different sizes
+// (default strategy)
+class CNetBufErrorRateEstimator : public CNetBufSizeEstimator
+{
+public:
+    CNetBufErrorRateEstimator();
+
+    virtual void Init ( const int iNewBlockSize, const bool bNUseSequenceNumber, const bool bNUseDoubleSystemFrameSize );
+    virtual void Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
+    virtual void Get ( const int iOutSize );
+    virtual int  GetAutoSetting() { return iCurAutoBufferSizeSetting; }
 
-    int  GetAutoSetting() { return iCurAutoBufferSizeSetting; }
     void GetErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit );
 
 protected:
@@ -291,9 +375,10 @@ protected:
 
     // statistic (do not use the vector class since the classes do not have
     // appropriate copy constructor/operator)
-    CErrorRate ErrorRateStatistic[NUM_STAT_SIMULATION_BUFFERS];
-    CNetBuf    SimulationBuffer[NUM_STAT_SIMULATION_BUFFERS];
-    int        viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS];
+    CErrorRate        ErrorRateStatistic[NUM_STAT_SIMULATION_BUFFERS];
+    CNetBufSimulation SimulationBuffers;
+    int               viBufSizesForSim[NUM_STAT_SIMULATION_BUFFERS];
+    bool              vbSimulationErrors[NUM_STAT_SIMULATION_BUFFERS];
 
     double dCurIIRFilterResult;
     int    iCurDecidedResult;
@@ -301,7 +386,6 @@ protected:
     int    iCurAutoBufferSizeSetting;
     int    iMaxStatisticCount;
 
-    bool   bUseDoubleSystemFrameSize;
     double dAutoFilt_WightUpNormal;
     double dAutoFilt_WightDownNormal;
     double dAutoFilt_WightUpFast;
@@ -310,6 +394,72 @@ protected:
     double dUpMaxErrorBound;
 };
 
+// Estimator based on a windowed percentile of the packet arrival delays with
+// fast attack and slow release
+class CNetBufDelayPercentileEstimator : public CNetBufSizeEstimator
+{
+public:
+    CNetBufDelayPercentileEstimator();
+
+    virtual void Init ( const int iNewBlockSize, const bool bNUseSequenceNumber, const bool bNUseDoubleSystemFrameSize );
+    virtual void PutArrivalDelay ( const int64_t iArrivalTimeNs, const double dDelayNs, const int iNumBlocks );
+    virtual int  GetAutoSetting() { return iCurAutoBufferSizeSetting; }
+
+protected:
+    void UpdateAutoSetting ( const int64_t iArrivalTimeNs, const int iNumBlocks );
+
+    CVector<uint16_t> vecDelayBins;  // histogram bin of each packet of the window
+    CVector<int>      veciBinCounts; // histogram of the window
+    int               iWindowPos;
+    int               iNumWindow;
+    int               iUpdateCnt;
+    int               iCurAutoBufferSizeSetting;
+    double            dBlockDurationNs;
+    bool              bChangeTimeValid;
+    int64_t           iLastChangeTimeNs;
+};
+
+// Network buffer (jitter buffer) with statistic calculations ------------------
+class CNetBufWithStats : public CNetBuf
+{
+public:
+    CNetBufWithStats();
+
+    void Init ( const int iNewBlockSize, const int iNewNumBlocks, const bool bNUseSequenceNumber, const bool bPreserve = false );
+
+    void SetUseDoubleSystemFrameSize ( const bool bNDSFSize ) { bUseDoubleSystemFrameSize = bNDSFSize; }
+
+    // selects the estimator of the automatic buffer size
+    void            SetStrategy ( const EJitBufStrategy eNewStrategy );
+    EJitBufStrategy GetStrategy() const { return eStrategy; }
+
+    virtual bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize );
+    virtual bool Get ( CVector<uint8_t>& vecbyData, const int iOutSize );
+
+    // put with the arrival time of the packet for the arrival jitter statistic
+    bool Put ( const CVector<uint8_t>& vecbyData, const int iInSize, const int64_t iArrivalTimeNs );
+
+    int GetAutoSetting() { return pEstimator->GetAutoSetting(); }
+
+    // the error rates are only updated with the error rate strategy
+    void GetErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
+    {
+        ErrorRateEstimator.GetErrorRates ( vecErrRates, dLimit, dMaxUpLimit );
+    }
+
+    void GetArrivalJitterSnapshot ( CArrivalJitterStatistic& Snapshot ) const { ArrivalJitterStatistic.GetSnapshot ( Snapshot ); }
+
+protected:
+    CNetBufErrorRateEstimator       ErrorRateEstimator;
+    CNetBufDelayPercentileEstimator DelayPercentileEstimator;
+    CNetBufSizeEstimator*           pEstimator;
+    EJitBufStrategy                 eStrategy;
+
+    CArrivalJitterStatistic ArrivalJitterStatistic;
+
+    bool bUseDoubleSystemFrameSize;
+};
+
 // Conversion buffer (very simple buffer) --------------------------------------
 // For this very simple buffer no wrap around mechanism is implemented. We
 // assume here, that the applied buffers are an integer fraction of the total
@@ -0,0 +1,231 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "chanaddrtable.h"
+#include <cstring>
+#ifndef _WIN32
+#    include <arpa/inet.h>
+#endif
+
+/* Implementation *************************************************************/
+CChannelAddrKey CChannelAddrKey::FromSockAddr ( const uSockAddr& SockAddr )
+{
+    CChannelAddrKey Key;
+
+    if ( SockAddr.sa.sa_family == AF_INET6 )
+    {
+        memcpy ( Key.Addr, &SockAddr.sa6.sin6_addr, sizeof ( Key.Addr ) );
+        Key.iPort = ntohs ( SockAddr.sa6.sin6_port );
+    }
+    else
+    {
+        Key.Addr[2] = htonl ( 0xFFFF );
+        Key.Addr[3] = SockAddr.sa4.sin_addr.s_addr;
+        Key.iPort   = ntohs ( SockAddr.sa4.sin_port );
+    }
+
+    return Key;
+}
+
+CChannelAddrKey CChannelAddrKey::FromHostAddr ( const CHostAddress& HostAddr )
+{
+    CChannelAddrKey Key;
+
+    if ( HostAddr.InetAddr.protocol() == QAbstractSocket::IPv4Protocol )
+    {
+        Key.Addr[2] = htonl ( 0xFFFF );
+        Key.Addr[3] = htonl ( HostAddr.InetAddr.toIPv4Address() );
+    }
+    else
+    {
+        const Q_IPV6ADDR Addr6 = HostAddr.InetAddr.toIPv6Address();
+
+        memcpy ( Key.Addr, Addr6.c, sizeof ( Key.Addr ) );
+    }
+
+    Key.iPort = HostAddr.iPort;
+
+    return Key;
+}
+
+uint32_t CChannelAddrKey::Hash() const
+{
+    uint32_t iHash = iPort;
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        iHash = ( iHash ^ Addr[i] ) * 0x9E3779B1u;
+        iHash ^= iHash >> 15;
+    }
+
+    return iHash;
+}
+
+void CChannelAddrTable::Init ( const int iMaxNumEntries )
+{
+    uint32_t iSize = 2;
+
+    while ( iSize < 2 * static_cast<uint32_t> ( iMaxNumEntries ) )
+    {
+        iSize <<= 1;
+    }
+
+    pSlots.reset ( new CSlot[iSize] );
+    iMask = iSize - 1;
+}
+
+int CChannelAddrTable::FindSlot ( const CChannelAddrKey& Key, int& iChanID ) const
+{
+    // linear probing until the key or an empty slot is found (the table is
+    // never full since it is at least twice the maximum number of entries)
+    for ( uint32_t i = Key.Hash() & iMask;; i = ( i + 1 ) & iMask )
+    {
+        const CSlot&   Slot         = pSlots[i];
+        const uint32_t iPortAndChan = Slot.iPortAndChan.load ( std::memory_order_relaxed );
+
+        if ( iPortAndChan == 0 )
+        {
+            iChanID = INVALID_INDEX;
+            return static_cast<int> ( i );
+        }
+
+        if ( ( ( iPortAndChan >> 16 ) == Key.iPort ) && ( Slot.Addr[3].load ( std::memory_order_relaxed ) == Key.Addr[3] ) &&
+             ( Slot.Addr[2].load ( std::memory_order_relaxed ) == Key.Addr[2] ) && ( Slot.Addr[1].load ( std::memory_order_relaxed ) == Key.Addr[1] ) &&
+             ( Slot.Addr[0].load ( std::memory_order_relaxed ) == Key.Addr[0] ) )
+        {
+            iChanID = static_cast<int> ( iPortAndChan & 0xFFFF ) - 1;
+            return static_cast<int> ( i );
+        }
+    }
+}
+
+int CChannelAddrTable::Find ( const CChannelAddrKey& Key ) const
+{
+    for ( ;; )
+    {
+        const uint32_t iSeqStart = iSequence.load ( std::memory_order_acquire );
+
+        // an odd sequence number means that a modification is in progress
+        if ( ( iSeqStart & 1 ) == 0 )
+        {
+            int iChanID;
+
+            FindSlot ( Key, iChanID );
+
+            // the slot reads must not be moved behind the sequence check
+            std::atomic_thread_fence ( std::memory_order_acquire );
+
+            if ( iSequence.load ( std::memory_order_relaxed ) == iSeqStart )
+            {
+                return iChanID;
+            }
+        }
+    }
+}
+
+void CChannelAddrTable::BeginWrite()
+{
+    iSequence.store ( iSequence.load ( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+    // the slot writes must not be moved before the sequence update
+    std::atomic_thread_fence ( std::memory_order_release );
+}
+
+void CChannelAddrTable::EndWrite() { iSequence.store ( iSequence.load ( std::memory_order_relaxed ) + 1, std::memory_order_release ); }
+
+void CChannelAddrTable::CopySlot ( const int iDest, const int iSrc )
+{
+    for ( int i = 0; i < 4; i++ )
+    {
+        pSlots[iDest].Addr[i].store ( pSlots[iSrc].Addr[i].load ( std::memory_order_relaxed ), std::memory_order_relaxed );
+    }
+
+    pSlots[iDest].iPortAndChan.store ( pSlots[iSrc].iPortAndChan.load ( std::memory_order_relaxed ), std::memory_order_relaxed );
+}
+
+void CChannelAddrTable::Insert ( const CChannelAddrKey& Key, const int iChanID )
+{
+    int       iChanIDFound;
+    const int iSlot = FindSlot ( Key, iChanIDFound );
+
+    BeginWrite();
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        pSlots[iSlot].Addr[i].store ( Key.Addr[i], std::memory_order_relaxed );
+    }
+
+    pSlots[iSlot].iPortAndChan.store ( ( static_cast<uint32_t> ( Key.iPort ) << 16 ) | static_cast<uint32_t> ( iChanID + 1 ), std::memory_order_relaxed );
+
+    EndWrite();
+}
+
+void CChannelAddrTable::Remove ( const CChannelAddrKey& Key )
+{
+    int iChanIDFound;
+    int iSlot = FindSlot ( Key, iChanIDFound );
+
+    if ( iChanIDFound == INVALID_INDEX )
+    {
+        return;
+    }
+
+    BeginWrite();
+
+    // backward shift deletion: move following entries of the probe sequence
+    // into the hole so that no tombstones are needed
+    uint32_t iHole = static_cast<uint32_t> ( iSlot );
+
+    for ( uint32_t i = ( iHole + 1 ) & iMask;; i = ( i + 1 ) & iMask )
+    {
+        const uint32_t iPortAndChan = pSlots[i].iPortAndChan.load ( std::memory_order_relaxed );
+
+        if ( iPortAndChan == 0 )
+        {
+            break;
+        }
+
+        // the entry can be moved if its home slot is not in the range ( iHole, i ]
+        CChannelAddrKey EntryKey;
+
+        for ( int j = 0; j < 4; j++ )
+        {
+            EntryKey.Addr[j] = pSlots[i].Addr[j].load ( std::memory_order_relaxed );
+        }
+
+        EntryKey.iPort = static_cast<uint16_t> ( iPortAndChan >> 16 );
+
+        const uint32_t iHome = EntryKey.Hash() & iMask;
+
+        if ( ( ( i - iHome ) & iMask ) >= ( ( i - iHole ) & iMask ) )
+        {
+            CopySlot ( static_cast<int> ( iHole ), static_cast<int> ( i ) );
+            iHole = i;
+        }
+    }
+
+    pSlots[iHole].iPortAndChan.store ( 0, std::memory_order_relaxed );
+
+    EndWrite();
+}
@@ -0,0 +1,106 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "global.h"
+#include "util.h"
+#include "socket.h"
+
+/* Classes ********************************************************************/
+// Raw address key of a channel: the IPv6 address (IPv4 addresses are stored as
+// V4MAPPED addresses) and the port number. The key can be created directly from
+// a received native socket address without any Qt type conversions and gives
+// the same result as the key of the corresponding CHostAddress.
+class CChannelAddrKey
+{
+public:
+    CChannelAddrKey() : iPort ( 0 ) { Addr[0] = Addr[1] = Addr[2] = Addr[3] = 0; }
+
+    static CChannelAddrKey FromSockAddr ( const uSockAddr& SockAddr );
+    static CChannelAddrKey FromHostAddr ( const CHostAddress& HostAddr );
+
+    bool operator== ( const CChannelAddrKey& Other ) const
+    {
+        return ( Addr[0] == Other.Addr[0] ) && ( Addr[1] == Other.Addr[1] ) && ( Addr[2] == Other.Addr[2] ) && ( Addr[3] == Other.Addr[3] ) &&
+               ( iPort == Other.iPort );
+    }
+
+    uint32_t Hash() const;
+
+    uint32_t Addr[4]; // in network byte order
+    uint16_t iPort;   // in host byte order
+};
+
+// Open-addressing hash table (linear probing) which maps the address key to the
+// channel ID. Lookups are lock-free and can be done from any thread while the
+// table is modified. Modifications are rare (connect/disconnect) and must be
+// serialized by the caller. They are protected by a sequence counter: a reader
+// repeats its lookup if a modification was in progress or happened meanwhile.
+class CChannelAddrTable
+{
+public:
+    CChannelAddrTable() : iMask ( 0 ), iSequence ( 0 ) {}
+
+    // the table size is at least twice the maximum number of entries (must not
+    // be called while the table is in use)
+    void Init ( const int iMaxNumEntries );
+
+    // returns the channel ID or INVALID_INDEX if the key is not in the table
+    int Find ( const CChannelAddrKey& Key ) const;
+
+    void Insert ( const CChannelAddrKey& Key, const int iChanID );
+    void Remove ( const CChannelAddrKey& Key );
+
+protected:
+    // all slot fields are atomics so that reading a slot which is modified at
+    // the same time is defined (the result is discarded in that case), the
+    // entry is empty if iPortAndChan is zero
+    class CSlot
+    {
+    public:
+        CSlot() : iPortAndChan ( 0 )
+        {
+            for ( int i = 0; i < 4; i++ )
+            {
+                Addr[i].store ( 0, std::memory_order_relaxed );
+            }
+        }
+
+        std::atomic<uint32_t> Addr[4];
+        std::atomic<uint32_t> iPortAndChan; // port << 16 | ( channel ID + 1 )
+    };
+
+    int  FindSlot ( const CChannelAddrKey& Key, int& iChanID ) const;
+    void BeginWrite();
+    void EndWrite();
+    void CopySlot ( const int iDest, const int iSrc );
+
+    std::unique_ptr<CSlot[]> pSlots;
+    uint32_t                 iMask;
+    std::atomic<uint32_t>    iSequence;
+};
@@ -26,8 +26,8 @@
 
 // CChannel implementation *****************************************************
 CChannel::CChannel ( const bool bNIsServer ) :
-    vecfGains ( MAX_NUM_CHANNELS, 1.0f ),
-    vecfPannings ( MAX_NUM_CHANNELS, 0.5f ),
+    iSockAddrLen ( 0 ),
+    pMixerSettings ( &MixerSettings[0] ),
     iCurSockBufNumFrames ( INVALID_INDEX ),
     bDoAutoSockBufSize ( true ),
     bUseSequenceNumber ( false ), // this is important since in the client we reset on Channel.SetEnable ( false )
@@ -37,6 +37,7 @@ CChannel::CChannel ( const bool bNIsServer ) :
     bIsEnabled ( false ),
     bIsServer ( bNIsServer ),
     bIsIdentified ( false ),
+    bIsReleased ( false ),
     iAudioFrameSizeSamples ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES ),
     SignalLevelMeter ( false, 0.5 ) // server mode with mono out and faster smoothing
 {
@@ -97,6 +98,10 @@ qRegisterMetaType<CHostAddress> ( "CHostAddress" );
 
     QObject::connect ( &Protocol, &CProtocol::SplitMessSupported, this, &CChannel::OnSplitMessSupported );
 
+    QObject::connect ( &Protocol, &CProtocol::ReqWindowedMessSupport, this, &CChannel::OnReqWindowedMessSupport );
+
+    QObject::connect ( &Protocol, &CProtocol::WindowedMessSupported, this, &CChannel::OnWindowedMessSupported );
+
     QObject::connect ( &Protocol, &CProtocol::LicenceRequired, this, &CChannel::LicenceRequired );
 
     QObject::connect ( &Protocol, &CProtocol::VersionAndOSReceived, this, &CChannel::OnVersionAndOSReceived );
@@ -270,6 +275,52 @@ bool CChannel::SetSockBufNumFrames ( const int iNewNumFrames, const bool bPreser
     return ReturnValue; // set error flag
 }
 
+void CChannel::SetJitBufStrategy ( const EJitBufStrategy eNewStrategy )
+{
+    // the estimator is used by the socket thread
+    QMutexLocker locker ( &MutexSocketBuf );
+
+    SockBuf.SetStrategy ( eNewStrategy );
+}
+
+CMixerSettings* CChannel::BeginMixerSettingsUpdate()
+{
+    // note that the caller must hold the mutex so that there is only one writer
+    const CMixerSettings* pCurSettings = pMixerSettings;
+    CMixerSettings*       pNewSettings = ( pCurSettings == &MixerSettings[0] ) ? &MixerSettings[1] : &MixerSettings[0];
+
+    // wait for readers which still access the unpublished buffer (the audio
+    // thread only holds the settings for a very short time)
+    while ( pNewSettings->iNumReaders > 0 )
+    {
+        QThread::yieldCurrentThread();
+    }
+
+    std::copy ( pCurSettings->fGains, pCurSettings->fGains + MAX_NUM_CHANNELS, pNewSettings->fGains );
+    std::copy ( pCurSettings->fPannings, pCurSettings->fPannings + MAX_NUM_CHANNELS, pNewSettings->fPannings );
+
+    return pNewSettings;
+}
+
+const CMixerSettings* CChannel::AcquireMixerSettings()
+{
+    for ( ;; )
+    {
+        CMixerSettings* pSettings = pMixerSettings;
+
+        // register as reader, then make sure that the buffer was not replaced
+        // in the meantime (otherwise a writer may be modifying it right now)
+        pSettings->iNumReaders++;
+
+        if ( pSettings == pMixerSettings )
+        {
+            return pSettings;
+        }
+
+        pSettings->iNumReaders--;
+    }
+}
+
 void CChannel::SetGain ( const int iChanID, const float fNewGain )
 {
     QMutexLocker locker ( &Mutex );
@@ -277,28 +328,34 @@ void CChannel::SetGain ( const int iChanID, const float fNewGain )
     // set value (make sure channel ID is in range)
     if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
     {
+        const float fOldGain = pMixerSettings.load()->fGains[iChanID];
+
         // signal mute change
-        if ( ( vecfGains[iChanID] == 0 ) && ( fNewGain > 0 ) )
+        if ( ( fOldGain == 0 ) && ( fNewGain > 0 ) )
         {
             emit MuteStateHasChanged ( iChanID, false );
         }
-        if ( ( vecfGains[iChanID] > 0 ) && ( fNewGain == 0 ) )
+        if ( ( fOldGain > 0 ) && ( fNewGain == 0 ) )
         {
             emit MuteStateHasChanged ( iChanID, true );
         }
 
-        vecfGains[iChanID] = fNewGain;
+        CMixerSettings* pNewSettings = BeginMixerSettingsUpdate();
+        pNewSettings->fGains[iChanID] = fNewGain;
+        pMixerSettings                = pNewSettings; // publish
     }
 }
 
 float CChannel::GetGain ( const int iChanID )
 {
-    QMutexLocker locker ( &Mutex );
-
     // get value (make sure channel ID is in range)
     if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
     {
-        return vecfGains[iChanID];
+        const CMixerSettings* pSettings = AcquireMixerSettings();
+        const float           fGain     = pSettings->fGains[iChanID];
+        ReleaseMixerSettings ( pSettings );
+
+        return fGain;
     }
     else
     {
@@ -313,18 +370,22 @@ void CChannel::SetPan ( const int iChanID, const float fNewPan )
     // set value (make sure channel ID is in range)
     if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
     {
-        vecfPannings[iChanID] = fNewPan;
+        CMixerSettings* pNewSettings     = BeginMixerSettingsUpdate();
+        pNewSettings->fPannings[iChanID] = fNewPan;
+        pMixerSettings                   = pNewSettings; // publish
     }
 }
 
 float CChannel::GetPan ( const int iChanID )
 {
-    QMutexLocker locker ( &Mutex );
-
     // get value (make sure channel ID is in range)
     if ( ( iChanID >= 0 ) && ( iChanID < MAX_NUM_CHANNELS ) )
     {
-        return vecfPannings[iChanID];
+        const CMixerSettings* pSettings = AcquireMixerSettings();
+        const float           fPan      = pSettings->fPannings[iChanID];
+        ReleaseMixerSettings ( pSettings );
+
+        return fPan;
     }
     else
     {
@@ -480,6 +541,13 @@ void CChannel::OnReqSplitMessSupport()
     Protocol.CreateSplitMessSupportedMes();
 }
 
+void CChannel::OnReqWindowedMessSupport()
+{
+    // activate windowed messages in our protocol (client) and return answer message to the server
+    Protocol.SetWindowedMessagesSupported ( true );
+    Protocol.CreateWindowedMessSupportedMes();
+}
+
 CNetworkTransportProps CChannel::GetNetworkTransportPropsFromCurrentSettings()
 {
     // set network flags
@@ -526,7 +594,10 @@ void CChannel::PutProtocolData ( const int iRecCounter, const int iRecID, const
     }
 }
 
-EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData, const int iNumBytes, CHostAddress RecHostAddr )
+EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData,
+                                      const int               iNumBytes,
+                                      const CHostAddress&     RecHostAddr,
+                                      const int64_t           iArrivalTimeNs )
 {
     // init return state
     EPutDataStat eRet = PS_GEN_ERROR;
@@ -537,12 +608,19 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData, const i
     if ( ( bIsServer || ( GetAddress() == RecHostAddr ) ) && IsEnabled() )
     {
         MutexSocketBuf.lock();
+        if ( bIsReleased )
+        {
+            // the server channel has timed out, the packet was received before
+            // the channel was freed by the server
+            eRet = PS_AUDIO_INVALID;
+        }
+        else
         {
             // only process audio if packet has correct size
             if ( iNumBytes == ( iNetwFrameSize * iNetwFrameSizeFact ) )
             {
                 // store new packet in jitter buffer
-                if ( SockBuf.Put ( vecbyData, iNumBytes ) )
+                if ( SockBuf.Put ( vecbyData, iNumBytes, iArrivalTimeNs ) )
                 {
                     eRet = PS_AUDIO_OK;
                 }
@@ -598,6 +676,21 @@ EPutDataStat CChannel::PutAudioData ( const CVector<uint8_t>& vecbyData, const i
     return eRet;
 }
 
+void CChannel::GetArrivalJitterInfo ( CArrivalJitterInfo& Info )
+{
+    // the statistic is updated by the socket thread, only copy it under the
+    // lock and sort the history for the percentiles afterwards
+    CArrivalJitterStatistic Snapshot;
+
+    {
+        QMutexLocker locker ( &MutexSocketBuf );
+
+        SockBuf.GetArrivalJitterSnapshot ( Snapshot );
+    }
+
+    Snapshot.GetInfo ( Info );
+}
+
 EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData, const int iNumBytes )
 {
     EGetDataStat eGetStatus;
@@ -622,6 +715,10 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData, const int iNumByte
                 eGetStatus  = GS_CHAN_NOW_DISCONNECTED;
                 iConTimeOut = 0; // make sure we do not have negative values
 
+                // the server frees the channel, a late packet of the client
+                // must not connect it again
+                bIsReleased = bIsServer;
+
                 // reset network transport properties
                 ResetNetworkTransportProperties();
             }
@@ -660,6 +757,24 @@ EGetDataStat CChannel::GetData ( CVector<uint8_t>& vecbyData, const int iNumByte
     return eGetStatus;
 }
 
+void CChannel::SetAddress ( const CHostAddress NAddr, const CHighPrioSocket* pSocket )
+{
+    // the server may send on the channel at the same time
+    MutexConvBuf.lock();
+    {
+        InetAddr     = NAddr;
+        iSockAddrLen = pSocket->GetSockAddr ( NAddr, SockAddr );
+    }
+    MutexConvBuf.unlock();
+
+    // a released server channel accepts audio again when it is allocated
+    MutexSocketBuf.lock();
+    {
+        bIsReleased = false;
+    }
+    MutexSocketBuf.unlock();
+}
+
 void CChannel::PrepAndSendPacket ( CHighPrioSocket* pSocket, const CVector<uint8_t>& vecbyNPacket, const int iNPacketLen )
 {
     // From v3.8.0 onwards, a server will not send audio to a client until that client has sent channel info.
@@ -676,7 +791,23 @@ void CChannel::PrepAndSendPacket ( CHighPrioSocket* pSocket, const CVector<uint8
     // the sequence number wraps automatically)
     if ( ConvBuf.Put ( vecbyNPacket, iNPacketLen, iSendSequenceNumber++ ) )
     {
-        pSocket->SendPacket ( ConvBuf.GetAll(), GetAddress() );
+        pSocket->SendPacket ( ConvBuf.GetAll(), SockAddr, iSockAddrLen );
+    }
+}
+
+void CChannel::PrepAndSendPacket ( CSendBatch& SendBatch, const CVector<uint8_t>& vecbyNPacket, const int iNPacketLen )
+{
+    // same as above but the packet is only added to the send batch
+    if ( bIsServer && !bIsIdentified )
+    {
+        return;
+    }
+
+    QMutexLocker locker ( &MutexConvBuf );
+
+    if ( ConvBuf.Put ( vecbyNPacket, iNPacketLen, iSendSequenceNumber++ ) )
+    {
+        SendBatch.Add ( ConvBuf.GetAll(), SockAddr, iSockAddrLen );
     }
 }
 
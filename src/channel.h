@@ -27,6 +27,7 @@
 #include <QThread>
 #include <QDateTime>
 #include <QFile>
+#include <atomic>
 #if QT_VERSION >= QT_VERSION_CHECK( 5, 6, 0 )
 #    include <QVersionNumber>
 #endif
@@ -59,6 +60,25 @@ enum EPutDataStat
 };
 
 /* Classes ********************************************************************/
+// Gain and pan settings of a channel for all other channels. The settings
+// are double buffered so that the real-time audio thread can read them
+// without a lock, see CChannel::AcquireMixerSettings().
+class CMixerSettings
+{
+public:
+    CMixerSettings() : iNumReaders ( 0 )
+    {
+        std::fill ( fGains, fGains + MAX_NUM_CHANNELS, 1.0f );
+        std::fill ( fPannings, fPannings + MAX_NUM_CHANNELS, 0.5f );
+    }
+
+    float fGains[MAX_NUM_CHANNELS];
+    float fPannings[MAX_NUM_CHANNELS];
+
+    // number of readers which currently access this buffer
+    mutable std::atomic<int> iNumReaders;
+};
+
 class CChannel : public QObject
 {
     Q_OBJECT
@@ -70,11 +90,15 @@ public:
 
     void PutProtocolData ( const int iRecCounter, const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr );
 
-    EPutDataStat PutAudioData ( const CVector<uint8_t>& vecbyData, const int iNumBytes, CHostAddress RecHostAddr );
+    EPutDataStat PutAudioData ( const CVector<uint8_t>& vecbyData,
+                                const int               iNumBytes,
+                                const CHostAddress&     RecHostAddr,
+                                const int64_t           iArrivalTimeNs );
 
     EGetDataStat GetData ( CVector<uint8_t>& vecbyData, const int iNumBytes );
 
     void PrepAndSendPacket ( CHighPrioSocket* pSocket, const CVector<uint8_t>& vecbyNPacket, const int iNPacketLen );
+    void PrepAndSendPacket ( CSendBatch& SendBatch, const CVector<uint8_t>& vecbyNPacket, const int iNPacketLen );
 
     void ResetTimeOutCounter() { iConTimeOut = iConTimeOutStartVal; }
     bool IsConnected() const { return iConTimeOut > 0; }
@@ -83,7 +107,7 @@ public:
     void SetEnable ( const bool bNEnStat );
     bool IsEnabled() { return bIsEnabled; }
 
-    void                SetAddress ( const CHostAddress NAddr ) { InetAddr = NAddr; }
+    void                SetAddress ( const CHostAddress NAddr, const CHighPrioSocket* pSocket );
     const CHostAddress& GetAddress() const { return InetAddr; }
 
     void ResetInfo()
@@ -108,6 +132,11 @@ public:
     void  SetPan ( const int iChanID, const float fNewPan );
     float GetPan ( const int iChanID );
 
+    // lock-free access to the published gain/pan settings (each call of
+    // AcquireMixerSettings() must be followed by ReleaseMixerSettings())
+    const CMixerSettings* AcquireMixerSettings();
+    void                  ReleaseMixerSettings ( const CMixerSettings* pSettings ) { pSettings->iNumReaders--; }
+
     void SetRemoteChanGain ( const int iId, const float fGain ) { Protocol.CreateChanGainMes ( iId, fGain ); }
 
     void SetRemoteChanPan ( const int iId, const float fPan ) { Protocol.CreateChanPanMes ( iId, fPan ); }
@@ -129,14 +158,20 @@ public:
 
     bool GetDoAutoSockBufSize() const { return bDoAutoSockBufSize; }
 
-    int GetNetwFrameSizeFact() const { return iNetwFrameSizeFact; }
-    int GetCeltNumCodedBytes() const { return iCeltNumCodedBytes; }
+    // selects the estimator of the automatic jitter buffer size
+    void SetJitBufStrategy ( const EJitBufStrategy eNewStrategy );
+
+    int  GetNetwFrameSizeFact() const { return iNetwFrameSizeFact; }
+    int  GetCeltNumCodedBytes() const { return iCeltNumCodedBytes; }
+    bool GetUseSequenceNumber() const { return bUseSequenceNumber; }
 
     void GetBufErrorRates ( CVector<double>& vecErrRates, double& dLimit, double& dMaxUpLimit )
     {
         SockBuf.GetErrorRates ( vecErrRates, dLimit, dMaxUpLimit );
     }
 
+    void GetArrivalJitterInfo ( CArrivalJitterInfo& Info );
+
     EAudComprType GetAudioCompressionType() { return eAudioCompressionType; }
     int           GetNumAudioChannels() const { return iNumAudioChannels; }
 
@@ -151,6 +186,7 @@ public:
     void CreateClientIDMes ( const int iChanID ) { Protocol.CreateClientIDMes ( iChanID ); }
     void CreateReqNetwTranspPropsMes() { Protocol.CreateReqNetwTranspPropsMes(); }
     void CreateReqSplitMessSupportMes() { Protocol.CreateReqSplitMessSupportMes(); }
+    void CreateReqWindowedMessSupportMes() { Protocol.CreateReqWindowedMessSupportMes(); }
     void CreateReqJitBufMes() { Protocol.CreateReqJitBufMes(); }
     void CreateReqConnClientsList() { Protocol.CreateReqConnClientsList(); }
     void CreateChatTextMes ( const QString& strChatText ) { Protocol.CreateChatTextMes ( strChatText ); }
@@ -163,6 +199,8 @@ void CreateReqChannelLevelListMes() { Protocol.CreateReqChannelLevelListMes(); }
 
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo ) { Protocol.CreateConClientListMes ( vecChanInfo ); }
 
+    void CreateConClientListMes ( const CVector<uint8_t>& vecConClientListData ) { Protocol.CreateConClientListMes ( vecConClientListData ); }
+
     void CreateRecorderStateMes ( const ERecorderState eRecorderState ) { Protocol.CreateRecorderStateMes ( eRecorderState ); }
 
     CNetworkTransportProps GetNetworkTransportPropsFromCurrentSettings();
@@ -185,15 +223,21 @@ protected:
         bUseSequenceNumber    = false;
     }
 
-    // connection parameters
+    // connection parameters (the native address of the socket is converted
+    // once when the address is set, a length of zero means not sendable)
     CHostAddress InetAddr;
+    uSockAddr    SockAddr;
+    int          iSockAddrLen;
 
     // channel info
     CChannelCoreInfo ChannelInfo;
 
-    // mixer and effect settings
-    CVector<float> vecfGains;
-    CVector<float> vecfPannings;
+    // mixer settings: the published buffer is only read, all modifications
+    // are done on the other buffer which is published afterwards
+    CMixerSettings* BeginMixerSettingsUpdate();
+
+    CMixerSettings               MixerSettings[2];
+    std::atomic<CMixerSettings*> pMixerSettings;
 
     // network jitter-buffer
     CNetBufWithStats SockBuf;
@@ -216,6 +260,7 @@ protected:
     bool bIsEnabled;
     bool bIsServer;
     bool bIsIdentified;
+    bool bIsReleased; // server: timed out, no audio is accepted until the address is set again
 
     int iNetwFrameSizeFact;
     int iNetwFrameSize;
@@ -241,6 +286,8 @@ public slots:
     void OnReqNetTranspProps();
     void OnReqSplitMessSupport();
     void OnSplitMessSupported() { Protocol.SetSplitMessageSupported ( true ); }
+    void OnReqWindowedMessSupport();
+    void OnWindowedMessSupported() { Protocol.SetWindowedMessagesSupported ( true ); }
 
     void OnVersionAndOSReceived ( COSUtil::EOpSystemType eOSType, QString strVersion );
 
@@ -250,12 +297,12 @@ public slots:
         Protocol.ParseMessageBody ( vecbyMesBodyData, iRecCounter, iRecID );
     }
 
-    void OnProtocolMessageReceived ( int iRecCounter, int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr )
+    void OnProtocolMessageReceived ( const int iRecCounter, const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr )
     {
         PutProtocolData ( iRecCounter, iRecID, vecbyMesBodyData, RecHostAddr );
     }
 
-    void OnProtocolCLMessageReceived ( int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr )
+    void OnProtocolCLMessageReceived ( const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr )
     {
         emit DetectedCLMessage ( vecbyMesBodyData, iRecID, RecHostAddr );
     }
@@ -25,14 +25,15 @@
 #include "client.h"
 
 /* Implementation *************************************************************/
-CClient::CClient ( const quint16  iPortNumber,
-                   const quint16  iQosNumber,
-                   const QString& strConnOnStartupAddress,
-                   const QString& strMIDISetup,
-                   const bool     bNoAutoJackConnect,
-                   const QString& strNClientName,
-                   const bool     bNEnableIPv6,
-                   const bool     bNMuteMeInPersonalMix ) :
+CClient::CClient ( const quint16         iPortNumber,
+                   const quint16         iQosNumber,
+                   const QString&        strConnOnStartupAddress,
+                   const QString&        strMIDISetup,
+                   const bool            bNoAutoJackConnect,
+                   const QString&        strNClientName,
+                   const bool            bNEnableIPv6,
+                   const bool            bNMuteMeInPersonalMix,
+                   const EJitBufStrategy eNJitBufStrategy ) :
     ChannelInfo(),
     strClientName ( strNClientName ),
     Channel ( false ), /* we need a client channel -> "false" */
@@ -105,6 +106,9 @@ CClient::CClient ( const quint16  iPortNumber,
     opus_custom_encoder_ctl ( OpusEncoderMono, OPUS_SET_COMPLEXITY ( 1 ) );
     opus_custom_encoder_ctl ( OpusEncoderStereo, OPUS_SET_COMPLEXITY ( 1 ) );
 
+    // select how the size of our jitter buffer is estimated in auto mode
+    Channel.SetJitBufStrategy ( eNJitBufStrategy );
+
     // Connections -------------------------------------------------------------
     // connections for the protocol mechanism
     QObject::connect ( &Channel, &CChannel::MessReadyForSending, this, &CClient::OnSendProtMessage );
@@ -441,7 +445,7 @@ bool CClient::SetServerAddr ( QString strNAddr )
     if ( NetworkUtil().ParseNetworkAddress ( strNAddr, HostAddress, bEnableIPv6 ) )
     {
         // apply address to the channel
-        Channel.SetAddress ( HostAddress );
+        Channel.SetAddress ( HostAddress, &Socket );
 
         return true;
     }
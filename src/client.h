@@ -108,14 +108,15 @@ class CClient : public QObject
     Q_OBJECT
 
 public:
-    CClient ( const quint16  iPortNumber,
-              const quint16  iQosNumber,
-              const QString& strConnOnStartupAddress,
-              const QString& strMIDISetup,
-              const bool     bNoAutoJackConnect,
-              const QString& strNClientName,
-              const bool     bNEnableIPv6,
-              const bool     bNMuteMeInPersonalMix );
+    CClient ( const quint16         iPortNumber,
+              const quint16         iQosNumber,
+              const QString&        strConnOnStartupAddress,
+              const QString&        strMIDISetup,
+              const bool            bNoAutoJackConnect,
+              const QString&        strNClientName,
+              const bool            bNEnableIPv6,
+              const bool            bNMuteMeInPersonalMix,
+              const EJitBufStrategy eNJitBufStrategy );
 
     virtual ~CClient();
 
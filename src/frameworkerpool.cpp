@@ -0,0 +1,233 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "frameworkerpool.h"
+#include <chrono>
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#    include <emmintrin.h>
+#endif
+#if defined( __linux__ )
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+/* Implementation *************************************************************/
+// hint to the CPU that we are in a spin loop
+static inline void CpuRelax()
+{
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+    _mm_pause();
+#elif defined( __aarch64__ ) || defined( __arm__ )
+    __asm__ __volatile__ ( "yield" );
+#endif
+}
+
+thread_local int CFrameWorkerPool::iThreadIdx = 0;
+
+CFrameWorkerPool::CFrameWorkerPool ( const int iNumWorkers, const bool bPinWorkers, const int iSpinTimeUs ) :
+    iSpinTimeUs ( iSpinTimeUs ),
+    iPhase ( PackPhase ( 0, 0, 0 ) ),
+    iNumPendingTasks ( 0 ),
+    pTaskFunc ( nullptr ),
+    pTaskArg ( nullptr ),
+    iNumSleeping ( 0 ),
+    bStop ( false )
+{
+#if defined( __linux__ )
+    // only use the cores the process may run on (e.g. restricted by taskset or
+    // a cgroup) so that multiple servers on one host can be given separate cores
+    cpu_set_t CpuSet;
+    CPU_ZERO ( &CpuSet );
+
+    if ( bPinWorkers && ( sched_getaffinity ( 0, sizeof ( CpuSet ), &CpuSet ) == 0 ) )
+    {
+        for ( int iCore = 0; iCore < CPU_SETSIZE; iCore++ )
+        {
+            if ( CPU_ISSET ( iCore, &CpuSet ) )
+            {
+                vecPinCores.push_back ( iCore );
+            }
+        }
+
+        // pinning makes no sense if there is only one core
+        if ( vecPinCores.size() < 2 )
+        {
+            vecPinCores.clear();
+        }
+    }
+#else
+    (void) bPinWorkers;
+#endif
+
+    for ( int i = 0; i < iNumWorkers; i++ )
+    {
+        vecWorkers.emplace_back ( &CFrameWorkerPool::WorkerLoop, this, i );
+    }
+}
+
+CFrameWorkerPool::~CFrameWorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock ( MutexSleep );
+        bStop = true;
+    }
+    CondSleep.notify_all();
+
+    for ( std::thread& worker : vecWorkers )
+    {
+        worker.join();
+    }
+}
+
+void CFrameWorkerPool::Run ( const int iNumTasks, TTaskFunc pNewTaskFunc, void* pNewTaskArg )
+{
+    if ( iNumTasks <= 0 )
+    {
+        return;
+    }
+
+    // start the new phase (the task function is published with the phase word)
+    const uint32_t iGeneration = GetGeneration ( iPhase ) + 1;
+
+    pTaskFunc        = pNewTaskFunc;
+    pTaskArg         = pNewTaskArg;
+    iNumPendingTasks = iNumTasks;
+    iPhase           = PackPhase ( iGeneration, iNumTasks, 0 );
+
+    // wake up sleeping workers (taking the mutex makes sure that a worker which
+    // is just about to sleep either sees the new phase or gets the notification)
+    if ( iNumSleeping > 0 )
+    {
+        {
+            std::unique_lock<std::mutex> lock ( MutexSleep );
+        }
+        CondSleep.notify_all();
+    }
+
+    // the calling thread works on the tasks, too
+    ExecuteTasks ( iGeneration );
+
+    // phase barrier: wait for the tasks which are still processed by the workers
+    while ( iNumPendingTasks > 0 )
+    {
+        CpuRelax();
+    }
+}
+
+void CFrameWorkerPool::ExecuteTasks ( const uint32_t iGeneration )
+{
+    uint64_t iCurPhase = iPhase;
+
+    for ( ;; )
+    {
+        const int iNumTasks = static_cast<int> ( ( iCurPhase >> 16 ) & 0xFFFF );
+        const int iTask     = static_cast<int> ( iCurPhase & 0xFFFF );
+
+        // stop if the phase is over or all tasks are claimed
+        if ( ( GetGeneration ( iCurPhase ) != iGeneration ) || ( iTask >= iNumTasks ) )
+        {
+            return;
+        }
+
+        // claim the next task (on failure iCurPhase is updated and we retry)
+        if ( iPhase.compare_exchange_weak ( iCurPhase, iCurPhase + 1 ) )
+        {
+            // since our task is not done yet, the phase cannot be over and the
+            // task function is the one of this phase
+            pTaskFunc ( pTaskArg, iTask );
+
+            iNumPendingTasks--;
+
+            iCurPhase = iPhase;
+        }
+    }
+}
+
+bool CFrameWorkerPool::WaitForPhase ( uint32_t& iSeenGeneration )
+{
+    // spin for a bounded time
+    if ( iSpinTimeUs > 0 )
+    {
+        const auto tSpinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds ( iSpinTimeUs );
+        int        iCnt     = 0;
+
+        while ( GetGeneration ( iPhase ) == iSeenGeneration )
+        {
+            if ( bStop )
+            {
+                return false;
+            }
+
+            CpuRelax();
+
+            // checking the time is much more expensive than the spin itself
+            if ( ( ++iCnt & 63 ) == 0 && std::chrono::steady_clock::now() > tSpinEnd )
+            {
+                break;
+            }
+        }
+    }
+
+    // sleep until the next phase starts
+    if ( GetGeneration ( iPhase ) == iSeenGeneration )
+    {
+        std::unique_lock<std::mutex> lock ( MutexSleep );
+
+        iNumSleeping++;
+        CondSleep.wait ( lock, [this, iSeenGeneration] { return bStop || ( GetGeneration ( iPhase ) != iSeenGeneration ); } );
+        iNumSleeping--;
+    }
+
+    if ( bStop )
+    {
+        return false;
+    }
+
+    iSeenGeneration = GetGeneration ( iPhase );
+    return true;
+}
+
+void CFrameWorkerPool::WorkerLoop ( const int iWorkerIdx )
+{
+    iThreadIdx = iWorkerIdx + 1;
+
+#if defined( __linux__ )
+    // pin the worker to a core to keep its caches warm (the first core is left
+    // for the thread which calls Run())
+    if ( !vecPinCores.empty() )
+    {
+        cpu_set_t CpuSet;
+        CPU_ZERO ( &CpuSet );
+        CPU_SET ( vecPinCores[( iWorkerIdx + 1 ) % vecPinCores.size()], &CpuSet );
+        pthread_setaffinity_np ( pthread_self(), sizeof ( CpuSet ), &CpuSet );
+    }
+#endif
+
+    uint32_t iSeenGeneration = GetGeneration ( iPhase );
+
+    while ( WaitForPhase ( iSeenGeneration ) )
+    {
+        ExecuteTasks ( iSeenGeneration );
+    }
+}
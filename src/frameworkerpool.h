@@ -0,0 +1,110 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/* Definitions ****************************************************************/
+// default time a worker spins for the next phase before it goes to sleep
+// (the decode and the mix phase of one frame follow each other closely)
+#define FRAME_WORKER_DEF_SPIN_TIME_US 200
+
+/* Classes ********************************************************************/
+// Real-time executor for the per-frame processing of the server. In contrast
+// to CThreadPool there is no task queue, no std::function and no future: a
+// phase consists of a number of tasks which are claimed by the persistent
+// workers and the calling thread through one atomic counter, and Run()
+// returns as soon as all tasks of the phase are done (phase barrier). Idle
+// workers spin for a bounded time before they sleep on a condition variable.
+class CFrameWorkerPool
+{
+public:
+    // iNumWorkers is the number of additional threads (the calling thread of
+    // Run() works as well), with bPinWorkers each worker is pinned to one of the
+    // cores the process may run on (Linux only), iSpinTimeUs = 0 disables spinning
+    CFrameWorkerPool ( const int iNumWorkers, const bool bPinWorkers = false, const int iSpinTimeUs = FRAME_WORKER_DEF_SPIN_TIME_US );
+    ~CFrameWorkerPool();
+
+    // runs Func ( iTask ) for iTask = 0 .. iNumTasks - 1 and returns when all
+    // tasks are done (must not be called concurrently from different threads)
+    template<class F>
+    void Run ( const int iNumTasks, F& Func )
+    {
+        Run ( iNumTasks, &CallTask<F>, &Func );
+    }
+
+    int GetNumThreads() const { return static_cast<int> ( vecWorkers.size() ) + 1; }
+
+    // index of the calling thread in 0 .. GetNumThreads() - 1 (the thread which
+    // calls Run() has index 0), can be used for per-thread resources of the tasks
+    static int GetThreadIdx() { return iThreadIdx; }
+
+protected:
+    typedef void ( *TTaskFunc ) ( void* pArg, const int iTask );
+
+    template<class F>
+    static void CallTask ( void* pArg, const int iTask )
+    {
+        ( *static_cast<F*> ( pArg ) ) ( iTask );
+    }
+
+    // the phase state is packed in one atomic word so that a task can only be
+    // claimed for the phase it belongs to: generation | number of tasks | next task
+    static uint64_t PackPhase ( const uint32_t iGeneration, const int iNumTasks, const int iNextTask )
+    {
+        return ( static_cast<uint64_t> ( iGeneration ) << 32 ) | ( static_cast<uint64_t> ( iNumTasks & 0xFFFF ) << 16 ) |
+               static_cast<uint64_t> ( iNextTask & 0xFFFF );
+    }
+
+    static uint32_t GetGeneration ( const uint64_t iPhase ) { return static_cast<uint32_t> ( iPhase >> 32 ); }
+
+    void Run ( const int iNumTasks, TTaskFunc pNewTaskFunc, void* pNewTaskArg );
+    void ExecuteTasks ( const uint32_t iGeneration );
+    bool WaitForPhase ( uint32_t& iSeenGeneration );
+    void WorkerLoop ( const int iWorkerIdx );
+
+    static thread_local int iThreadIdx;
+
+    std::vector<std::thread> vecWorkers;
+    std::vector<int>         vecPinCores; // cores of the workers, empty if not pinned
+    const int                iSpinTimeUs;
+
+    // current phase
+    std::atomic<uint64_t> iPhase;
+    std::atomic<int>      iNumPendingTasks;
+    TTaskFunc             pTaskFunc;
+    void*                 pTaskArg;
+
+    // sleeping workers
+    std::mutex              MutexSleep;
+    std::condition_variable CondSleep;
+    std::atomic<int>        iNumSleeping;
+    std::atomic<bool>       bStop;
+};
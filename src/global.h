@@ -318,6 +318,7 @@ typedef unsigned char      uint8_t;
 /* Pseudo enum definitions -------------------------------------------------- */
 // definition for custom event
 #define MS_PACKET_RECEIVED 0
+#define MS_DEFERRED_EVENTS 1
 
 /* Classes ********************************************************************/
 class CGenErr
@@ -0,0 +1,359 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "iouring.h"
+
+#ifdef HAVE_IO_URING
+#    include <cerrno>
+#    include <cstring>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+/* Implementation *************************************************************/
+CIoUring::CIoUring() :
+    iRingFd ( -1 ),
+    pSqRingMem ( nullptr ),
+    iSqRingSize ( 0 ),
+    pSqes ( nullptr ),
+    iSqesSize ( 0 ),
+    pSqHead ( nullptr ),
+    pSqTail ( nullptr ),
+    pSqArray ( nullptr ),
+    iSqMask ( 0 ),
+    iSqEntries ( 0 ),
+    iSqLocalTail ( 0 ),
+    pCqRingMem ( nullptr ),
+    iCqRingSize ( 0 ),
+    pCqes ( nullptr ),
+    pCqHead ( nullptr ),
+    pCqTail ( nullptr ),
+    iCqMask ( 0 ),
+    pBufRing ( nullptr ),
+    pBufRingTail ( nullptr ),
+    iBufRingSize ( 0 ),
+    pBufMem ( nullptr ),
+    iBufMemSize ( 0 ),
+    iBufSize ( 0 ),
+    iBufMask ( 0 ),
+    iBufGroupID ( 0 ),
+    bBufRingRegistered ( false )
+{}
+
+CIoUring::~CIoUring() { Close(); }
+
+void CIoUring::Close()
+{
+    if ( bBufRingRegistered )
+    {
+        struct io_uring_buf_reg Reg;
+        memset ( &Reg, 0, sizeof ( Reg ) );
+        Reg.bgid = iBufGroupID;
+
+        syscall ( __NR_io_uring_register, iRingFd, IORING_UNREGISTER_PBUF_RING, &Reg, 1 );
+        bBufRingRegistered = false;
+    }
+
+    // closing the ring cancels all pending operations
+    if ( iRingFd >= 0 )
+    {
+        close ( iRingFd );
+        iRingFd = -1;
+    }
+
+    if ( pBufRing != nullptr )
+    {
+        munmap ( pBufRing, iBufRingSize );
+        pBufRing = nullptr;
+    }
+
+    if ( pBufMem != nullptr )
+    {
+        munmap ( pBufMem, iBufMemSize );
+        pBufMem = nullptr;
+    }
+
+    if ( pSqes != nullptr )
+    {
+        munmap ( pSqes, iSqesSize );
+        pSqes = nullptr;
+    }
+
+    if ( ( pCqRingMem != nullptr ) && ( pCqRingMem != pSqRingMem ) )
+    {
+        munmap ( pCqRingMem, iCqRingSize );
+    }
+    pCqRingMem = nullptr;
+
+    if ( pSqRingMem != nullptr )
+    {
+        munmap ( pSqRingMem, iSqRingSize );
+        pSqRingMem = nullptr;
+    }
+}
+
+bool CIoUring::Init ( const unsigned iNumEntries )
+{
+    struct io_uring_params Params;
+    memset ( &Params, 0, sizeof ( Params ) );
+
+    iRingFd = static_cast<int> ( syscall ( __NR_io_uring_setup, iNumEntries, &Params ) );
+
+    if ( iRingFd < 0 )
+    {
+        return false;
+    }
+
+    // the wait with timeout needs the extended enter arguments (kernel 5.11)
+    if ( ( Params.features & IORING_FEAT_EXT_ARG ) == 0 )
+    {
+        Close();
+        return false;
+    }
+
+    // map the submission and completion queue rings (which share one mapping
+    // if the kernel supports it)
+    iSqRingSize = Params.sq_off.array + Params.sq_entries * sizeof ( unsigned );
+    iCqRingSize = Params.cq_off.cqes + Params.cq_entries * sizeof ( struct io_uring_cqe );
+
+    if ( Params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        if ( iCqRingSize > iSqRingSize )
+        {
+            iSqRingSize = iCqRingSize;
+        }
+        iCqRingSize = iSqRingSize;
+    }
+
+    pSqRingMem = mmap ( nullptr, iSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iRingFd, IORING_OFF_SQ_RING );
+
+    if ( pSqRingMem == MAP_FAILED )
+    {
+        pSqRingMem = nullptr;
+        Close();
+        return false;
+    }
+
+    if ( Params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        pCqRingMem = pSqRingMem;
+    }
+    else
+    {
+        pCqRingMem = mmap ( nullptr, iCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iRingFd, IORING_OFF_CQ_RING );
+
+        if ( pCqRingMem == MAP_FAILED )
+        {
+            pCqRingMem = nullptr;
+            Close();
+            return false;
+        }
+    }
+
+    iSqesSize = Params.sq_entries * sizeof ( struct io_uring_sqe );
+    pSqes     = static_cast<struct io_uring_sqe*> (
+        mmap ( nullptr, iSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, iRingFd, IORING_OFF_SQES ) );
+
+    if ( pSqes == MAP_FAILED )
+    {
+        pSqes = nullptr;
+        Close();
+        return false;
+    }
+
+    uint8_t* pSq = static_cast<uint8_t*> ( pSqRingMem );
+    uint8_t* pCq = static_cast<uint8_t*> ( pCqRingMem );
+
+    pSqHead      = reinterpret_cast<unsigned*> ( pSq + Params.sq_off.head );
+    pSqTail      = reinterpret_cast<unsigned*> ( pSq + Params.sq_off.tail );
+    pSqArray     = reinterpret_cast<unsigned*> ( pSq + Params.sq_off.array );
+    iSqMask      = *reinterpret_cast<unsigned*> ( pSq + Params.sq_off.ring_mask );
+    iSqEntries   = Params.sq_entries;
+    iSqLocalTail = *pSqTail;
+
+    pCqHead = reinterpret_cast<unsigned*> ( pCq + Params.cq_off.head );
+    pCqTail = reinterpret_cast<unsigned*> ( pCq + Params.cq_off.tail );
+    pCqes   = reinterpret_cast<struct io_uring_cqe*> ( pCq + Params.cq_off.cqes );
+    iCqMask = *reinterpret_cast<unsigned*> ( pCq + Params.cq_off.ring_mask );
+
+    return true;
+}
+
+bool CIoUring::InitBufRing ( const uint16_t iNewBufGroupID, const unsigned iNumBufs, const unsigned iNewBufSize )
+{
+    iBufGroupID = iNewBufGroupID;
+    iBufSize    = iNewBufSize;
+    iBufMask    = iNumBufs - 1;
+
+    // the ring entries and the buffers must be page aligned
+    iBufRingSize = iNumBufs * sizeof ( struct io_uring_buf );
+    pBufRing     = static_cast<struct io_uring_buf*> ( mmap ( nullptr, iBufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+
+    if ( pBufRing == MAP_FAILED )
+    {
+        pBufRing = nullptr;
+        return false;
+    }
+
+    pBufRingTail = &pBufRing[0].resv;
+
+    iBufMemSize = static_cast<size_t> ( iNumBufs ) * iBufSize;
+    pBufMem     = static_cast<uint8_t*> ( mmap ( nullptr, iBufMemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+
+    if ( pBufMem == MAP_FAILED )
+    {
+        pBufMem = nullptr;
+        return false;
+    }
+
+    // register the buffer ring (kernel 5.19)
+    struct io_uring_buf_reg Reg;
+    memset ( &Reg, 0, sizeof ( Reg ) );
+    Reg.ring_addr    = reinterpret_cast<uint64_t> ( pBufRing );
+    Reg.ring_entries = iNumBufs;
+    Reg.bgid         = iBufGroupID;
+
+    if ( syscall ( __NR_io_uring_register, iRingFd, IORING_REGISTER_PBUF_RING, &Reg, 1 ) < 0 )
+    {
+        return false;
+    }
+
+    bBufRingRegistered = true;
+
+    // provide all buffers to the kernel
+    for ( unsigned i = 0; i < iNumBufs; i++ )
+    {
+        struct io_uring_buf& Buf = pBufRing[i];
+
+        Buf.addr = reinterpret_cast<uint64_t> ( pBufMem + static_cast<size_t> ( i ) * iBufSize );
+        Buf.len  = iBufSize;
+        Buf.bid  = static_cast<uint16_t> ( i );
+    }
+
+    __atomic_store_n ( pBufRingTail, static_cast<uint16_t> ( iNumBufs ), __ATOMIC_RELEASE );
+
+    return true;
+}
+
+void CIoUring::RecycleBuf ( const uint16_t iBufID )
+{
+    const uint16_t       iTail = *pBufRingTail;
+    struct io_uring_buf& Buf   = pBufRing[iTail & iBufMask];
+
+    Buf.addr = reinterpret_cast<uint64_t> ( pBufMem + static_cast<size_t> ( iBufID ) * iBufSize );
+    Buf.len  = iBufSize;
+    Buf.bid  = iBufID;
+
+    __atomic_store_n ( pBufRingTail, static_cast<uint16_t> ( iTail + 1 ), __ATOMIC_RELEASE );
+}
+
+struct io_uring_sqe* CIoUring::GetSqe()
+{
+    const unsigned iHead = __atomic_load_n ( pSqHead, __ATOMIC_ACQUIRE );
+
+    if ( iSqLocalTail - iHead >= iSqEntries )
+    {
+        return nullptr;
+    }
+
+    const unsigned       iIdx = iSqLocalTail & iSqMask;
+    struct io_uring_sqe* pSqe = &pSqes[iIdx];
+
+    memset ( pSqe, 0, sizeof ( struct io_uring_sqe ) );
+    pSqArray[iIdx] = iIdx;
+    iSqLocalTail++;
+
+    return pSqe;
+}
+
+int CIoUring::SubmitAndWait ( const unsigned iMinComplete, const int iTimeoutMs )
+{
+    // publish the new submission queue entries
+    const unsigned iToSubmit = iSqLocalTail - *pSqTail;
+
+    __atomic_store_n ( pSqTail, iSqLocalTail, __ATOMIC_RELEASE );
+
+    unsigned                      iFlags = ( iMinComplete > 0 ) ? IORING_ENTER_GETEVENTS : 0;
+    struct io_uring_getevents_arg Arg;
+    struct __kernel_timespec      Timeout;
+    void*                         pArg    = nullptr;
+    size_t                        iArgLen = 0;
+
+    if ( ( iMinComplete > 0 ) && ( iTimeoutMs >= 0 ) )
+    {
+        Timeout.tv_sec  = iTimeoutMs / 1000;
+        Timeout.tv_nsec = static_cast<long long> ( iTimeoutMs % 1000 ) * 1000000;
+
+        memset ( &Arg, 0, sizeof ( Arg ) );
+        Arg.ts = reinterpret_cast<uint64_t> ( &Timeout );
+
+        iFlags |= IORING_ENTER_EXT_ARG;
+        pArg    = &Arg;
+        iArgLen = sizeof ( Arg );
+    }
+
+    for ( ;; )
+    {
+        const int iRet = static_cast<int> ( syscall ( __NR_io_uring_enter, iRingFd, iToSubmit, iMinComplete, iFlags, pArg, iArgLen ) );
+
+        if ( iRet >= 0 )
+        {
+            return iRet;
+        }
+
+        // retry if interrupted by a signal
+        if ( errno != EINTR )
+        {
+            return -errno;
+        }
+    }
+}
+
+unsigned CIoUring::DiscardSqes()
+{
+    // the kernel only consumes entries in io_uring_enter (no SQ polling thread)
+    // so the tail can safely be moved back to the head
+    const unsigned iHead = __atomic_load_n ( pSqHead, __ATOMIC_ACQUIRE );
+    const unsigned iNum  = iSqLocalTail - iHead;
+
+    iSqLocalTail = iHead;
+    __atomic_store_n ( pSqTail, iHead, __ATOMIC_RELEASE );
+
+    return iNum;
+}
+
+struct io_uring_cqe* CIoUring::PeekCqe()
+{
+    const unsigned iHead = *pCqHead;
+
+    if ( iHead == __atomic_load_n ( pCqTail, __ATOMIC_ACQUIRE ) )
+    {
+        return nullptr;
+    }
+
+    return &pCqes[iHead & iCqMask];
+}
+
+void CIoUring::SeenCqe() { __atomic_store_n ( pCqHead, *pCqHead + 1, __ATOMIC_RELEASE ); }
+#endif
@@ -0,0 +1,119 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+// the io_uring backend is only available on Linux if the kernel headers
+// support all used features (the kernel support is checked at runtime)
+#if defined( __linux__ ) && defined( __has_include )
+#    if __has_include( <linux/io_uring.h>)
+#        include <linux/io_uring.h>
+#        if defined( IORING_RECV_MULTISHOT ) && defined( IORING_ENTER_EXT_ARG )
+#            define HAVE_IO_URING
+#        endif
+#    endif
+#endif
+
+#ifdef HAVE_IO_URING
+#    include <cstdint>
+#    include <cstddef>
+
+/* Classes ********************************************************************/
+// Minimal io_uring wrapper based on the raw system calls (no liburing needed).
+// It supports one provided buffer ring for multishot receive operations. An
+// object must only be used by one thread at a time.
+class CIoUring
+{
+public:
+    CIoUring();
+    virtual ~CIoUring();
+
+    // creates the ring with at least iNumEntries submission queue entries,
+    // returns false if io_uring is not supported by the kernel
+    bool Init ( const unsigned iNumEntries );
+
+    // registers a provided buffer ring with iNumBufs (power of two) buffers of
+    // iBufSize bytes which can be selected by receive operations
+    bool InitBufRing ( const uint16_t iNewBufGroupID, const unsigned iNumBufs, const unsigned iNewBufSize );
+
+    // returns a cleared submission queue entry or nullptr if the queue is full
+    struct io_uring_sqe* GetSqe();
+
+    // submits the queued entries and waits for at least iMinComplete
+    // completions (a negative timeout waits without limit), returns the
+    // negative error code on failure (-ETIME on timeout)
+    int SubmitAndWait ( const unsigned iMinComplete, const int iTimeoutMs = -1 );
+
+    // drops the queued entries which were not consumed by the kernel yet (e.g.
+    // after a failed submission), returns the number of dropped entries
+    unsigned DiscardSqes();
+
+    // returns the next completion or nullptr, the completion must be released
+    // with SeenCqe() when it was processed
+    struct io_uring_cqe* PeekCqe();
+    void                 SeenCqe();
+
+    uint16_t       GetBufGroupID() const { return iBufGroupID; }
+    const uint8_t* GetBuf ( const uint16_t iBufID ) const { return pBufMem + static_cast<size_t> ( iBufID ) * iBufSize; }
+    void           RecycleBuf ( const uint16_t iBufID );
+
+protected:
+    void Close();
+
+    int iRingFd;
+
+    // submission queue
+    void*                pSqRingMem;
+    size_t               iSqRingSize;
+    struct io_uring_sqe* pSqes;
+    size_t               iSqesSize;
+    unsigned*            pSqHead;
+    unsigned*            pSqTail;
+    unsigned*            pSqArray;
+    unsigned             iSqMask;
+    unsigned             iSqEntries;
+    unsigned             iSqLocalTail;
+
+    // completion queue
+    void*                pCqRingMem;
+    size_t               iCqRingSize;
+    struct io_uring_cqe* pCqes;
+    unsigned*            pCqHead;
+    unsigned*            pCqTail;
+    unsigned             iCqMask;
+
+    // provided buffer ring (note that the ring tail overlays the reserved
+    // field of the first entry, the io_uring_buf_ring structure cannot be
+    // used since its flexible array has a different offset in C++)
+    struct io_uring_buf* pBufRing;
+    uint16_t*            pBufRingTail;
+    size_t               iBufRingSize;
+    uint8_t*             pBufMem;
+    size_t               iBufMemSize;
+    unsigned             iBufSize;
+    unsigned             iBufMask;
+    uint16_t             iBufGroupID;
+    bool                 bBufRingRegistered;
+};
+#endif
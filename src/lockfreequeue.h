@@ -0,0 +1,147 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/* Classes ********************************************************************/
+// Bounded lock-free queue for multiple producers and consumers. Each cell has
+// a sequence number which tells producers and consumers if the cell is ready
+// for them, so that pushing and popping only needs one compare-and-swap on the
+// enqueue or dequeue position and never allocates memory. If the queue is
+// full, Push() fails instead of blocking.
+template<class T>
+class CLockFreeQueue
+{
+public:
+    CLockFreeQueue() : iMask ( 0 ), iEnqueuePos ( 0 ), iDequeuePos ( 0 ) {}
+
+    // the size is rounded up to a power of two (must not be called while the
+    // queue is in use)
+    void Init ( const int iNewSize )
+    {
+        size_t iSize = 2;
+
+        while ( iSize < static_cast<size_t> ( iNewSize ) )
+        {
+            iSize <<= 1;
+        }
+
+        pCells.reset ( new CCell[iSize] );
+
+        for ( size_t i = 0; i < iSize; i++ )
+        {
+            pCells[i].iSequence.store ( i, std::memory_order_relaxed );
+        }
+
+        iMask = iSize - 1;
+        iEnqueuePos.store ( 0, std::memory_order_relaxed );
+        iDequeuePos.store ( 0, std::memory_order_relaxed );
+    }
+
+    bool Push ( const T& Item )
+    {
+        size_t iPos = iEnqueuePos.load ( std::memory_order_relaxed );
+
+        for ( ;; )
+        {
+            CCell&         Cell  = pCells[iPos & iMask];
+            const intptr_t iDiff = static_cast<intptr_t> ( Cell.iSequence.load ( std::memory_order_acquire ) ) - static_cast<intptr_t> ( iPos );
+
+            if ( iDiff == 0 )
+            {
+                // the cell is free, try to claim it
+                if ( iEnqueuePos.compare_exchange_weak ( iPos, iPos + 1, std::memory_order_relaxed ) )
+                {
+                    Cell.Item = Item;
+                    Cell.iSequence.store ( iPos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( iDiff < 0 )
+            {
+                // the cell still holds an item of the last round: queue is full
+                return false;
+            }
+            else
+            {
+                // another producer was faster
+                iPos = iEnqueuePos.load ( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    bool Pop ( T& Item )
+    {
+        size_t iPos = iDequeuePos.load ( std::memory_order_relaxed );
+
+        for ( ;; )
+        {
+            CCell&         Cell  = pCells[iPos & iMask];
+            const intptr_t iDiff = static_cast<intptr_t> ( Cell.iSequence.load ( std::memory_order_acquire ) ) - static_cast<intptr_t> ( iPos + 1 );
+
+            if ( iDiff == 0 )
+            {
+                // the cell holds an item, try to claim it
+                if ( iDequeuePos.compare_exchange_weak ( iPos, iPos + 1, std::memory_order_relaxed ) )
+                {
+                    Item = Cell.Item;
+                    Cell.iSequence.store ( iPos + iMask + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( iDiff < 0 )
+            {
+                // queue is empty
+                return false;
+            }
+            else
+            {
+                // another consumer was faster
+                iPos = iDequeuePos.load ( std::memory_order_relaxed );
+            }
+        }
+    }
+
+protected:
+    class CCell
+    {
+    public:
+        std::atomic<size_t> iSequence;
+        T                   Item;
+    };
+
+    std::unique_ptr<CCell[]> pCells;
+    size_t                   iMask;
+
+    // the positions are on separate cache lines since they are written by
+    // different threads
+    alignas ( 64 ) std::atomic<size_t> iEnqueuePos;
+    alignas ( 64 ) std::atomic<size_t> iDequeuePos;
+};
@@ -35,6 +35,7 @@
 #    endif
 #endif
 #include "settings.h"
+#include "packettrace.h"
 #ifndef SERVER_ONLY
 #    include "testbench.h"
 #endif
@@ -79,41 +80,49 @@ int main ( int argc, char** argv )
 #else
     bool bIsClient = true;
 #endif
-    bool         bUseGUI                     = true;
-    bool         bStartMinimized             = false;
-    bool         bShowComplRegConnList       = false;
-    bool         bDisconnectAllClientsOnQuit = false;
-    bool         bUseDoubleSystemFrameSize   = true; // default is 128 samples frame size
-    bool         bUseMultithreading          = false;
-    bool         bShowAnalyzerConsole        = false;
-    bool         bMuteStream                 = false;
-    bool         bMuteMeInPersonalMix        = false;
-    bool         bDisableRecording           = false;
-    bool         bDelayPan                   = false;
-    bool         bNoAutoJackConnect          = false;
-    bool         bUseTranslation             = true;
-    bool         bCustomPortNumberGiven      = false;
-    bool         bEnableIPv6                 = false;
-    int          iNumServerChannels          = DEFAULT_USED_NUM_CHANNELS;
-    quint16      iPortNumber                 = DEFAULT_PORT_NUMBER;
-    int          iJsonRpcPortNumber          = INVALID_PORT;
-    quint16      iQosNumber                  = DEFAULT_QOS_NUMBER;
-    ELicenceType eLicenceType                = LT_NO_LICENCE;
-    QString      strMIDISetup                = "";
-    QString      strConnOnStartupAddress     = "";
-    QString      strIniFileName              = "";
-    QString      strHTMLStatusFileName       = "";
-    QString      strLoggingFileName          = "";
-    QString      strRecordingDirName         = "";
-    QString      strDirectoryServer          = "";
-    QString      strServerListFileName       = "";
-    QString      strServerInfo               = "";
-    QString      strServerPublicIP           = "";
-    QString      strServerBindIP             = "";
-    QString      strServerListFilter         = "";
-    QString      strWelcomeMessage           = "";
-    QString      strClientName               = "";
-    QString      strJsonRpcSecretFileName    = "";
+    bool            bUseGUI                     = true;
+    bool            bStartMinimized             = false;
+    bool            bShowComplRegConnList       = false;
+    bool            bDisconnectAllClientsOnQuit = false;
+    bool            bUseDoubleSystemFrameSize   = true; // default is 128 samples frame size
+    bool            bUseMultithreading          = false;
+    bool            bUsePipelining              = false;
+    bool            bPinWorkers                 = false;
+    bool            bUseTimerThread             = false;
+    bool            bShowAnalyzerConsole        = false;
+    bool            bMuteStream                 = false;
+    bool            bMuteMeInPersonalMix        = false;
+    bool            bDisableRecording           = false;
+    bool            bDelayPan                   = false;
+    bool            bNoAutoJackConnect          = false;
+    bool            bUseTranslation             = true;
+    bool            bCustomPortNumberGiven      = false;
+    bool            bEnableIPv6                 = false;
+    int             iNumServerChannels          = DEFAULT_USED_NUM_CHANNELS;
+    int             iNumRecvThreads             = 1;
+    bool            bUseIoUring                 = false;
+    quint16         iPortNumber                 = DEFAULT_PORT_NUMBER;
+    int             iJsonRpcPortNumber          = INVALID_PORT;
+    quint16         iQosNumber                  = DEFAULT_QOS_NUMBER;
+    ELicenceType    eLicenceType                = LT_NO_LICENCE;
+    EJitBufStrategy eJitBufStrategy             = JS_ERROR_RATE;
+    QString         strMIDISetup                = "";
+    QString         strConnOnStartupAddress     = "";
+    QString         strIniFileName              = "";
+    QString         strHTMLStatusFileName       = "";
+    QString         strLoggingFileName          = "";
+    QString         strPacketTraceFileName      = "";
+    QString         strReplayTraceFileName      = "";
+    QString         strRecordingDirName         = "";
+    QString         strDirectoryServer          = "";
+    QString         strServerListFileName       = "";
+    QString         strServerInfo               = "";
+    QString         strServerPublicIP           = "";
+    QString         strServerBindIP             = "";
+    QString         strServerListFilter         = "";
+    QString         strWelcomeMessage           = "";
+    QString         strClientName               = "";
+    QString         strJsonRpcSecretFileName    = "";
 
 #if !defined( HEADLESS ) && defined( _WIN32 )
     if ( AttachConsole ( ATTACH_PARENT_PROCESS ) )
@@ -146,6 +155,18 @@ int main ( int argc, char** argv )
             exit ( 0 );
         }
 
+        // Replay a packet trace -----------------------------------------------
+        if ( GetStringArgument ( argc,
+                                 argv,
+                                 i,
+                                 "--replaytrace", // no short form
+                                 "--replaytrace",
+                                 strArgument ) )
+        {
+            strReplayTraceFileName = strArgument;
+            continue;
+        }
+
         // Common options:
 
         // Initialization file -------------------------------------------------
@@ -221,6 +242,34 @@ int main ( int argc, char** argv )
             continue;
         }
 
+        // Jitter buffer size strategy -----------------------------------------
+        if ( GetStringArgument ( argc,
+                                 argv,
+                                 i,
+                                 "--jitbufstrategy", // no short form
+                                 "--jitbufstrategy",
+                                 strArgument ) )
+        {
+            if ( strArgument == "errorrate" )
+            {
+                eJitBufStrategy = JS_ERROR_RATE;
+            }
+            else if ( strArgument == "percentile" )
+            {
+                eJitBufStrategy = JS_DELAY_PERCENTILE;
+            }
+            else
+            {
+                qCritical() << qUtf8Printable ( QString ( "%1: Invalid jitter buffer strategy '%2' -- use 'errorrate' or 'percentile'" )
+                                                    .arg ( argv[0] )
+                                                    .arg ( strArgument ) );
+                exit ( 1 );
+            }
+            qInfo() << qUtf8Printable ( QString ( "- jitter buffer strategy: %1" ).arg ( strArgument ) );
+            CommandLineOptions << "--jitbufstrategy";
+            continue;
+        }
+
         // Server only:
 
         // Disconnect all clients on quit --------------------------------------
@@ -417,6 +466,85 @@ int main ( int argc, char** argv )
             continue;
         }
 
+        // Use pipelining ------------------------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--pipelining", // no short form
+                               "--pipelining" ) )
+        {
+            bUsePipelining = true;
+            qInfo() << "- using pipelining";
+            CommandLineOptions << "--pipelining";
+            ServerOnlyOptions << "--pipelining";
+            continue;
+        }
+
+        // Pin the frame workers to cores --------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--pinworkers", // no short form
+                               "--pinworkers" ) )
+        {
+            bPinWorkers = true;
+            qInfo() << "- pinning the frame workers to cores";
+            CommandLineOptions << "--pinworkers";
+            ServerOnlyOptions << "--pinworkers";
+            continue;
+        }
+
+        // Process the audio frames in the timer thread ------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--timerthread", // no short form
+                               "--timerthread" ) )
+        {
+            bUseTimerThread = true;
+            qInfo() << "- processing the audio frames in the timer thread";
+            CommandLineOptions << "--timerthread";
+            ServerOnlyOptions << "--timerthread";
+            continue;
+        }
+
+        // Number of server receive threads ------------------------------------
+        if ( GetNumericArgument ( argc, argv, i, "--recvthreads", "--recvthreads", 1, MAX_NUM_RECV_THREADS, rDbleArgument ) )
+        {
+            iNumRecvThreads = static_cast<int> ( rDbleArgument );
+
+            qInfo() << qUtf8Printable ( QString ( "- number of receive threads: %1" ).arg ( iNumRecvThreads ) );
+
+            CommandLineOptions << "--recvthreads";
+            ServerOnlyOptions << "--recvthreads";
+            continue;
+        }
+
+        // Use the io_uring network backend ------------------------------------
+        if ( GetFlagArgument ( argv,
+                               i,
+                               "--iouring", // no short form
+                               "--iouring" ) )
+        {
+            bUseIoUring = true;
+            qInfo() << "- using the io_uring network backend";
+            CommandLineOptions << "--iouring";
+            ServerOnlyOptions << "--iouring";
+            continue;
+        }
+
+        // Packet trace file ---------------------------------------------------
+        if ( GetStringArgument ( argc,
+                                 argv,
+                                 i,
+                                 "--tracefile", // no short form
+                                 "--tracefile",
+                                 strArgument ) )
+        {
+            strPacketTraceFileName = strArgument;
+            qInfo() << qUtf8Printable ( QString ( "- packet trace file: %1" ).arg ( strPacketTraceFileName ) );
+            CommandLineOptions << "--tracefile";
+            ServerOnlyOptions << "--tracefile";
+            continue;
+        }
+
         // Maximum number of channels ------------------------------------------
         if ( GetNumericArgument ( argc, argv, i, "-u", "--numchannels", 1, MAX_NUM_CHANNELS, rDbleArgument ) )
         {
@@ -567,6 +695,13 @@ int main ( int argc, char** argv )
 #endif
     }
 
+    // Replay a packet trace (after parsing so that the jitter buffer options apply)
+    if ( !strReplayTraceFileName.isEmpty() )
+    {
+        CPacketTraceReplay PacketTraceReplay ( eJitBufStrategy );
+        exit ( PacketTraceReplay.Replay ( strReplayTraceFileName ) ? 0 : 1 );
+    }
+
     // Dependencies ------------------------------------------------------------
 #ifdef HEADLESS
     if ( bUseGUI )
@@ -869,7 +1004,8 @@ int main ( int argc, char** argv )
                              bNoAutoJackConnect,
                              strClientName,
                              bEnableIPv6,
-                             bMuteMeInPersonalMix );
+                             bMuteMeInPersonalMix,
+                             eJitBufStrategy );
 
             // load settings from init-file (command line options override)
             CClientSettings Settings ( &Client, strIniFileName );
@@ -921,6 +1057,7 @@ int main ( int argc, char** argv )
             // actual server object
             CServer Server ( iNumServerChannels,
                              strLoggingFileName,
+                             strPacketTraceFileName,
                              strServerBindIP,
                              iPortNumber,
                              iQosNumber,
@@ -935,10 +1072,16 @@ int main ( int argc, char** argv )
                              bDisconnectAllClientsOnQuit,
                              bUseDoubleSystemFrameSize,
                              bUseMultithreading,
+                             bPinWorkers,
+                             bUsePipelining,
+                             bUseTimerThread,
+                             iNumRecvThreads,
+                             bUseIoUring,
                              bDisableRecording,
                              bDelayPan,
                              bEnableIPv6,
-                             eLicenceType );
+                             eLicenceType,
+                             eJitBufStrategy );
 
             if ( pRpcServer )
             {
@@ -1022,6 +1165,9 @@ QString UsageArguments ( char** argv )
            "\n"
            "  -h, -?, --help        display this help text and exit\n"
            "  -v, --version         display version information and exit\n"
+           "      --replaytrace     replay a packet trace file (see --tracefile)\n"
+           "                        through the jitter buffer, print the results\n"
+           "                        and exit\n"
            "\n"
            "Common options:\n"
            "  -i, --inifile         initialization file name\n"
@@ -1038,6 +1184,9 @@ QString UsageArguments ( char** argv )
            "                        (see the Jamulus website to enable QoS on Windows)\n"
            "  -t, --notranslation   disable translation (use English language)\n"
            "  -6, --enableipv6      enable IPv6 addressing (IPv4 is always enabled)\n"
+           "      --jitbufstrategy  how the auto jitter buffer size is estimated:\n"
+           "                        'errorrate' (default) or 'percentile' (delay\n"
+           "                        percentile of the packet arrivals)\n"
            "\n"
            "Server only:\n"
            "  -d, --discononquit    disconnect all Clients on quit\n"
@@ -1056,10 +1205,21 @@ QString UsageArguments ( char** argv )
            "                        registering with a server list hosted\n"
            "                        behind the same NAT\n"
            "  -P, --delaypan        start with delay panning enabled\n"
+           "      --pipelining      decode the next frame while mixing the current\n"
+           "                        one (adds one frame of latency, needs -T)\n"
+           "      --pinworkers      pin each frame worker thread to one of the\n"
+           "                        cores of the process (Linux only, needs -T)\n"
+           "      --recvthreads     number of sockets/threads receiving on the\n"
+           "                        server port (Linux only)\n"
+           "      --iouring         use io_uring for the network I/O (Linux only)\n"
            "  -R, --recording       sets directory to contain recorded jams\n"
            "      --norecord        disables recording (when enabled by default by -R)\n"
            "  -s, --server          start Server\n"
            "      --serverbindip    IP address the Server will bind to (rather than all)\n"
+           "      --timerthread     process the audio frames directly in the\n"
+           "                        high precision timer thread (not on Windows)\n"
+           "      --tracefile       record the arrival times of the audio packets\n"
+           "                        of all Clients in a packet trace file\n"
            "  -T, --multithreading  use multithreading to make better use of\n"
            "                        multi-core CPUs and support more Clients\n"
            "  -u, --numchannels     maximum number of channels\n"
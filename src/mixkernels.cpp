@@ -0,0 +1,481 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#include "mixkernels.h"
+#include "global.h"
+
+// Note that the SSE2 implementation is available on all x86_64 CPUs without
+// any special compiler flags. The AVX2 implementation is compiled with a
+// function specific target attribute and is only used if the CPU supports it.
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#    define MK_USE_SSE2
+#    include <emmintrin.h>
+#    if defined( __GNUC__ ) || defined( __clang__ )
+#        define MK_USE_AVX2
+#        define MK_TARGET_AVX2 __attribute__ ( ( target ( "avx2" ) ) )
+#        include <immintrin.h>
+#    elif defined( _MSC_VER )
+#        define MK_USE_AVX2
+#        define MK_TARGET_AVX2
+#        include <immintrin.h>
+#        include <intrin.h>
+#    endif
+#endif
+
+// NEON is part of the base instruction set on 64 bit ARM (on 32 bit ARM the
+// NEON unit flushes denormals to zero which would break bit-exactness)
+#if defined( __aarch64__ ) || defined( _M_ARM64 )
+#    define MK_USE_NEON
+#    include <arm_neon.h>
+#endif
+
+/* Scalar reference implementation ********************************************/
+// Note: these have to match the arithmetic of the original mixing loops in
+// CServer::MixEncodeTransmitData() exactly.
+static void MixMonoToMonoScalar ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        pfOut[i] += psIn[i] * fGain;
+    }
+}
+
+static void MixStereoToMonoScalar ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        pfOut[i] += fGain * ( static_cast<float> ( psIn[k] ) + psIn[k + 1] ) / 2;
+    }
+}
+
+static void MixMonoToStereoScalar ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    for ( int i = 0, k = 0; i < iNumSamples; i++, k += 2 )
+    {
+        pfOut[k] += psIn[i] * fGainL;
+        pfOut[k + 1] += psIn[i] * fGainR;
+    }
+}
+
+static void MixStereoToStereoScalar ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    for ( int k = 0; k < ( 2 * iNumSamples ); k += 2 )
+    {
+        pfOut[k] += psIn[k] * fGainL;
+        pfOut[k + 1] += psIn[k + 1] * fGainR;
+    }
+}
+
+static inline int16_t Float2ShortScalar ( const float fInput )
+{
+    // same as Float2Short() in util.h
+    if ( fInput < _MINSHORT )
+    {
+        return _MINSHORT;
+    }
+
+    if ( fInput > _MAXSHORT )
+    {
+        return _MAXSHORT;
+    }
+
+    return static_cast<int16_t> ( fInput );
+}
+
+static void Float2ShortBlockScalar ( int16_t* psOut, const float* pfIn, const int iNumSamples )
+{
+    for ( int i = 0; i < iNumSamples; i++ )
+    {
+        psOut[i] = Float2ShortScalar ( pfIn[i] );
+    }
+}
+
+/* SSE2 implementation ********************************************************/
+#ifdef MK_USE_SSE2
+// sign extend the lower/upper four 16 bit values to float
+static inline __m128 LoInt16ToFloatSSE2 ( const __m128i x ) { return _mm_cvtepi32_ps ( _mm_srai_epi32 ( _mm_unpacklo_epi16 ( x, x ), 16 ) ); }
+static inline __m128 HiInt16ToFloatSSE2 ( const __m128i x ) { return _mm_cvtepi32_ps ( _mm_srai_epi32 ( _mm_unpackhi_epi16 ( x, x ), 16 ) ); }
+
+static void MixMonoToMonoSSE2 ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const __m128 vGain = _mm_set1_ps ( fGain );
+    int          i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i vIn = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[i] ) );
+
+        _mm_storeu_ps ( &pfOut[i], _mm_add_ps ( _mm_loadu_ps ( &pfOut[i] ), _mm_mul_ps ( LoInt16ToFloatSSE2 ( vIn ), vGain ) ) );
+        _mm_storeu_ps ( &pfOut[i + 4], _mm_add_ps ( _mm_loadu_ps ( &pfOut[i + 4] ), _mm_mul_ps ( HiInt16ToFloatSSE2 ( vIn ), vGain ) ) );
+    }
+
+    MixMonoToMonoScalar ( &pfOut[i], &psIn[i], fGain, iNumSamples - i );
+}
+
+static void MixStereoToMonoSSE2 ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const __m128  vGain = _mm_set1_ps ( fGain );
+    const __m128  vHalf = _mm_set1_ps ( 0.5f );
+    const __m128i vOnes = _mm_set1_epi16 ( 1 );
+    int           i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        // the sum of the left and right sample is exact in both int32 and float,
+        // the division by two is exact as a multiplication by 0.5
+        const __m128i vIn  = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[2 * i] ) );
+        const __m128  vSum = _mm_cvtepi32_ps ( _mm_madd_epi16 ( vIn, vOnes ) );
+
+        _mm_storeu_ps ( &pfOut[i], _mm_add_ps ( _mm_loadu_ps ( &pfOut[i] ), _mm_mul_ps ( _mm_mul_ps ( vGain, vSum ), vHalf ) ) );
+    }
+
+    MixStereoToMonoScalar ( &pfOut[i], &psIn[2 * i], fGain, iNumSamples - i );
+}
+
+static void MixMonoToStereoSSE2 ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const __m128 vGain = _mm_setr_ps ( fGainL, fGainR, fGainL, fGainR );
+    int          i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i vIn   = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[i] ) );
+        const __m128i vDupL = _mm_unpacklo_epi16 ( vIn, vIn ); // s0 s0 s1 s1 s2 s2 s3 s3
+        const __m128i vDupH = _mm_unpackhi_epi16 ( vIn, vIn ); // s4 s4 s5 s5 s6 s6 s7 s7
+        float*        pfCur = &pfOut[2 * i];
+
+        _mm_storeu_ps ( &pfCur[0], _mm_add_ps ( _mm_loadu_ps ( &pfCur[0] ), _mm_mul_ps ( LoInt16ToFloatSSE2 ( vDupL ), vGain ) ) );
+        _mm_storeu_ps ( &pfCur[4], _mm_add_ps ( _mm_loadu_ps ( &pfCur[4] ), _mm_mul_ps ( HiInt16ToFloatSSE2 ( vDupL ), vGain ) ) );
+        _mm_storeu_ps ( &pfCur[8], _mm_add_ps ( _mm_loadu_ps ( &pfCur[8] ), _mm_mul_ps ( LoInt16ToFloatSSE2 ( vDupH ), vGain ) ) );
+        _mm_storeu_ps ( &pfCur[12], _mm_add_ps ( _mm_loadu_ps ( &pfCur[12] ), _mm_mul_ps ( HiInt16ToFloatSSE2 ( vDupH ), vGain ) ) );
+    }
+
+    MixMonoToStereoScalar ( &pfOut[2 * i], &psIn[i], fGainL, fGainR, iNumSamples - i );
+}
+
+static void MixStereoToStereoSSE2 ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const __m128 vGain = _mm_setr_ps ( fGainL, fGainR, fGainL, fGainR );
+    int          i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const __m128i vIn   = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[2 * i] ) );
+        float*        pfCur = &pfOut[2 * i];
+
+        _mm_storeu_ps ( &pfCur[0], _mm_add_ps ( _mm_loadu_ps ( &pfCur[0] ), _mm_mul_ps ( LoInt16ToFloatSSE2 ( vIn ), vGain ) ) );
+        _mm_storeu_ps ( &pfCur[4], _mm_add_ps ( _mm_loadu_ps ( &pfCur[4] ), _mm_mul_ps ( HiInt16ToFloatSSE2 ( vIn ), vGain ) ) );
+    }
+
+    MixStereoToStereoScalar ( &pfOut[2 * i], &psIn[2 * i], fGainL, fGainR, iNumSamples - i );
+}
+
+static void Float2ShortBlockSSE2 ( int16_t* psOut, const float* pfIn, const int iNumSamples )
+{
+    const __m128 vMin = _mm_set1_ps ( static_cast<float> ( _MINSHORT ) );
+    const __m128 vMax = _mm_set1_ps ( static_cast<float> ( _MAXSHORT ) );
+    int          i    = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        // clip, then truncate towards zero (the saturation of the pack is a no-op)
+        const __m128i vLo = _mm_cvttps_epi32 ( _mm_min_ps ( _mm_max_ps ( _mm_loadu_ps ( &pfIn[i] ), vMin ), vMax ) );
+        const __m128i vHi = _mm_cvttps_epi32 ( _mm_min_ps ( _mm_max_ps ( _mm_loadu_ps ( &pfIn[i + 4] ), vMin ), vMax ) );
+
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[i] ), _mm_packs_epi32 ( vLo, vHi ) );
+    }
+
+    Float2ShortBlockScalar ( &psOut[i], &pfIn[i], iNumSamples - i );
+}
+#endif
+
+/* AVX2 implementation ********************************************************/
+#ifdef MK_USE_AVX2
+MK_TARGET_AVX2 static inline __m256 Int16ToFloatAVX2 ( const __m128i x ) { return _mm256_cvtepi32_ps ( _mm256_cvtepi16_epi32 ( x ) ); }
+
+MK_TARGET_AVX2 static void MixMonoToMonoAVX2 ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const __m256 vGain = _mm256_set1_ps ( fGain );
+    int          i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m256 vIn = Int16ToFloatAVX2 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[i] ) ) );
+
+        _mm256_storeu_ps ( &pfOut[i], _mm256_add_ps ( _mm256_loadu_ps ( &pfOut[i] ), _mm256_mul_ps ( vIn, vGain ) ) );
+    }
+
+    MixMonoToMonoScalar ( &pfOut[i], &psIn[i], fGain, iNumSamples - i );
+}
+
+MK_TARGET_AVX2 static void MixStereoToMonoAVX2 ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const __m256  vGain = _mm256_set1_ps ( fGain );
+    const __m256  vHalf = _mm256_set1_ps ( 0.5f );
+    const __m256i vOnes = _mm256_set1_epi16 ( 1 );
+    int           i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m256i vIn  = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( &psIn[2 * i] ) );
+        const __m256  vSum = _mm256_cvtepi32_ps ( _mm256_madd_epi16 ( vIn, vOnes ) );
+
+        _mm256_storeu_ps ( &pfOut[i], _mm256_add_ps ( _mm256_loadu_ps ( &pfOut[i] ), _mm256_mul_ps ( _mm256_mul_ps ( vGain, vSum ), vHalf ) ) );
+    }
+
+    MixStereoToMonoScalar ( &pfOut[i], &psIn[2 * i], fGain, iNumSamples - i );
+}
+
+MK_TARGET_AVX2 static void MixMonoToStereoAVX2 ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const __m256 vGain = _mm256_setr_ps ( fGainL, fGainR, fGainL, fGainR, fGainL, fGainR, fGainL, fGainR );
+    int          i     = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m128i vIn   = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[i] ) );
+        float*        pfCur = &pfOut[2 * i];
+
+        _mm256_storeu_ps ( &pfCur[0],
+                           _mm256_add_ps ( _mm256_loadu_ps ( &pfCur[0] ), _mm256_mul_ps ( Int16ToFloatAVX2 ( _mm_unpacklo_epi16 ( vIn, vIn ) ), vGain ) ) );
+        _mm256_storeu_ps ( &pfCur[8],
+                           _mm256_add_ps ( _mm256_loadu_ps ( &pfCur[8] ), _mm256_mul_ps ( Int16ToFloatAVX2 ( _mm_unpackhi_epi16 ( vIn, vIn ) ), vGain ) ) );
+    }
+
+    MixMonoToStereoScalar ( &pfOut[2 * i], &psIn[i], fGainL, fGainR, iNumSamples - i );
+}
+
+MK_TARGET_AVX2 static void MixStereoToStereoAVX2 ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const __m256 vGain = _mm256_setr_ps ( fGainL, fGainR, fGainL, fGainR, fGainL, fGainR, fGainL, fGainR );
+    int          i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const __m256 vIn   = Int16ToFloatAVX2 ( _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( &psIn[2 * i] ) ) );
+        float*       pfCur = &pfOut[2 * i];
+
+        _mm256_storeu_ps ( pfCur, _mm256_add_ps ( _mm256_loadu_ps ( pfCur ), _mm256_mul_ps ( vIn, vGain ) ) );
+    }
+
+    MixStereoToStereoScalar ( &pfOut[2 * i], &psIn[2 * i], fGainL, fGainR, iNumSamples - i );
+}
+
+MK_TARGET_AVX2 static void Float2ShortBlockAVX2 ( int16_t* psOut, const float* pfIn, const int iNumSamples )
+{
+    const __m256 vMin = _mm256_set1_ps ( static_cast<float> ( _MINSHORT ) );
+    const __m256 vMax = _mm256_set1_ps ( static_cast<float> ( _MAXSHORT ) );
+    int          i    = 0;
+
+    for ( ; i + 8 <= iNumSamples; i += 8 )
+    {
+        const __m256i vInt = _mm256_cvttps_epi32 ( _mm256_min_ps ( _mm256_max_ps ( _mm256_loadu_ps ( &pfIn[i] ), vMin ), vMax ) );
+
+        _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( &psOut[i] ),
+                           _mm_packs_epi32 ( _mm256_castsi256_si128 ( vInt ), _mm256_extracti128_si256 ( vInt, 1 ) ) );
+    }
+
+    Float2ShortBlockScalar ( &psOut[i], &pfIn[i], iNumSamples - i );
+}
+
+static bool CpuSupportsAVX2()
+{
+#    if defined( _MSC_VER ) && !defined( __clang__ )
+    int iCpuInfo[4];
+
+    __cpuid ( iCpuInfo, 0 );
+
+    if ( iCpuInfo[0] < 7 )
+    {
+        return false;
+    }
+
+    // OSXSAVE and AVX, then check that the OS saves the YMM registers
+    __cpuid ( iCpuInfo, 1 );
+
+    if ( ( ( iCpuInfo[2] >> 27 ) & 1 ) == 0 || ( ( iCpuInfo[2] >> 28 ) & 1 ) == 0 || ( _xgetbv ( 0 ) & 6 ) != 6 )
+    {
+        return false;
+    }
+
+    __cpuidex ( iCpuInfo, 7, 0 );
+
+    return ( ( iCpuInfo[1] >> 5 ) & 1 ) != 0;
+#    else
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports ( "avx2" );
+#    endif
+}
+#endif
+
+/* NEON implementation ********************************************************/
+#ifdef MK_USE_NEON
+// Note: we use separate multiply and add instructions (and not vmlaq/vfmaq) so
+// that the result matches the scalar implementation
+static void MixMonoToMonoNEON ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const float32x4_t vGain = vdupq_n_f32 ( fGain );
+    int               i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const float32x4_t vIn = vcvtq_f32_s32 ( vmovl_s16 ( vld1_s16 ( &psIn[i] ) ) );
+
+        vst1q_f32 ( &pfOut[i], vaddq_f32 ( vld1q_f32 ( &pfOut[i] ), vmulq_f32 ( vIn, vGain ) ) );
+    }
+
+    MixMonoToMonoScalar ( &pfOut[i], &psIn[i], fGain, iNumSamples - i );
+}
+
+static void MixStereoToMonoNEON ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples )
+{
+    const float32x4_t vGain = vdupq_n_f32 ( fGain );
+    const float32x4_t vHalf = vdupq_n_f32 ( 0.5f );
+    int               i     = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const float32x4_t vSum = vcvtq_f32_s32 ( vpaddlq_s16 ( vld1q_s16 ( &psIn[2 * i] ) ) );
+
+        vst1q_f32 ( &pfOut[i], vaddq_f32 ( vld1q_f32 ( &pfOut[i] ), vmulq_f32 ( vmulq_f32 ( vGain, vSum ), vHalf ) ) );
+    }
+
+    MixStereoToMonoScalar ( &pfOut[i], &psIn[2 * i], fGain, iNumSamples - i );
+}
+
+static void MixMonoToStereoNEON ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const float32x4_t vGainL = vdupq_n_f32 ( fGainL );
+    const float32x4_t vGainR = vdupq_n_f32 ( fGainR );
+    int               i      = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const float32x4_t vIn   = vcvtq_f32_s32 ( vmovl_s16 ( vld1_s16 ( &psIn[i] ) ) );
+        float32x4x2_t     vCur  = vld2q_f32 ( &pfOut[2 * i] ); // de-interleave left/right
+        vCur.val[0]             = vaddq_f32 ( vCur.val[0], vmulq_f32 ( vIn, vGainL ) );
+        vCur.val[1]             = vaddq_f32 ( vCur.val[1], vmulq_f32 ( vIn, vGainR ) );
+
+        vst2q_f32 ( &pfOut[2 * i], vCur );
+    }
+
+    MixMonoToStereoScalar ( &pfOut[2 * i], &psIn[i], fGainL, fGainR, iNumSamples - i );
+}
+
+static void MixStereoToStereoNEON ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples )
+{
+    const float32_t   fGains[4] = { fGainL, fGainR, fGainL, fGainR };
+    const float32x4_t vGain     = vld1q_f32 ( fGains );
+    int               i         = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        const int16x8_t vIn   = vld1q_s16 ( &psIn[2 * i] );
+        float*          pfCur = &pfOut[2 * i];
+
+        vst1q_f32 ( &pfCur[0], vaddq_f32 ( vld1q_f32 ( &pfCur[0] ), vmulq_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_low_s16 ( vIn ) ) ), vGain ) ) );
+        vst1q_f32 ( &pfCur[4], vaddq_f32 ( vld1q_f32 ( &pfCur[4] ), vmulq_f32 ( vcvtq_f32_s32 ( vmovl_s16 ( vget_high_s16 ( vIn ) ) ), vGain ) ) );
+    }
+
+    MixStereoToStereoScalar ( &pfOut[2 * i], &psIn[2 * i], fGainL, fGainR, iNumSamples - i );
+}
+
+static void Float2ShortBlockNEON ( int16_t* psOut, const float* pfIn, const int iNumSamples )
+{
+    const float32x4_t vMin = vdupq_n_f32 ( static_cast<float> ( _MINSHORT ) );
+    const float32x4_t vMax = vdupq_n_f32 ( static_cast<float> ( _MAXSHORT ) );
+    int               i    = 0;
+
+    for ( ; i + 4 <= iNumSamples; i += 4 )
+    {
+        // clip, then truncate towards zero
+        const int32x4_t vInt = vcvtq_s32_f32 ( vminq_f32 ( vmaxq_f32 ( vld1q_f32 ( &pfIn[i] ), vMin ), vMax ) );
+
+        vst1_s16 ( &psOut[i], vqmovn_s32 ( vInt ) );
+    }
+
+    Float2ShortBlockScalar ( &psOut[i], &pfIn[i], iNumSamples - i );
+}
+#endif
+
+/* Implementation *************************************************************/
+CMixKernels::EImplementation CMixKernels::eImplementation = CMixKernels::MK_SCALAR;
+
+void ( *CMixKernels::MixMonoToMono ) ( float*, const int16_t*, const float, const int )                  = MixMonoToMonoScalar;
+void ( *CMixKernels::MixStereoToMono ) ( float*, const int16_t*, const float, const int )                = MixStereoToMonoScalar;
+void ( *CMixKernels::MixMonoToStereo ) ( float*, const int16_t*, const float, const float, const int )   = MixMonoToStereoScalar;
+void ( *CMixKernels::MixStereoToStereo ) ( float*, const int16_t*, const float, const float, const int ) = MixStereoToStereoScalar;
+void ( *CMixKernels::Float2ShortBlock ) ( int16_t*, const float*, const int )                            = Float2ShortBlockScalar;
+
+void CMixKernels::Init()
+{
+#ifdef MK_USE_SSE2
+    eImplementation   = MK_SSE2;
+    MixMonoToMono     = MixMonoToMonoSSE2;
+    MixStereoToMono   = MixStereoToMonoSSE2;
+    MixMonoToStereo   = MixMonoToStereoSSE2;
+    MixStereoToStereo = MixStereoToStereoSSE2;
+    Float2ShortBlock  = Float2ShortBlockSSE2;
+#endif
+
+#ifdef MK_USE_AVX2
+    if ( CpuSupportsAVX2() )
+    {
+        eImplementation   = MK_AVX2;
+        MixMonoToMono     = MixMonoToMonoAVX2;
+        MixStereoToMono   = MixStereoToMonoAVX2;
+        MixMonoToStereo   = MixMonoToStereoAVX2;
+        MixStereoToStereo = MixStereoToStereoAVX2;
+        Float2ShortBlock  = Float2ShortBlockAVX2;
+    }
+#endif
+
+#ifdef MK_USE_NEON
+    eImplementation   = MK_NEON;
+    MixMonoToMono     = MixMonoToMonoNEON;
+    MixStereoToMono   = MixStereoToMonoNEON;
+    MixMonoToStereo   = MixMonoToStereoNEON;
+    MixStereoToStereo = MixStereoToStereoNEON;
+    Float2ShortBlock  = Float2ShortBlockNEON;
+#endif
+}
+
+const char* CMixKernels::GetImplementationName()
+{
+    switch ( eImplementation )
+    {
+    case MK_SSE2:
+        return "SSE2";
+
+    case MK_AVX2:
+        return "AVX2";
+
+    case MK_NEON:
+        return "NEON";
+
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,72 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+/* Classes ********************************************************************/
+// Vectorized mixing kernels for the server mixer. The implementation is
+// selected once at startup by Init() based on the CPU features which are
+// available at runtime. All implementations produce bit-exact results compared
+// to the scalar reference implementation (multiplication and addition are
+// never fused and the float to short conversion truncates like a static_cast).
+class CMixKernels
+{
+public:
+    enum EImplementation
+    {
+        MK_SCALAR = 0,
+        MK_SSE2   = 1,
+        MK_AVX2   = 2,
+        MK_NEON   = 3
+    };
+
+    // selects the fastest supported implementation (may be called repeatedly)
+    static void Init();
+
+    static EImplementation GetImplementation() { return eImplementation; }
+    static const char*     GetImplementationName();
+
+    // mono input to mono output: pfOut[i] += psIn[i] * fGain
+    static void ( *MixMonoToMono ) ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples );
+
+    // interleaved stereo input to mono output with stereo-to-mono attenuation:
+    // pfOut[i] += fGain * ( psIn[2 * i] + psIn[2 * i + 1] ) / 2
+    static void ( *MixStereoToMono ) ( float* pfOut, const int16_t* psIn, const float fGain, const int iNumSamples );
+
+    // mono input to interleaved stereo output:
+    // pfOut[2 * i] += psIn[i] * fGainL, pfOut[2 * i + 1] += psIn[i] * fGainR
+    static void ( *MixMonoToStereo ) ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples );
+
+    // interleaved stereo input to interleaved stereo output:
+    // pfOut[2 * i] += psIn[2 * i] * fGainL, pfOut[2 * i + 1] += psIn[2 * i + 1] * fGainR
+    static void ( *MixStereoToStereo ) ( float* pfOut, const int16_t* psIn, const float fGainL, const float fGainR, const int iNumSamples );
+
+    // float to short conversion with clipping, same as Float2Short()
+    static void ( *Float2ShortBlock ) ( int16_t* psOut, const float* pfIn, const int iNumSamples );
+
+protected:
+    static EImplementation eImplementation;
+};
@@ -0,0 +1,570 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "packettrace.h"
+#include <cstring>
+#include <iostream>
+
+/* Implementation *************************************************************/
+// the values are stored with the least significant byte first (iPos is
+// incremented by the functions)
+static void PutValOnTrace ( CVector<uint8_t>& vecOut, int& iPos, const uint64_t iVal, const int iNumOfBytes )
+{
+    for ( int i = 0; i < iNumOfBytes; i++ )
+    {
+        vecOut[iPos++] = static_cast<uint8_t> ( iVal >> ( i * 8 ) );
+    }
+}
+
+static uint64_t GetValFromTrace ( const CVector<uint8_t>& vecIn, int& iPos, const int iNumOfBytes )
+{
+    uint64_t iVal = 0;
+
+    for ( int i = 0; i < iNumOfBytes; i++ )
+    {
+        iVal |= static_cast<uint64_t> ( vecIn[iPos++] ) << ( i * 8 );
+    }
+
+    return iVal;
+}
+
+// Packet trace writer ---------------------------------------------------------
+CPacketTraceWriter::CPacketTraceWriter() :
+    iNumRecordBytes ( 0 ),
+    iNumWriteRecordBytes ( 0 ),
+    iNumDroppedPackets ( 0 ),
+    iLastTimeUs ( 0 ),
+    bIsFirstRecord ( true ),
+    bIsActive ( false )
+{
+    vecChanProps.Init ( MAX_NUM_CHANNELS );
+
+    QObject::connect ( &FlushTimer, &QTimer::timeout, this, &CPacketTraceWriter::OnFlushTimer );
+}
+
+CPacketTraceWriter::~CPacketTraceWriter()
+{
+    if ( bIsActive )
+    {
+        FlushTimer.stop();
+        Flush();
+        File.close();
+    }
+}
+
+void CPacketTraceWriter::Start ( const QString& strFileName )
+{
+    File.setFileName ( strFileName );
+
+    if ( !File.open ( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        qWarning() << qUtf8Printable ( QString ( "Cannot open packet trace file %1 for writing." ).arg ( strFileName ) );
+        return;
+    }
+
+    // write the file header
+    CVector<uint8_t> vecbyHeader ( PACKET_TRACE_MAGIC_LEN + 2 );
+    int              iPos = 0;
+
+    for ( int i = 0; i < PACKET_TRACE_MAGIC_LEN; i++ )
+    {
+        vecbyHeader[iPos++] = static_cast<uint8_t> ( PACKET_TRACE_MAGIC[i] );
+    }
+
+    PutValOnTrace ( vecbyHeader, iPos, PACKET_TRACE_VERSION, 2 );
+
+    File.write ( reinterpret_cast<const char*> ( &vecbyHeader[0] ), vecbyHeader.Size() );
+
+    // the receive threads only write into the preallocated buffer, the two
+    // buffers are swapped on each flush
+    vecbyRecords.Init ( PACKET_TRACE_BUFFER_SIZE_BYTES );
+    vecbyWriteRecords.Init ( PACKET_TRACE_BUFFER_SIZE_BYTES );
+    iNumRecordBytes = 0;
+
+    FlushTimer.start ( PACKET_TRACE_FLUSH_INTERVAL_MS );
+    bIsActive = true;
+}
+
+void CPacketTraceWriter::AddPacket ( const int                    iChanID,
+                                     const int64_t                iArrivalTimeNs,
+                                     const CVector<uint8_t>&      vecbyData,
+                                     const int                    iNumBytes,
+                                     const CPacketTraceChanProps& ChanProps,
+                                     const bool                   bNewConnection )
+{
+    QMutexLocker locker ( &Mutex );
+
+    // the jitter buffer of the channel is initialized on a new connection and
+    // if the transport properties change
+    const bool bPutChanProps = bNewConnection || ( ChanProps != vecChanProps[iChanID] );
+
+    // if the buffer is full, the packet is dropped (the channel record is then
+    // written with the next packet which fits since the properties are not
+    // stored)
+    const int iNumRecBytes =
+        GetRecordSize ( iArrivalTimeNs, PACKET_TRACE_PACKET_LEN ) + ( bPutChanProps ? PACKET_TRACE_REC_HDR_LEN + PACKET_TRACE_CHANNEL_LEN : 0 );
+
+    if ( iNumRecordBytes + iNumRecBytes > vecbyRecords.Size() )
+    {
+        iNumDroppedPackets++;
+        return;
+    }
+
+    if ( bPutChanProps )
+    {
+        vecChanProps[iChanID] = ChanProps;
+
+        const int iFlags = ( ChanProps.bUseSequenceNumber ? PACKET_TRACE_FLAG_SEQUENCE_NUMBER : 0 ) |
+                           ( ChanProps.bUseDoubleSystemFrameSize ? PACKET_TRACE_FLAG_DOUBLE_FRAME_SIZE : 0 ) |
+                           ( bNewConnection ? PACKET_TRACE_FLAG_NEW_CONNECTION : 0 );
+
+        int iPos = PutRecordHeader ( PTR_CHANNEL, iChanID, iArrivalTimeNs, PACKET_TRACE_CHANNEL_LEN );
+
+        PutValOnTrace ( vecbyRecords, iPos, ChanProps.iBlockSize, 2 );
+        PutValOnTrace ( vecbyRecords, iPos, ChanProps.iNetwFrameSizeFact, 1 );
+        PutValOnTrace ( vecbyRecords, iPos, iFlags, 1 );
+    }
+
+    // per definition the sequence number is appended after the coded audio data
+    int iSequenceNumber = 0;
+
+    if ( ChanProps.bUseSequenceNumber && ( iNumBytes > ChanProps.iBlockSize ) )
+    {
+        iSequenceNumber = vecbyData[ChanProps.iBlockSize];
+    }
+
+    int iPos = PutRecordHeader ( PTR_PACKET, iChanID, iArrivalTimeNs, PACKET_TRACE_PACKET_LEN );
+
+    PutValOnTrace ( vecbyRecords, iPos, iNumBytes, 2 );
+    PutValOnTrace ( vecbyRecords, iPos, iSequenceNumber, 1 );
+}
+
+int CPacketTraceWriter::GetRecordSize ( const int64_t iArrivalTimeNs, const int iRecordLen ) const
+{
+    const int64_t iDeltaUs = bIsFirstRecord ? 0 : std::max ( iArrivalTimeNs / 1000 - iLastTimeUs, static_cast<int64_t> ( 0 ) );
+
+    return static_cast<int> ( ( iDeltaUs - 1 ) / PACKET_TRACE_MAX_DELTA_US ) * PACKET_TRACE_REC_HDR_LEN + PACKET_TRACE_REC_HDR_LEN + iRecordLen;
+}
+
+int CPacketTraceWriter::PutRecordHeader ( const EPacketTraceRecType eType, const int iChanID, const int64_t iArrivalTimeNs, const int iRecordLen )
+{
+    const int64_t iTimeUs = iArrivalTimeNs / 1000;
+
+    if ( bIsFirstRecord )
+    {
+        iLastTimeUs    = iTimeUs;
+        bIsFirstRecord = false;
+    }
+
+    // the time of the trace never runs backwards (e.g. if the system clock is
+    // adjusted)
+    int64_t iDeltaUs = std::max ( iTimeUs - iLastTimeUs, static_cast<int64_t> ( 0 ) );
+    iLastTimeUs      = iTimeUs;
+
+    // insert time records for very long pauses
+    while ( iDeltaUs > PACKET_TRACE_MAX_DELTA_US )
+    {
+        int iPos = iNumRecordBytes;
+        iNumRecordBytes += PACKET_TRACE_REC_HDR_LEN;
+
+        PutValOnTrace ( vecbyRecords, iPos, PTR_TIME, 1 );
+        PutValOnTrace ( vecbyRecords, iPos, 0, 1 );
+        PutValOnTrace ( vecbyRecords, iPos, PACKET_TRACE_MAX_DELTA_US, 4 );
+
+        iDeltaUs -= PACKET_TRACE_MAX_DELTA_US;
+    }
+
+    int iPos = iNumRecordBytes;
+    iNumRecordBytes += PACKET_TRACE_REC_HDR_LEN + iRecordLen;
+
+    PutValOnTrace ( vecbyRecords, iPos, eType, 1 );
+    PutValOnTrace ( vecbyRecords, iPos, iChanID, 1 );
+    PutValOnTrace ( vecbyRecords, iPos, iDeltaUs, 4 );
+
+    return iPos;
+}
+
+void CPacketTraceWriter::Flush()
+{
+    // take the collected records and write them without holding the mutex so
+    // that the receive threads are not blocked by the file access
+    int64_t iNumDropped;
+
+    Mutex.lock();
+    {
+        vecbyWriteRecords.swap ( vecbyRecords );
+        iNumWriteRecordBytes = iNumRecordBytes;
+        iNumRecordBytes      = 0;
+        iNumDropped          = iNumDroppedPackets;
+        iNumDroppedPackets   = 0;
+    }
+    Mutex.unlock();
+
+    if ( iNumWriteRecordBytes > 0 )
+    {
+        File.write ( reinterpret_cast<const char*> ( &vecbyWriteRecords[0] ), iNumWriteRecordBytes );
+        File.flush();
+    }
+
+    if ( iNumDropped > 0 )
+    {
+        qWarning() << qUtf8Printable ( QString ( "The packet trace buffer was full, %1 packets were not recorded." ).arg ( iNumDropped ) );
+    }
+}
+
+// Packet trace replay ---------------------------------------------------------
+CPacketTraceReplay::CPacketTraceReplay ( const EJitBufStrategy eNJitBufStrategy ) :
+    iNumConnections ( 0 ),
+    iTotNumGets ( 0 ),
+    iTotNumUnderruns ( 0 ),
+    iTotNumDelays ( 0 ),
+    dTotDelaySumNs ( 0 )
+{
+    vecChannels.Init ( MAX_NUM_CHANNELS );
+
+    for ( int iChanID = 0; iChanID < MAX_NUM_CHANNELS; iChanID++ )
+    {
+        vecChannels[iChanID].NetBuf.SetStrategy ( eNJitBufStrategy );
+    }
+}
+
+bool CPacketTraceReplay::Replay ( const QString& strFileName )
+{
+    QFile File ( strFileName );
+
+    if ( !File.open ( QIODevice::ReadOnly ) )
+    {
+        qCritical() << qUtf8Printable ( QString ( "Cannot open packet trace file %1 for reading." ).arg ( strFileName ) );
+        return false;
+    }
+
+    // check the file header
+    CVector<uint8_t> vecbyRecord ( PACKET_TRACE_MAGIC_LEN + 2 );
+    int              iPos = PACKET_TRACE_MAGIC_LEN;
+
+    if ( ( File.read ( reinterpret_cast<char*> ( &vecbyRecord[0] ), vecbyRecord.Size() ) != vecbyRecord.Size() ) ||
+         ( memcmp ( &vecbyRecord[0], PACKET_TRACE_MAGIC, PACKET_TRACE_MAGIC_LEN ) != 0 ) ||
+         ( GetValFromTrace ( vecbyRecord, iPos, 2 ) != PACKET_TRACE_VERSION ) )
+    {
+        qCritical() << qUtf8Printable ( QString ( "%1 is no packet trace file of a supported version." ).arg ( strFileName ) );
+        return false;
+    }
+
+    vecbyRecord.Init ( PACKET_TRACE_REC_HDR_LEN + std::max ( PACKET_TRACE_PACKET_LEN, PACKET_TRACE_CHANNEL_LEN ) );
+
+    int64_t iTimeUs = 0;
+
+    for ( ;; )
+    {
+        // record header
+        const qint64 iNumRead = File.read ( reinterpret_cast<char*> ( &vecbyRecord[0] ), PACKET_TRACE_REC_HDR_LEN );
+
+        if ( iNumRead == 0 )
+        {
+            break; // end of file
+        }
+
+        iPos              = 0;
+        const int iType   = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 1 ) );
+        const int iChanID = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 1 ) );
+
+        iTimeUs += static_cast<int64_t> ( GetValFromTrace ( vecbyRecord, iPos, 4 ) );
+
+        const int64_t iTimeNs = iTimeUs * 1000;
+        int           iRecLen = 0;
+
+        if ( iType == PTR_PACKET )
+        {
+            iRecLen = PACKET_TRACE_PACKET_LEN;
+        }
+        else if ( iType == PTR_CHANNEL )
+        {
+            iRecLen = PACKET_TRACE_CHANNEL_LEN;
+        }
+        else if ( iType != PTR_TIME )
+        {
+            qCritical() << qUtf8Printable ( QString ( "Unknown record type %1 in packet trace file %2." ).arg ( iType ).arg ( strFileName ) );
+            return false;
+        }
+
+        if ( ( iNumRead != PACKET_TRACE_REC_HDR_LEN ) ||
+             ( File.read ( reinterpret_cast<char*> ( &vecbyRecord[iPos] ), iRecLen ) != iRecLen ) )
+        {
+            // the server was probably stopped while writing, use what we have
+            qWarning() << qUtf8Printable ( QString ( "The packet trace file %1 is truncated." ).arg ( strFileName ) );
+            break;
+        }
+
+        if ( iChanID >= MAX_NUM_CHANNELS )
+        {
+            qCritical() << qUtf8Printable ( QString ( "Invalid channel ID %1 in packet trace file %2." ).arg ( iChanID ).arg ( strFileName ) );
+            return false;
+        }
+
+        CReplayChannel& Channel = vecChannels[iChanID];
+
+        if ( iType == PTR_CHANNEL )
+        {
+            const int iBlockSize         = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 2 ) );
+            const int iNetwFrameSizeFact = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 1 ) );
+            const int iFlags             = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 1 ) );
+
+            // a trace may also start in the middle of a connection
+            if ( ( iFlags & PACKET_TRACE_FLAG_NEW_CONNECTION ) || !Channel.bIsConnected )
+            {
+                Disconnect ( Channel, iChanID );
+                Connect ( Channel, iTimeNs );
+            }
+
+            SetProps ( Channel,
+                       CPacketTraceChanProps ( iBlockSize,
+                                               iNetwFrameSizeFact,
+                                               ( iFlags & PACKET_TRACE_FLAG_SEQUENCE_NUMBER ) != 0,
+                                               ( iFlags & PACKET_TRACE_FLAG_DOUBLE_FRAME_SIZE ) != 0 ),
+                       iTimeNs );
+        }
+        else if ( ( iType == PTR_PACKET ) && Channel.bIsConnected )
+        {
+            const int iNumBytes       = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 2 ) );
+            const int iSequenceNumber = static_cast<int> ( GetValFromTrace ( vecbyRecord, iPos, 1 ) );
+
+            // the server reads the jitter buffer independently of the packet
+            // arrivals, do all reads up to the arrival time first
+            GetBlocks ( Channel, iTimeNs );
+            PutPacket ( Channel, iTimeNs, iNumBytes, iSequenceNumber );
+        }
+    }
+
+    for ( int iChanID = 0; iChanID < MAX_NUM_CHANNELS; iChanID++ )
+    {
+        Disconnect ( vecChannels[iChanID], iChanID );
+    }
+
+    // summary of all connections
+    std::cout << qUtf8Printable (
+        QString ( "total: %1 connections, %2 underruns of %3 blocks (%4 %), average buffer delay %5 ms\n" )
+            .arg ( iNumConnections )
+            .arg ( iTotNumUnderruns )
+            .arg ( iTotNumGets )
+            .arg ( iTotNumGets > 0 ? 100.0 * iTotNumUnderruns / iTotNumGets : 0.0, 0, 'f', 3 )
+            .arg ( iTotNumDelays > 0 ? dTotDelaySumNs / iTotNumDelays / 1e6 : 0.0, 0, 'f', 2 ) );
+
+    return true;
+}
+
+void CPacketTraceReplay::Connect ( CReplayChannel& Channel, const int64_t iTimeNs )
+{
+    // the server starts each connection with the default buffer size and the
+    // automatic buffer size enabled
+    Channel.iConnectionCnt++;
+
+    Channel.bIsConnected        = true;
+    Channel.iCurNumBlocks       = DEF_NET_BUF_SIZE_NUM_BL;
+    Channel.Props               = CPacketTraceChanProps();
+    Channel.bGetsStarted        = false;
+    Channel.iConnectStartNs     = iTimeNs;
+    Channel.iLastPacketNs       = iTimeNs;
+    Channel.iAutoSettingStartNs = iTimeNs;
+    Channel.iLastAutoChangeNs   = iTimeNs;
+    Channel.iLastAutoSetting    = Channel.iCurNumBlocks;
+    Channel.iNumPackets         = 0;
+    Channel.iNumInvalidPackets  = 0;
+    Channel.iNumPutErrors       = 0;
+    Channel.iNumGets            = 0;
+    Channel.iNumUnderruns       = 0;
+    Channel.iNumDelays          = 0;
+    Channel.dDelaySumNs         = 0;
+    Channel.iMaxDelayNs         = 0;
+}
+
+void CPacketTraceReplay::Disconnect ( CReplayChannel& Channel, const int iChanID )
+{
+    if ( !Channel.bIsConnected )
+    {
+        return;
+    }
+
+    Channel.bIsConnected = false;
+
+    // accumulate and print the results of the connection
+    iNumConnections++;
+    iTotNumGets      += Channel.iNumGets;
+    iTotNumUnderruns += Channel.iNumUnderruns;
+    iTotNumDelays    += Channel.iNumDelays;
+    dTotDelaySumNs   += Channel.dDelaySumNs;
+
+    const int iBlockSizeSamples = Channel.Props.bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
+
+    std::cout << qUtf8Printable (
+        QString ( "channel %1, connection %2: %3 s, %4 packets (%5 invalid), %6 bytes x %7 blocks of %8 samples per packet%9\n" )
+            .arg ( iChanID )
+            .arg ( Channel.iConnectionCnt )
+            .arg ( ( Channel.iLastPacketNs - Channel.iConnectStartNs ) / 1e9, 0, 'f', 1 )
+            .arg ( Channel.iNumPackets )
+            .arg ( Channel.iNumInvalidPackets )
+            .arg ( Channel.Props.iBlockSize )
+            .arg ( Channel.Props.iNetwFrameSizeFact )
+            .arg ( iBlockSizeSamples )
+            .arg ( Channel.Props.bUseSequenceNumber ? ", sequence numbers" : "" ) );
+
+    std::cout << qUtf8Printable ( QString ( "  underruns:            %1 of %2 blocks (%3 %), %4 put errors\n" )
+                                      .arg ( Channel.iNumUnderruns )
+                                      .arg ( Channel.iNumGets )
+                                      .arg ( Channel.iNumGets > 0 ? 100.0 * Channel.iNumUnderruns / Channel.iNumGets : 0.0, 0, 'f', 3 )
+                                      .arg ( Channel.iNumPutErrors ) );
+
+    std::cout << qUtf8Printable ( QString ( "  average buffer delay: %1 ms (maximum %2 ms)\n" )
+                                      .arg ( Channel.iNumDelays > 0 ? Channel.dDelaySumNs / Channel.iNumDelays / 1e6 : 0.0, 0, 'f', 2 )
+                                      .arg ( Channel.iMaxDelayNs / 1e6, 0, 'f', 2 ) );
+
+    std::cout << qUtf8Printable ( QString ( "  auto setting:         %1 blocks, converged after %2 s\n" )
+                                      .arg ( Channel.iLastAutoSetting )
+                                      .arg ( ( Channel.iLastAutoChangeNs - Channel.iAutoSettingStartNs ) / 1e9, 0, 'f', 1 ) );
+}
+
+void CPacketTraceReplay::SetProps ( CReplayChannel& Channel, const CPacketTraceChanProps& NewProps, const int64_t iTimeNs )
+{
+    // like CChannel, the jitter buffer is initialized from scratch if the
+    // network transport properties change
+    Channel.Props = NewProps;
+
+    if ( Channel.Props.iBlockSize > 0 )
+    {
+        Channel.NetBuf.SetUseDoubleSystemFrameSize ( Channel.Props.bUseDoubleSystemFrameSize ); // NOTE must be set BEFORE the init()
+        Channel.NetBuf.Init ( Channel.Props.iBlockSize, Channel.iCurNumBlocks, Channel.Props.bUseSequenceNumber );
+
+        Channel.vecbyPacket.Init ( Channel.Props.GetPacketSize() );
+        Channel.vecbyBlock.Init ( Channel.Props.iBlockSize );
+    }
+
+    const int iBlockSizeSamples = Channel.Props.bUseDoubleSystemFrameSize ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
+
+    Channel.dGetIntervalNs      = iBlockSizeSamples * 1e9 / SYSTEM_SAMPLE_RATE_HZ;
+    Channel.bGetsStarted        = false;
+    Channel.iAutoSettingStartNs = iTimeNs;
+    Channel.iLastAutoChangeNs   = iTimeNs;
+    Channel.iLastAutoSetting    = Channel.NetBuf.GetAutoSetting();
+}
+
+void CPacketTraceReplay::PutPacket ( CReplayChannel& Channel, const int64_t iTimeNs, const int iNumBytes, const int iSequenceNumber )
+{
+    Channel.iLastPacketNs = iTimeNs;
+
+    // the channel only accepts packets with the negotiated size
+    if ( ( Channel.Props.iBlockSize <= 0 ) || ( iNumBytes != Channel.Props.GetPacketSize() ) )
+    {
+        Channel.iNumInvalidPackets++;
+        return;
+    }
+
+    Channel.iNumPackets++;
+
+    if ( !Channel.bGetsStarted )
+    {
+        Channel.bGetsStarted       = true;
+        Channel.iGetStartNs        = iTimeNs + static_cast<int64_t> ( Channel.dGetIntervalNs / 2 );
+        Channel.iNumGetsSinceStart = 0;
+    }
+
+    // instead of the audio data, each block carries the arrival time of its
+    // packet so that the buffer delay can be measured when the block is read
+    const int iNumBytesSeqNum = Channel.Props.bUseSequenceNumber ? 1 : 0;
+    const int iNumTimeBytes   = std::min ( Channel.Props.iBlockSize, 8 );
+    int       iBlockOffset    = 0;
+
+    for ( int iBlock = 0; iBlock < Channel.Props.iNetwFrameSizeFact; iBlock++ )
+    {
+        int iPos = iBlockOffset;
+
+        PutValOnTrace ( Channel.vecbyPacket, iPos, static_cast<uint64_t> ( iTimeNs ), iNumTimeBytes );
+
+        if ( Channel.Props.bUseSequenceNumber )
+        {
+            Channel.vecbyPacket[iBlockOffset + Channel.Props.iBlockSize] = static_cast<uint8_t> ( iSequenceNumber + iBlock );
+        }
+
+        iBlockOffset += Channel.Props.iBlockSize + iNumBytesSeqNum;
+    }
+
+    if ( !Channel.NetBuf.Put ( Channel.vecbyPacket, iNumBytes, iTimeNs ) )
+    {
+        Channel.iNumPutErrors++;
+    }
+}
+
+void CPacketTraceReplay::GetBlocks ( CReplayChannel& Channel, const int64_t iUntilNs )
+{
+    if ( !Channel.bGetsStarted )
+    {
+        return;
+    }
+
+    for ( ;; )
+    {
+        const int64_t iGetNs = Channel.iGetStartNs + static_cast<int64_t> ( Channel.iNumGetsSinceStart * Channel.dGetIntervalNs );
+
+        if ( iGetNs > iUntilNs )
+        {
+            break;
+        }
+
+        Channel.iNumGetsSinceStart++;
+        Channel.iNumGets++;
+
+        if ( Channel.NetBuf.Get ( Channel.vecbyBlock, Channel.Props.iBlockSize ) )
+        {
+            // the delay can only be measured if the complete time fits in the block
+            if ( Channel.Props.iBlockSize >= 8 )
+            {
+                int           iPos     = 0;
+                const int64_t iDelayNs = iGetNs - static_cast<int64_t> ( GetValFromTrace ( Channel.vecbyBlock, iPos, 8 ) );
+
+                Channel.iNumDelays++;
+                Channel.dDelaySumNs += iDelayNs;
+                Channel.iMaxDelayNs = std::max ( Channel.iMaxDelayNs, iDelayNs );
+            }
+        }
+        else
+        {
+            Channel.iNumUnderruns++;
+        }
+
+        // like CChannel::UpdateSocketBufferSize() which is called by the
+        // server after each read
+        const int iAutoSetting = Channel.NetBuf.GetAutoSetting();
+
+        if ( iAutoSetting != Channel.iLastAutoSetting )
+        {
+            Channel.iLastAutoSetting  = iAutoSetting;
+            Channel.iLastAutoChangeNs = iGetNs;
+        }
+
+        if ( ( iAutoSetting != Channel.iCurNumBlocks ) && ( iAutoSetting >= MIN_NET_BUF_SIZE_NUM_BL ) && ( iAutoSetting <= MAX_NET_BUF_SIZE_NUM_BL ) )
+        {
+            Channel.iCurNumBlocks = iAutoSetting;
+            Channel.NetBuf.Init ( Channel.Props.iBlockSize, Channel.iCurNumBlocks, Channel.Props.bUseSequenceNumber, true );
+        }
+    }
+}
@@ -0,0 +1,230 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include "global.h"
+#include "util.h"
+#include "buffer.h"
+
+/* Definitions ****************************************************************/
+// The packet trace file starts with a header which consists of the magic
+// string PACKET_TRACE_MAGIC and a two bytes version number, followed by the
+// records. All values are stored with the least significant byte first (like
+// in the protocol). Each record starts with:
+//
+//    +-------------+-------------+--------------------------------+
+//    | 1 byte type | 1 byte chan | 4 bytes time delta (us)        |
+//    +-------------+-------------+--------------------------------+
+//
+// where the time delta is the arrival time difference in micro seconds to the
+// previous record of the file. The record types are followed by:
+// - PTR_PACKET: 2 bytes packet size, 1 byte sequence number of the first
+//   block of the packet (zero if the channel does not use sequence numbers)
+// - PTR_CHANNEL: 2 bytes coded block size (without sequence number), 1 byte
+//   network frame size factor, 1 byte flags (PACKET_TRACE_FLAG_*)
+// - PTR_TIME: nothing, only used to advance the time if the time delta does
+//   not fit in 4 bytes
+// A PTR_CHANNEL record is written before the first packet of a connection and
+// whenever the network transport properties of the channel have changed.
+#define PACKET_TRACE_MAGIC        "JAMTRACE"
+#define PACKET_TRACE_MAGIC_LEN    8
+#define PACKET_TRACE_VERSION      1
+#define PACKET_TRACE_REC_HDR_LEN  6
+#define PACKET_TRACE_PACKET_LEN   3
+#define PACKET_TRACE_CHANNEL_LEN  4
+#define PACKET_TRACE_MAX_DELTA_US 0xFFFFFFFFLL
+
+#define PACKET_TRACE_FLAG_SEQUENCE_NUMBER   0x01
+#define PACKET_TRACE_FLAG_DOUBLE_FRAME_SIZE 0x02
+#define PACKET_TRACE_FLAG_NEW_CONNECTION    0x04
+
+// the records are collected in memory and written to the file by the thread
+// which started the trace in this interval
+#define PACKET_TRACE_FLUSH_INTERVAL_MS 1000
+
+// the record buffer is allocated when the trace is started, it holds twice the
+// packets of all channels (at the highest packet rate) of one flush interval,
+// records which do not fit any more are dropped
+#define PACKET_TRACE_MAX_PACKETS_PER_S ( MAX_NUM_CHANNELS * SYSTEM_SAMPLE_RATE_HZ / SYSTEM_FRAME_SIZE_SAMPLES )
+#define PACKET_TRACE_BUFFER_SIZE_BYTES \
+    ( 2 * PACKET_TRACE_MAX_PACKETS_PER_S * PACKET_TRACE_FLUSH_INTERVAL_MS / 1000 * ( PACKET_TRACE_REC_HDR_LEN + PACKET_TRACE_PACKET_LEN ) )
+
+enum EPacketTraceRecType
+{
+    PTR_PACKET  = 0,
+    PTR_CHANNEL = 1,
+    PTR_TIME    = 2
+};
+
+/* Classes ********************************************************************/
+// network transport properties of a channel which are needed to feed the
+// recorded packets in a jitter buffer
+class CPacketTraceChanProps
+{
+public:
+    CPacketTraceChanProps() : iBlockSize ( 0 ), iNetwFrameSizeFact ( 0 ), bUseSequenceNumber ( false ), bUseDoubleSystemFrameSize ( false ) {}
+
+    CPacketTraceChanProps ( const int  iNBlockSize,
+                            const int  iNNetwFrameSizeFact,
+                            const bool bNUseSequenceNumber,
+                            const bool bNUseDoubleSystemFrameSize ) :
+        iBlockSize ( iNBlockSize ),
+        iNetwFrameSizeFact ( iNNetwFrameSizeFact ),
+        bUseSequenceNumber ( bNUseSequenceNumber ),
+        bUseDoubleSystemFrameSize ( bNUseDoubleSystemFrameSize )
+    {}
+
+    bool operator!= ( const CPacketTraceChanProps& Other ) const
+    {
+        return ( iBlockSize != Other.iBlockSize ) || ( iNetwFrameSizeFact != Other.iNetwFrameSizeFact ) ||
+               ( bUseSequenceNumber != Other.bUseSequenceNumber ) || ( bUseDoubleSystemFrameSize != Other.bUseDoubleSystemFrameSize );
+    }
+
+    // size of an audio packet which is accepted by the channel
+    int GetPacketSize() const { return ( iBlockSize + ( bUseSequenceNumber ? 1 : 0 ) ) * iNetwFrameSizeFact; }
+
+    int  iBlockSize; // coded bytes of one block
+    int  iNetwFrameSizeFact;
+    bool bUseSequenceNumber;
+    bool bUseDoubleSystemFrameSize;
+};
+
+// Records the arrival time, size and sequence number of the audio packets of
+// all channels of the server in a packet trace file.
+class CPacketTraceWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    CPacketTraceWriter();
+    virtual ~CPacketTraceWriter();
+
+    void Start ( const QString& strFileName );
+    bool IsActive() const { return bIsActive; }
+
+    // may be called by any thread (does not allocate memory)
+    void AddPacket ( const int                    iChanID,
+                     const int64_t                iArrivalTimeNs,
+                     const CVector<uint8_t>&      vecbyData,
+                     const int                    iNumBytes,
+                     const CPacketTraceChanProps& ChanProps,
+                     const bool                   bNewConnection );
+
+protected:
+    // returns the number of bytes of a record including the time records
+    // which are inserted before it
+    int GetRecordSize ( const int64_t iArrivalTimeNs, const int iRecordLen ) const;
+
+    // returns the position of the record data after the header
+    int  PutRecordHeader ( const EPacketTraceRecType eType, const int iChanID, const int64_t iArrivalTimeNs, const int iRecordLen );
+    void Flush();
+
+    QFile                          File;
+    QTimer                         FlushTimer;
+    QMutex                         Mutex;
+    CVector<uint8_t>               vecbyRecords;
+    CVector<uint8_t>               vecbyWriteRecords;
+    int                            iNumRecordBytes;
+    int                            iNumWriteRecordBytes;
+    int64_t                        iNumDroppedPackets;
+    CVector<CPacketTraceChanProps> vecChanProps;
+    int64_t                        iLastTimeUs;
+    bool                           bIsFirstRecord;
+    bool                           bIsActive;
+
+public slots:
+    void OnFlushTimer() { Flush(); }
+};
+
+// Replays a packet trace file through the jitter buffer of the channels
+// (CNetBufWithStats with automatic buffer size) as fast as possible and prints
+// the results of each connection. The buffer is read with the nominal block
+// rate of the server, starting half a block after the first packet.
+class CPacketTraceReplay
+{
+public:
+    CPacketTraceReplay ( const EJitBufStrategy eNJitBufStrategy = JS_ERROR_RATE );
+
+    // returns false if the file cannot be read or is no packet trace
+    bool Replay ( const QString& strFileName );
+
+protected:
+    class CReplayChannel
+    {
+    public:
+        CReplayChannel() : bIsConnected ( false ), iConnectionCnt ( 0 ) {}
+
+        CNetBufWithStats      NetBuf;
+        CPacketTraceChanProps Props;
+        CVector<uint8_t>      vecbyPacket;
+        CVector<uint8_t>      vecbyBlock;
+        bool                  bIsConnected;
+        int                   iConnectionCnt;
+        int                   iCurNumBlocks;
+        int                   iSequenceNumber;
+
+        // get schedule (restarted if the transport properties change)
+        bool    bGetsStarted;
+        int64_t iGetStartNs;
+        int64_t iNumGetsSinceStart;
+        double  dGetIntervalNs;
+
+        // results of the current connection
+        int64_t iConnectStartNs;
+        int64_t iLastPacketNs;
+        int64_t iAutoSettingStartNs;
+        int64_t iLastAutoChangeNs;
+        int     iLastAutoSetting;
+        int64_t iNumPackets;
+        int64_t iNumInvalidPackets;
+        int64_t iNumPutErrors;
+        int64_t iNumGets;
+        int64_t iNumUnderruns;
+        int64_t iNumDelays;
+        double  dDelaySumNs;
+        int64_t iMaxDelayNs;
+    };
+
+    void Connect ( CReplayChannel& Channel, const int64_t iTimeNs );
+    void Disconnect ( CReplayChannel& Channel, const int iChanID );
+    void SetProps ( CReplayChannel& Channel, const CPacketTraceChanProps& NewProps, const int64_t iTimeNs );
+    void PutPacket ( CReplayChannel& Channel, const int64_t iTimeNs, const int iNumBytes, const int iSequenceNumber );
+    void GetBlocks ( CReplayChannel& Channel, const int64_t iUntilNs );
+
+    CVector<CReplayChannel> vecChannels;
+
+    // results of all connections
+    int     iNumConnections;
+    int64_t iTotNumGets;
+    int64_t iTotNumUnderruns;
+    int64_t iTotNumDelays;
+    double  dTotDelaySumNs;
+};
@@ -65,6 +65,24 @@ SPLIT MESSAGE CONTAINER
 
 
 
+WINDOWED MESSAGES CONTAINER
+---------------------------
+
+    +---------------------------+------------------------+------------------------+ ...
+    | 1 byte window start (cnt) | complete message frame | complete message frame | ...
+    +---------------------------+------------------------+------------------------+ ...
+
+- used for all messages (including the acknowledgements) of a peer which has
+  negotiated the windowed mode with PROTMESSID_REQ_WINDOWED_MESS_SUPPORT
+- the container itself is sent with cnt = 0 and is not acknowledged, each
+  contained message is acknowledged individually
+- up to MESS_WINDOW_SIZE messages may be unacknowledged at a time, the
+  receiver evaluates them in the order of their cnt values
+- window start - cnt of the oldest unacknowledged message of the sender, used
+  by the receiver to synchronize its receive window
+
+
+
 MESSAGES (with connection)
 --------------------------
 
@@ -215,6 +233,16 @@ MESSAGES (with connection)
     note: does not have any data -> n = 0
 
 
+- PROTMESSID_REQ_WINDOWED_MESS_SUPPORT: Request windowed messages support
+
+    note: does not have any data -> n = 0
+
+
+- PROTMESSID_WINDOWED_MESS_SUPPORTED: Windowed messages are supported
+
+    note: does not have any data -> n = 0
+
+
 - PROTMESSID_LICENCE_REQUIRED: Licence required to connect to the server
 
     +---------------------+
@@ -437,15 +465,12 @@ CONNECTION LESS MESSAGES
 #include "protocol.h"
 
 /* Implementation *************************************************************/
-CProtocol::CProtocol()
+CProtocol::CProtocol() : TimerSendMess ( [this]() { OnTimerSendMess(); } )
 {
     // allocate worst case memory for split part messages
     vecbySplitMessageStorage.Init ( MAX_SIZE_BYTES_NETW_BUF );
 
     Reset();
-
-    // Connections -------------------------------------------------------------
-    QObject::connect ( &TimerSendMess, &QTimer::timeout, this, &CProtocol::OnTimerSendMess );
 }
 
 void CProtocol::Reset()
@@ -460,30 +485,69 @@ void CProtocol::Reset()
     iSplitMessageDataIndex = 0;
     bSplitMessageSupported = false; // compatilibity to old versions
 
+    // the windowed mode must be negotiated again
+    bWindowedMessagesSupported = false;
+    bWindowFlushPending        = false;
+    bRecWindowSynced           = false;
+    iRecWindowNextCnt          = 0;
+
+    for ( int i = 0; i < MESS_WINDOW_SIZE; i++ )
+    {
+        RecWindow[i].bValid = false;
+    }
+
     // delete complete "send message queue"
     SendMessQueue.clear();
 }
 
-void CProtocol::EnqueueMessage ( CVector<uint8_t>& vecMessage, const int iCnt, const int iID )
+void CProtocol::EnqueueMessage ( const int iID, const CVector<uint8_t>& vecData )
 {
     bool bListWasEmpty;
+    bool bWindowed;
+    bool bPostFlush = false;
 
     Mutex.lock();
     {
         // check if list is empty so that we have to initiate a send process
         bListWasEmpty = SendMessQueue.empty();
+        bWindowed     = bWindowedMessagesSupported;
+
+        // the counter is assigned in the same step as the message is added to
+        // the queue so that the queue is sorted by the counter values (which
+        // is required for the windowed mode)
+        SendMessQueue.push_back ( CSendMessage() );
 
-        // create send message object for the queue
-        CSendMessage SendMessageObj ( vecMessage, iCnt, iID );
+        CSendMessage& SendMessageObj = SendMessQueue.back();
 
-        // we want to have a FIFO: we add at the end and take from the beginning
-        SendMessQueue.push_back ( SendMessageObj );
+        SendMessageObj.iID  = iID;
+        SendMessageObj.iCnt = iCounter;
+
+        // build complete message
+        GenMessageFrame ( SendMessageObj.vecMessage, iCounter, iID, vecData );
+
+        // increase counter (wraps around automatically)
+        iCounter++;
+
+        if ( bWindowed && !bWindowFlushPending )
+        {
+            bWindowFlushPending = true;
+            bPostFlush          = true;
+        }
     }
     Mutex.unlock();
 
-    // if list was empty, initiate send process
-    if ( bListWasEmpty )
+    if ( bWindowed )
     {
+        // in the windowed mode the messages which are created in one go are
+        // coalesced, they are sent as soon as we are back in the event loop
+        if ( bPostFlush )
+        {
+            QMetaObject::invokeMethod ( this, "OnFlushWindowedMessages", Qt::QueuedConnection );
+        }
+    }
+    else if ( bListWasEmpty )
+    {
+        // if list was empty, initiate send process
         SendMessage();
     }
 }
@@ -503,14 +567,14 @@ void CProtocol::SendMessage()
             vecMessage = SendMessQueue.front().vecMessage;
 
             // start or restart the ack timeout
-            TimerSendMess.start ( SEND_MESS_TIMEOUT_MS );
+            TimerSendMess.Start ( SEND_MESS_TIMEOUT_MS );
 
             bSendMess = true;
         }
         else
         {
             // no message to send, stop timer
-            TimerSendMess.stop();
+            TimerSendMess.Stop();
         }
     }
     Mutex.unlock();
@@ -522,11 +586,352 @@ void CProtocol::SendMessage()
     }
 }
 
+void CProtocol::OnTimerSendMess()
+{
+    bool bWindowed;
+
+    Mutex.lock();
+    {
+        bWindowed = bWindowedMessagesSupported;
+    }
+    Mutex.unlock();
+
+    // in the windowed mode all unacknowledged messages are sent again
+    if ( bWindowed )
+    {
+        SendWindowedMessages ( true );
+    }
+    else
+    {
+        SendMessage();
+    }
+}
+
+void CProtocol::SendWindowedMessages ( const bool bRetransmit )
+{
+    std::list<CVector<uint8_t>> ContainerList;
+    CVector<uint8_t>            vecContainerData;
+
+    Mutex.lock();
+    {
+        bWindowFlushPending = false;
+
+        if ( SendMessQueue.empty() )
+        {
+            // all messages are acknowledged, stop timer
+            TimerSendMess.Stop();
+        }
+        else
+        {
+            // the window starts at the oldest unacknowledged message, the
+            // receiver uses this value to synchronize its receive window
+            const uint8_t iWindowStart = static_cast<uint8_t> ( SendMessQueue.front().iCnt );
+            bool          bAnySent     = false;
+
+            for ( CSendMessage& SendMess : SendMessQueue )
+            {
+                // the queue is sorted by the counter, i.e., all following
+                // messages are outside of the window, too
+                if ( static_cast<uint8_t> ( SendMess.iCnt - iWindowStart ) >= MESS_WINDOW_SIZE )
+                {
+                    break;
+                }
+
+                if ( SendMess.bSent && !bRetransmit )
+                {
+                    continue;
+                }
+
+                // start a new container if the message does not fit in the current one
+                if ( ( vecContainerData.Size() > 1 ) && ( vecContainerData.Size() + SendMess.vecMessage.Size() > MESS_COALESCE_MAX_SIZE_BYTES ) )
+                {
+                    ContainerList.push_back ( CVector<uint8_t>() );
+                    GenMessageFrame ( ContainerList.back(), 0, PROTMESSID_SPECIAL_WINDOWED_MESSAGES, vecContainerData );
+                    vecContainerData.Init ( 0 );
+                }
+
+                if ( vecContainerData.Size() == 0 )
+                {
+                    vecContainerData.Add ( iWindowStart );
+                }
+
+                vecContainerData.insert ( vecContainerData.end(), SendMess.vecMessage.begin(), SendMess.vecMessage.end() );
+
+                SendMess.bSent = true;
+                bAnySent       = true;
+            }
+
+            if ( vecContainerData.Size() > 0 )
+            {
+                ContainerList.push_back ( CVector<uint8_t>() );
+                GenMessageFrame ( ContainerList.back(), 0, PROTMESSID_SPECIAL_WINDOWED_MESSAGES, vecContainerData );
+            }
+
+            // the ack timeout is only restarted on a retransmission so that
+            // new messages do not delay the retransmission of older ones
+            if ( bAnySent && ( bRetransmit || !TimerSendMess.isActive() ) )
+            {
+                TimerSendMess.Start ( SEND_MESS_TIMEOUT_MS );
+            }
+        }
+    }
+    Mutex.unlock();
+
+    for ( const CVector<uint8_t>& vecContainer : ContainerList )
+    {
+        emit MessReadyForSending ( vecContainer );
+    }
+}
+
+void CProtocol::EvaluateAcknMes ( const int iAcknID, const int iRecCounter )
+{
+    bool bSendNextMess = false;
+    bool bWindowed;
+
+    Mutex.lock();
+    {
+        bWindowed = bWindowedMessagesSupported;
+
+        if ( bWindowed )
+        {
+            // in the windowed mode any message of the window may be acknowledged
+            for ( auto it = SendMessQueue.begin(); it != SendMessQueue.end(); ++it )
+            {
+                if ( ( it->iCnt == iRecCounter ) && ( it->iID == iAcknID ) )
+                {
+                    // message acknowledged, remove from queue
+                    SendMessQueue.erase ( it );
+
+                    // the window may have moved, send the next messages
+                    bSendNextMess = true;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            // check if this is the correct acknowledgment
+            if ( !SendMessQueue.empty() )
+            {
+                if ( ( SendMessQueue.front().iCnt == iRecCounter ) && ( SendMessQueue.front().iID == iAcknID ) )
+                {
+                    // message acknowledged, remove from queue
+                    SendMessQueue.pop_front();
+
+                    // send next message in queue
+                    bSendNextMess = true;
+                }
+            }
+        }
+    }
+    Mutex.unlock();
+
+    if ( bSendNextMess )
+    {
+        if ( bWindowed )
+        {
+            SendWindowedMessages ( false );
+        }
+        else
+        {
+            SendMessage();
+        }
+    }
+}
+
+void CProtocol::ParseWindowedMessagesContainer ( const CVector<uint8_t>& vecbyData )
+{
+    const int iDataLen = vecbyData.Size();
+
+    // 1 byte window start
+    if ( iDataLen < 1 )
+    {
+        return;
+    }
+
+    const uint8_t    iWindowStart     = vecbyData[0];
+    bool             bWindowChecked   = false;
+    int              iPos             = 1;
+    CVector<uint8_t> vecbyFrame;
+    CVector<uint8_t> vecbyMesBodyData;
+    CVector<uint8_t> vecAcknContainerData;
+
+    // the container holds a sequence of complete message frames
+    while ( iDataLen - iPos >= MESS_LEN_WITHOUT_DATA_BYTE )
+    {
+        const int iFrameLen = MESS_LEN_WITHOUT_DATA_BYTE + ( vecbyData[iPos + 5] | ( vecbyData[iPos + 6] << 8 ) );
+
+        // a malformed frame ends the evaluation of the container but the
+        // messages evaluated so far are still acknowledged below
+        if ( iPos + iFrameLen > iDataLen )
+        {
+            break;
+        }
+
+        vecbyFrame.Init ( iFrameLen );
+        std::copy ( vecbyData.begin() + iPos, vecbyData.begin() + iPos + iFrameLen, vecbyFrame.begin() );
+        iPos += iFrameLen;
+
+        int iRecCounter;
+        int iRecID;
+
+        if ( ParseMessageFrame ( vecbyFrame, iFrameLen, vecbyMesBodyData, iRecCounter, iRecID ) )
+        {
+            break;
+        }
+
+        if ( iRecID == PROTMESSID_ACKN )
+        {
+            // acknowledgements are evaluated immediately and are not acknowledged
+            if ( vecbyMesBodyData.Size() == 2 )
+            {
+                int iAcknPos = 0;
+
+                EvaluateAcknMes ( static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iAcknPos, 2 ) ), iRecCounter );
+            }
+        }
+        else if ( ( iRecID != PROTMESSID_SPECIAL_WINDOWED_MESSAGES ) && !IsConnectionLessMessageID ( iRecID ) )
+        {
+            if ( !bWindowChecked )
+            {
+                // Synchronize the receive window to the window of the sender. The
+                // start of the sender window is never ahead of our next expected
+                // message since the missing message is not acknowledged yet. If it
+                // is ahead nevertheless, the sender has restarted its counter.
+                const int iStartAhead = static_cast<uint8_t> ( iWindowStart - iRecWindowNextCnt );
+
+                if ( !bRecWindowSynced || ( ( iStartAhead > 0 ) && ( iStartAhead < 128 ) ) )
+                {
+                    for ( int i = 0; i < MESS_WINDOW_SIZE; i++ )
+                    {
+                        RecWindow[i].bValid = false;
+                    }
+
+                    iRecWindowNextCnt = iWindowStart;
+                    bRecWindowSynced  = true;
+                }
+
+                bWindowChecked = true;
+            }
+
+            ReceiveWindowedMessage ( vecbyMesBodyData, iRecCounter, iRecID, vecAcknContainerData );
+        }
+    }
+
+    // all acknowledgements are sent in one container
+    if ( vecAcknContainerData.Size() > 0 )
+    {
+        CVector<uint8_t> vecAcknContainer;
+
+        GenMessageFrame ( vecAcknContainer, 0, PROTMESSID_SPECIAL_WINDOWED_MESSAGES, vecAcknContainerData );
+
+        emit MessReadyForSending ( vecAcknContainer );
+    }
+}
+
+void CProtocol::ReceiveWindowedMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                                         const int               iRecCounter,
+                                         const int               iRecID,
+                                         CVector<uint8_t>&       vecAcknContainerData )
+{
+    const int iAhead = static_cast<uint8_t> ( iRecCounter - iRecWindowNextCnt );
+
+    if ( ( iAhead >= MESS_WINDOW_SIZE ) && ( iAhead < 256 - MESS_WINDOW_SIZE ) )
+    {
+        // outside of the window, ignore the message
+        return;
+    }
+
+    // acknowledge the message (this includes old messages which we have already
+    // evaluated but the acknowledgement did not make it to the sender)
+    CVector<uint8_t> vecAcknData ( 2 );
+    CVector<uint8_t> vecAcknMessage;
+    int              iPos = 0;
+
+    PutValOnStream ( vecAcknData, iPos, static_cast<uint32_t> ( iRecID ), 2 );
+    GenMessageFrame ( vecAcknMessage, iRecCounter, PROTMESSID_ACKN, vecAcknData );
+
+    if ( vecAcknContainerData.Size() == 0 )
+    {
+        // the window start is not used by the receiver of acknowledgements
+        vecAcknContainerData.Add ( 0 );
+    }
+
+    vecAcknContainerData.insert ( vecAcknContainerData.end(), vecAcknMessage.begin(), vecAcknMessage.end() );
+
+    if ( iAhead >= MESS_WINDOW_SIZE )
+    {
+        // old message, already evaluated
+        return;
+    }
+
+    if ( iAhead > 0 )
+    {
+        // a previous message is missing, store the message until it arrives
+        CRecWindowSlot& Slot = RecWindow[iRecCounter % MESS_WINDOW_SIZE];
+
+        if ( !Slot.bValid )
+        {
+            Slot.vecData.Init ( vecbyMesBodyData.Size() );
+            Slot.vecData = vecbyMesBodyData;
+            Slot.iID     = iRecID;
+            Slot.iCnt    = iRecCounter;
+            Slot.bValid  = true;
+        }
+        return;
+    }
+
+    // this is the next expected message (if the message was already evaluated
+    // before the windowed mode was started, it is not evaluated again)
+    if ( ( iOldRecID != iRecID ) || ( iOldRecCnt != iRecCounter ) )
+    {
+        EvaluateMessageBody ( vecbyMesBodyData, iRecID );
+
+        iOldRecID  = iRecID;
+        iOldRecCnt = iRecCounter;
+    }
+
+    iRecWindowNextCnt++;
+
+    // evaluate the stored messages which follow without a gap
+    for ( ;; )
+    {
+        CRecWindowSlot& Slot = RecWindow[iRecWindowNextCnt % MESS_WINDOW_SIZE];
+
+        if ( !Slot.bValid || ( Slot.iCnt != iRecWindowNextCnt ) )
+        {
+            break;
+        }
+
+        Slot.bValid = false;
+
+        EvaluateMessageBody ( Slot.vecData, Slot.iID );
+
+        iOldRecID  = Slot.iID;
+        iOldRecCnt = Slot.iCnt;
+
+        iRecWindowNextCnt++;
+    }
+}
+
+void CProtocol::SetWindowedMessagesSupported ( const bool bIn )
+{
+    Mutex.lock();
+    {
+        bWindowedMessagesSupported = bIn;
+    }
+    Mutex.unlock();
+
+    // the messages which are already queued are sent in the window now
+    if ( bIn )
+    {
+        SendWindowedMessages ( false );
+    }
+}
+
 void CProtocol::CreateAndSendMessage ( const int iID, const CVector<uint8_t>& vecData )
 {
-    CVector<uint8_t> vecNewMessage;
-    int              iCurCounter;
-    const int        iDataLen = vecData.Size();
+    const int iDataLen = vecData.Size();
 
     // check if message has to be split because it is too large
     if ( bSplitMessageSupported && ( iDataLen > MESS_SPLIT_PART_SIZE_BYTES ) )
@@ -552,40 +957,14 @@ void CProtocol::CreateAndSendMessage ( const int iID, const CVector<uint8_t>& ve
             // increment the start index of the source data by the last part size
             iStartIndexInData += iCurPartSize;
 
-            Mutex.lock();
-            {
-                // store current counter value
-                iCurCounter = iCounter;
-
-                // increase counter (wraps around automatically)
-                iCounter++;
-            }
-            Mutex.unlock();
-
-            // build complete message
-            GenMessageFrame ( vecNewMessage, iCurCounter, PROTMESSID_SPECIAL_SPLIT_MESSAGE, vecNewSplitMessage );
-
-            // enqueue message
-            EnqueueMessage ( vecNewMessage, iCurCounter, PROTMESSID_SPECIAL_SPLIT_MESSAGE );
+            // build complete message and enqueue it
+            EnqueueMessage ( PROTMESSID_SPECIAL_SPLIT_MESSAGE, vecNewSplitMessage );
         }
     }
     else
     {
-        Mutex.lock();
-        {
-            // store current counter value
-            iCurCounter = iCounter;
-
-            // increase counter (wraps around automatically)
-            iCounter++;
-        }
-        Mutex.unlock();
-
-        // build complete message
-        GenMessageFrame ( vecNewMessage, iCurCounter, iID, vecData );
-
-        // enqueue message
-        EnqueueMessage ( vecNewMessage, iCurCounter, iID );
+        // build complete message and enqueue it
+        EnqueueMessage ( iID, vecData );
     }
 }
 
@@ -617,6 +996,23 @@ void CProtocol::CreateAndImmSendConLessMessage ( const int iID, const CVector<ui
     emit CLMessReadyForSending ( InetAddr, vecNewMessage );
 }
 
+void CProtocol::CreateAndImmSendConLessMessage ( const int                    iID,
+                                                 const CVector<uint8_t>&      vecData,
+                                                 const CVector<CHostAddress>& vecInetAddr,
+                                                 const int                    iNumAddr )
+{
+    CVector<uint8_t> vecNewMessage;
+
+    // since there is no counter for connection less messages, the frame
+    // including the CRC is identical for all receivers and is built only once
+    GenMessageFrame ( vecNewMessage, 0, iID, vecData );
+
+    for ( int i = 0; i < iNumAddr; i++ )
+    {
+        emit CLMessReadyForSending ( vecInetAddr[i], vecNewMessage );
+    }
+}
+
 void CProtocol::ParseMessageBody ( const CVector<uint8_t>& vecbyMesBodyData, const int iRecCounter, const int iRecID )
 {
     // clang-format off
@@ -626,6 +1022,14 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
 */
     // clang-format on
 
+    // the container of the windowed mode is not acknowledged itself, only the
+    // messages in it are
+    if ( iRecID == PROTMESSID_SPECIAL_WINDOWED_MESSAGES )
+    {
+        ParseWindowedMessagesContainer ( vecbyMesBodyData );
+        return;
+    }
+
     // In case we received a message and returned an answer but our answer
     // did not make it to the receiver, he will resend his message. We check
     // here if the message is the same as the old one, and if this is the
@@ -650,192 +1054,188 @@ if ( rand() < ( RAND_MAX / 2 ) ) return false;
                 return;
             }
 
-            // extract data from stream and emit signal for received value
-            bool      bSendNextMess = false;
-            int       iPos          = 0;
-            const int iData         = static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) );
+            // extract data from stream and evaluate the acknowledgement
+            int iPos = 0;
 
-            Mutex.lock();
-            {
-                // check if this is the correct acknowledgment
-                if ( !SendMessQueue.empty() )
-                {
-                    if ( ( SendMessQueue.front().iCnt == iRecCounter ) && ( SendMessQueue.front().iID == iData ) )
-                    {
-                        // message acknowledged, remove from queue
-                        SendMessQueue.pop_front();
-
-                        // send next message in queue
-                        bSendNextMess = true;
-                    }
-                }
-            }
-            Mutex.unlock();
-
-            if ( bSendNextMess )
-            {
-                SendMessage();
-            }
+            EvaluateAcknMes ( static_cast<int> ( GetValFromStream ( vecbyMesBodyData, iPos, 2 ) ), iRecCounter );
         }
         else
         {
-            CVector<uint8_t> vecbyMesBodyDataSplitMess;
-            int              iRecIDModified   = iRecID;
-            bool             bEvaluateMessage = false;
+            // a regular message means that the peer does not use the windowed
+            // mode (anymore), the receive window is synchronized again with the
+            // next container
+            bRecWindowSynced = false;
 
-            // check for special ID first
-            if ( iRecID == PROTMESSID_SPECIAL_SPLIT_MESSAGE )
-            {
-                // Split message management ------------------------------------
-                int iOriginalID;
-                int iReceivedNumParts;
-                int iReceivedSplitCnt;
-                int iCurPartSize;
-
-                if ( !ParseSplitMessageContainer ( vecbyMesBodyData,
-                                                   vecbySplitMessageStorage,
-                                                   iSplitMessageDataIndex,
-                                                   iOriginalID,
-                                                   iReceivedNumParts,
-                                                   iReceivedSplitCnt,
-                                                   iCurPartSize ) )
-                {
-                    // consistency checks
-                    if ( ( iSplitMessageCnt != iReceivedSplitCnt ) || ( iSplitMessageCnt >= iReceivedNumParts ) ||
-                         ( iSplitMessageCnt >= MAX_NUM_MESS_SPLIT_PARTS ) )
-                    {
-                        // in case of an error we reset the split message counter
-                        iSplitMessageCnt       = 0;
-                        iSplitMessageDataIndex = 0;
-                    }
-                    else
-                    {
-                        // update counter and message data index since we have received a valid new part
-                        iSplitMessageCnt++;
-                        iSplitMessageDataIndex += iCurPartSize;
-
-                        // check if the split part messages was completely received
-                        if ( iSplitMessageCnt == iReceivedNumParts )
-                        {
-                            // the split message is completely received, copy data for parsing
-                            vecbyMesBodyDataSplitMess.Init ( iSplitMessageDataIndex );
-
-                            std::copy ( vecbySplitMessageStorage.begin(),
-                                        vecbySplitMessageStorage.begin() + iSplitMessageDataIndex,
-                                        vecbyMesBodyDataSplitMess.begin() );
-
-                            // the received ID is still PROTMESSID_SPECIAL_SPLIT_MESSAGE, set it to
-                            // the ID of the original reconstructed split message now
-                            iRecIDModified = iOriginalID;
-
-                            // the complete split message was reconstructed, reset the counter for
-                            // the next split message
-                            iSplitMessageCnt       = 0;
-                            iSplitMessageDataIndex = 0;
-                            bEvaluateMessage       = true;
-                        }
-                    }
-                }
-            }
-            else
+            EvaluateMessageBody ( vecbyMesBodyData, iRecID );
+
+            // immediately send acknowledge message
+            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+
+            // save current message ID and counter to find out if message
+            // was resent
+            iOldRecID  = iRecID;
+            iOldRecCnt = iRecCounter;
+        }
+    }
+}
+
+void CProtocol::EvaluateMessageBody ( const CVector<uint8_t>& vecbyMesBodyData, const int iRecID )
+{
+    CVector<uint8_t> vecbyMesBodyDataSplitMess;
+    int              iRecIDModified   = iRecID;
+    bool             bEvaluateMessage = false;
+
+    // check for special ID first
+    if ( iRecID == PROTMESSID_SPECIAL_SPLIT_MESSAGE )
+    {
+        // Split message management --------------------------------------------
+        int iOriginalID;
+        int iReceivedNumParts;
+        int iReceivedSplitCnt;
+        int iCurPartSize;
+
+        if ( !ParseSplitMessageContainer ( vecbyMesBodyData,
+                                           vecbySplitMessageStorage,
+                                           iSplitMessageDataIndex,
+                                           iOriginalID,
+                                           iReceivedNumParts,
+                                           iReceivedSplitCnt,
+                                           iCurPartSize ) )
+        {
+            // consistency checks
+            if ( ( iSplitMessageCnt != iReceivedSplitCnt ) || ( iSplitMessageCnt >= iReceivedNumParts ) ||
+                 ( iSplitMessageCnt >= MAX_NUM_MESS_SPLIT_PARTS ) )
             {
-                // a non-split message was received, reset split message counter and directly evaluate message
+                // in case of an error we reset the split message counter
                 iSplitMessageCnt       = 0;
                 iSplitMessageDataIndex = 0;
-                bEvaluateMessage       = true;
             }
-
-            if ( bEvaluateMessage )
+            else
             {
-                // use a reference to either the original data vector or the reconstructed
-                // split message to avoid unnecessary copying
-                const CVector<uint8_t>& vecbyMesBodyDataRef =
-                    ( iRecID == PROTMESSID_SPECIAL_SPLIT_MESSAGE ) ? vecbyMesBodyDataSplitMess : vecbyMesBodyData;
+                // update counter and message data index since we have received a valid new part
+                iSplitMessageCnt++;
+                iSplitMessageDataIndex += iCurPartSize;
 
-                // check which type of message we received and do action
-                switch ( iRecIDModified )
+                // check if the split part messages was completely received
+                if ( iSplitMessageCnt == iReceivedNumParts )
                 {
-                case PROTMESSID_JITT_BUF_SIZE:
-                    EvaluateJitBufMes ( vecbyMesBodyDataRef );
-                    break;
+                    // the split message is completely received, copy data for parsing
+                    vecbyMesBodyDataSplitMess.Init ( iSplitMessageDataIndex );
+
+                    std::copy ( vecbySplitMessageStorage.begin(),
+                                vecbySplitMessageStorage.begin() + iSplitMessageDataIndex,
+                                vecbyMesBodyDataSplitMess.begin() );
+
+                    // the received ID is still PROTMESSID_SPECIAL_SPLIT_MESSAGE, set it to
+                    // the ID of the original reconstructed split message now
+                    iRecIDModified = iOriginalID;
+
+                    // the complete split message was reconstructed, reset the counter for
+                    // the next split message
+                    iSplitMessageCnt       = 0;
+                    iSplitMessageDataIndex = 0;
+                    bEvaluateMessage       = true;
+                }
+            }
+        }
+    }
+    else
+    {
+        // a non-split message was received, reset split message counter and directly evaluate message
+        iSplitMessageCnt       = 0;
+        iSplitMessageDataIndex = 0;
+        bEvaluateMessage       = true;
+    }
 
-                case PROTMESSID_REQ_JITT_BUF_SIZE:
-                    EvaluateReqJitBufMes();
-                    break;
+    if ( bEvaluateMessage )
+    {
+        // use a reference to either the original data vector or the reconstructed
+        // split message to avoid unnecessary copying
+        const CVector<uint8_t>& vecbyMesBodyDataRef =
+            ( iRecID == PROTMESSID_SPECIAL_SPLIT_MESSAGE ) ? vecbyMesBodyDataSplitMess : vecbyMesBodyData;
 
-                case PROTMESSID_CLIENT_ID:
-                    EvaluateClientIDMes ( vecbyMesBodyDataRef );
-                    break;
+        // check which type of message we received and do action
+        switch ( iRecIDModified )
+        {
+        case PROTMESSID_JITT_BUF_SIZE:
+            EvaluateJitBufMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_CHANNEL_GAIN:
-                    EvaluateChanGainMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_REQ_JITT_BUF_SIZE:
+            EvaluateReqJitBufMes();
+            break;
 
-                case PROTMESSID_CHANNEL_PAN:
-                    EvaluateChanPanMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_CLIENT_ID:
+            EvaluateClientIDMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_MUTE_STATE_CHANGED:
-                    EvaluateMuteStateHasChangedMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_CHANNEL_GAIN:
+            EvaluateChanGainMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_CONN_CLIENTS_LIST:
-                    EvaluateConClientListMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_CHANNEL_PAN:
+            EvaluateChanPanMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_REQ_CONN_CLIENTS_LIST:
-                    EvaluateReqConnClientsList();
-                    break;
+        case PROTMESSID_MUTE_STATE_CHANGED:
+            EvaluateMuteStateHasChangedMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_CHANNEL_INFOS:
-                    EvaluateChanInfoMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_CONN_CLIENTS_LIST:
+            EvaluateConClientListMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_REQ_CHANNEL_INFOS:
-                    EvaluateReqChanInfoMes();
-                    break;
+        case PROTMESSID_REQ_CONN_CLIENTS_LIST:
+            EvaluateReqConnClientsList();
+            break;
 
-                case PROTMESSID_CHAT_TEXT:
-                    EvaluateChatTextMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_CHANNEL_INFOS:
+            EvaluateChanInfoMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_NETW_TRANSPORT_PROPS:
-                    EvaluateNetwTranspPropsMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_REQ_CHANNEL_INFOS:
+            EvaluateReqChanInfoMes();
+            break;
 
-                case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
-                    EvaluateReqNetwTranspPropsMes();
-                    break;
+        case PROTMESSID_CHAT_TEXT:
+            EvaluateChatTextMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_REQ_SPLIT_MESS_SUPPORT:
-                    EvaluateReqSplitMessSupportMes();
-                    break;
+        case PROTMESSID_NETW_TRANSPORT_PROPS:
+            EvaluateNetwTranspPropsMes ( vecbyMesBodyDataRef );
+            break;
 
-                case PROTMESSID_SPLIT_MESS_SUPPORTED:
-                    EvaluateSplitMessSupportedMes();
-                    break;
+        case PROTMESSID_REQ_NETW_TRANSPORT_PROPS:
+            EvaluateReqNetwTranspPropsMes();
+            break;
 
-                case PROTMESSID_LICENCE_REQUIRED:
-                    EvaluateLicenceRequiredMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_REQ_SPLIT_MESS_SUPPORT:
+            EvaluateReqSplitMessSupportMes();
+            break;
 
-                case PROTMESSID_VERSION_AND_OS:
-                    EvaluateVersionAndOSMes ( vecbyMesBodyDataRef );
-                    break;
+        case PROTMESSID_SPLIT_MESS_SUPPORTED:
+            EvaluateSplitMessSupportedMes();
+            break;
 
-                case PROTMESSID_RECORDER_STATE:
-                    EvaluateRecorderStateMes ( vecbyMesBodyDataRef );
-                    break;
-                }
-            }
+        case PROTMESSID_REQ_WINDOWED_MESS_SUPPORT:
+            EvaluateReqWindowedMessSupportMes();
+            break;
 
-            // immediately send acknowledge message
-            CreateAndImmSendAcknMess ( iRecID, iRecCounter );
+        case PROTMESSID_WINDOWED_MESS_SUPPORTED:
+            EvaluateWindowedMessSupportedMes();
+            break;
 
-            // save current message ID and counter to find out if message
-            // was resent
-            iOldRecID  = iRecID;
-            iOldRecCnt = iRecCounter;
+        case PROTMESSID_LICENCE_REQUIRED:
+            EvaluateLicenceRequiredMes ( vecbyMesBodyDataRef );
+            break;
+
+        case PROTMESSID_VERSION_AND_OS:
+            EvaluateVersionAndOSMes ( vecbyMesBodyDataRef );
+            break;
+
+        case PROTMESSID_RECORDER_STATE:
+            EvaluateRecorderStateMes ( vecbyMesBodyDataRef );
+            break;
         }
     }
 }
@@ -1123,12 +1523,28 @@ bool CProtocol::EvaluateMuteStateHasChangedMes ( const CVector<uint8_t>& vecData
 }
 
 void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo )
+{
+    CVector<uint8_t> vecData;
+
+    GenConClientListMesData ( vecChanInfo, vecData );
+
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecData );
+}
+
+void CProtocol::CreateConClientListMes ( const CVector<uint8_t>& vecConClientListData )
+{
+    // the data was serialized once for all channels by GenConClientListMesData(),
+    // only the framing with our own counter is done here
+    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecConClientListData );
+}
+
+void CProtocol::GenConClientListMesData ( const CVector<CChannelInfo>& vecChanInfo, CVector<uint8_t>& vecData )
 {
     const int iNumClients = vecChanInfo.Size();
 
     // build data vector
-    CVector<uint8_t> vecData ( 0 );
-    int              iPos = 0; // init position pointer
+    vecData.Init ( 0 );
+    int iPos = 0; // init position pointer
 
     for ( int i = 0; i < iNumClients; i++ )
     {
@@ -1169,8 +1585,6 @@ void CProtocol::CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInf
         // city
         PutStringUTF8OnStream ( vecData, iPos, strUTF8City );
     }
-
-    CreateAndSendMessage ( PROTMESSID_CONN_CLIENTS_LIST, vecData );
 }
 
 bool CProtocol::EvaluateConClientListMes ( const CVector<uint8_t>& vecData )
@@ -1523,6 +1937,26 @@ bool CProtocol::EvaluateSplitMessSupportedMes()
     return false; // no error
 }
 
+void CProtocol::CreateReqWindowedMessSupportMes() { CreateAndSendMessage ( PROTMESSID_REQ_WINDOWED_MESS_SUPPORT, CVector<uint8_t> ( 0 ) ); }
+
+bool CProtocol::EvaluateReqWindowedMessSupportMes()
+{
+    // invoke message action
+    emit ReqWindowedMessSupport();
+
+    return false; // no error
+}
+
+void CProtocol::CreateWindowedMessSupportedMes() { CreateAndSendMessage ( PROTMESSID_WINDOWED_MESS_SUPPORTED, CVector<uint8_t> ( 0 ) ); }
+
+bool CProtocol::EvaluateWindowedMessSupportedMes()
+{
+    // invoke message action
+    emit WindowedMessSupported();
+
+    return false; // no error
+}
+
 void CProtocol::CreateLicenceRequiredMes ( const ELicenceType eLicenceType )
 {
     CVector<uint8_t> vecData ( 1 ); // 1 bytes of data
@@ -2490,11 +2924,31 @@ bool CProtocol::EvaluateCLReqConnClientsListMes ( const CHostAddress& InetAddr )
 }
 
 void CProtocol::CreateCLChannelLevelListMes ( const CHostAddress& InetAddr, const CVector<uint16_t>& vecLevelList, const int iNumClients )
+{
+    CVector<uint8_t> vecData;
+
+    GenCLChannelLevelListMesData ( vecLevelList, iNumClients, vecData );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_CHANNEL_LEVEL_LIST, vecData, InetAddr );
+}
+
+void CProtocol::CreateCLChannelLevelListMes ( const CVector<CHostAddress>& vecInetAddr, const CVector<uint16_t>& vecLevelList, const int iNumClients )
+{
+    // the same level list is sent to the first iNumClients addresses
+    CVector<uint8_t> vecData;
+
+    GenCLChannelLevelListMesData ( vecLevelList, iNumClients, vecData );
+
+    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_CHANNEL_LEVEL_LIST, vecData, vecInetAddr, iNumClients );
+}
+
+void CProtocol::GenCLChannelLevelListMesData ( const CVector<uint16_t>& vecLevelList, const int iNumClients, CVector<uint8_t>& vecData )
 {
     // This must be a multiple of bytes at four bits per client
-    const int        iNumBytes = ( iNumClients + 1 ) / 2;
-    CVector<uint8_t> vecData ( iNumBytes );
-    int              iPos = 0; // init position pointer
+    const int iNumBytes = ( iNumClients + 1 ) / 2;
+    int       iPos      = 0; // init position pointer
+
+    vecData.Init ( iNumBytes );
 
     for ( int i = 0, j = 0; i < iNumClients; i += 2 /* pack two per byte */, j++ )
     {
@@ -2504,8 +2958,6 @@ void CProtocol::CreateCLChannelLevelListMes ( const CHostAddress& InetAddr, cons
 
         PutValOnStream ( vecData, iPos, static_cast<uint32_t> ( byte ), 1 );
     }
-
-    CreateAndImmSendConLessMessage ( PROTMESSID_CLM_CHANNEL_LEVEL_LIST, vecData, InetAddr );
 }
 
 bool CProtocol::EvaluateCLChannelLevelListMes ( const CHostAddress& InetAddr, const CVector<uint8_t>& vecData )
@@ -2591,35 +3043,25 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
                                     int&                    iCnt,
                                     int&                    iID )
 {
-    int i;
-    int iCurPos;
-
     // vector must be at least "MESS_LEN_WITHOUT_DATA_BYTE" bytes long
-    if ( iNumBytesIn < MESS_LEN_WITHOUT_DATA_BYTE )
+    if ( ( iNumBytesIn < MESS_LEN_WITHOUT_DATA_BYTE ) || ( vecbyData.Size() < iNumBytesIn ) )
     {
         return true; // return error code
     }
 
-    // Decode header -----------------------------------------------------------
-    iCurPos = 0; // start from beginning
-
-    // 2 bytes TAG
-    const int iTag = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
+    // the frame is validated directly on the contiguous buffer (all values are
+    // stored with the least significant byte first)
+    const uint8_t* pbyData = &vecbyData[0];
 
-    // check if tag is correct
-    if ( iTag != 0 )
+    // Decode header -----------------------------------------------------------
+    // 2 bytes TAG (check if tag is correct, this rejects most audio packets)
+    if ( ( pbyData[0] | pbyData[1] ) != 0 )
     {
         return true; // return error code
     }
 
-    // 2 bytes ID
-    iID = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
-
-    // 1 byte cnt
-    iCnt = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 1 ) );
-
-    // 2 bytes length
-    const int iLenBy = static_cast<int> ( GetValFromStream ( vecbyData, iCurPos, 2 ) );
+    // 2 bytes ID, 1 byte cnt, 2 bytes length
+    const int iLenBy = pbyData[5] | ( pbyData[6] << 8 );
 
     // make sure the length is correct
     if ( iLenBy != iNumBytesIn - MESS_LEN_WITHOUT_DATA_BYTE )
@@ -2628,36 +3070,24 @@ bool CProtocol::ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
     }
 
     // Now check CRC -----------------------------------------------------------
-    CCRC CRCObj;
-
     const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iLenBy;
 
-    iCurPos = 0; // start from the beginning
-
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecbyData, iCurPos, 1 ) ) );
-    }
-
-    if ( CRCObj.GetCRC() != GetValFromStream ( vecbyData, iCurPos, 2 ) )
+    if ( CCRC::Calc ( pbyData, iLenCRCCalc ) != static_cast<uint32_t> ( pbyData[iLenCRCCalc] | ( pbyData[iLenCRCCalc + 1] << 8 ) ) )
     {
         return true; // return error code
     }
 
-    // Extract actual data -----------------------------------------------------
-
-    // clang-format off
-// TODO this memory allocation is done in the real time thread but should be
-//      done in the low priority protocol management thread
-    // clang-format on
+    iID  = pbyData[2] | ( pbyData[3] << 8 );
+    iCnt = pbyData[4];
 
+    // Extract actual data -----------------------------------------------------
+    // Init() keeps the capacity of the vector, so there is no memory allocation
+    // in the real time thread if the caller reuses a large enough vector
     vecbyMesBodyData.Init ( iLenBy );
 
-    iCurPos = MESS_HEADER_LENGTH_BYTE; // start from beginning of data
-
-    for ( i = 0; i < iLenBy; i++ )
+    if ( iLenBy > 0 )
     {
-        vecbyMesBodyData[i] = static_cast<uint8_t> ( GetValFromStream ( vecbyData, iCurPos, 1 ) );
+        memcpy ( &vecbyMesBodyData[0], pbyData + MESS_HEADER_LENGTH_BYTE, iLenBy );
     }
 
     return false; // no error
@@ -2777,8 +3207,6 @@ QLocale::Country CProtocol::GetCountryFromStream ( const CVector<uint8_t>& vecIn
 
 void CProtocol::GenMessageFrame ( CVector<uint8_t>& vecOut, const int iCnt, const int iID, const CVector<uint8_t>& vecData )
 {
-    int i;
-
     // query length of data vector
     const int iDataLenByte = vecData.Size();
 
@@ -2788,40 +3216,36 @@ void CProtocol::GenMessageFrame ( CVector<uint8_t>& vecOut, const int iCnt, cons
     // init message vector
     vecOut.Init ( iTotLenByte );
 
-    // Encode header -----------------------------------------------------------
-    int iCurPos = 0; // init position pointer
+    uint8_t* pbyOut = &vecOut[0];
 
+    // Encode header (least significant byte first) ----------------------------
     // 2 bytes TAG (all zero bits)
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( 0 ), 2 );
+    pbyOut[0] = 0;
+    pbyOut[1] = 0;
 
     // 2 bytes ID
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( iID ), 2 );
+    pbyOut[2] = static_cast<uint8_t> ( iID & 0xFF );
+    pbyOut[3] = static_cast<uint8_t> ( ( iID >> 8 ) & 0xFF );
 
     // 1 byte cnt
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( iCnt ), 1 );
+    pbyOut[4] = static_cast<uint8_t> ( iCnt & 0xFF );
 
     // 2 bytes length
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( iDataLenByte ), 2 );
+    pbyOut[5] = static_cast<uint8_t> ( iDataLenByte & 0xFF );
+    pbyOut[6] = static_cast<uint8_t> ( ( iDataLenByte >> 8 ) & 0xFF );
 
     // encode data -----
-    for ( i = 0; i < iDataLenByte; i++ )
+    if ( iDataLenByte > 0 )
     {
-        PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( vecData[i] ), 1 );
+        memcpy ( pbyOut + MESS_HEADER_LENGTH_BYTE, &vecData[0], iDataLenByte );
     }
 
     // Encode CRC --------------------------------------------------------------
-    CCRC CRCObj;
-
-    iCurPos = 0; // start from beginning
-
-    const int iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iDataLenByte;
-
-    for ( i = 0; i < iLenCRCCalc; i++ )
-    {
-        CRCObj.AddByte ( static_cast<uint8_t> ( GetValFromStream ( vecOut, iCurPos, 1 ) ) );
-    }
+    const int      iLenCRCCalc = MESS_HEADER_LENGTH_BYTE + iDataLenByte;
+    const uint32_t iCRC        = CCRC::Calc ( pbyOut, iLenCRCCalc );
 
-    PutValOnStream ( vecOut, iCurPos, static_cast<uint32_t> ( CRCObj.GetCRC() ), 2 );
+    pbyOut[iLenCRCCalc]     = static_cast<uint8_t> ( iCRC & 0xFF );
+    pbyOut[iLenCRCCalc + 1] = static_cast<uint8_t> ( ( iCRC >> 8 ) & 0xFF );
 }
 
 void CProtocol::GenSplitMessageContainer ( CVector<uint8_t>&       vecOut,
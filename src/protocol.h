@@ -25,43 +25,45 @@
 #pragma once
 
 #include <QMutex>
-#include <QTimer>
 #include <QDateTime>
 #include <list>
 #include <cmath>
 #include "global.h"
 #include "util.h"
+#include "timerwheel.h"
 
 /* Definitions ****************************************************************/
 // protocol message IDs
-#define PROTMESSID_ILLEGAL                  0  // illegal ID
-#define PROTMESSID_ACKN                     1  // acknowledge
-#define PROTMESSID_JITT_BUF_SIZE            10 // jitter buffer size
-#define PROTMESSID_REQ_JITT_BUF_SIZE        11 // request jitter buffer size
-#define PROTMESSID_NET_BLSI_FACTOR          12 // OLD (not used anymore)
-#define PROTMESSID_CHANNEL_GAIN             13 // set channel gain for mix
-#define PROTMESSID_CONN_CLIENTS_LIST_NAME   14 // OLD (not used anymore)
-#define PROTMESSID_SERVER_FULL              15 // OLD (not used anymore)
-#define PROTMESSID_REQ_CONN_CLIENTS_LIST    16 // request connected client list
-#define PROTMESSID_CHANNEL_NAME             17 // OLD (not used anymore)
-#define PROTMESSID_CHAT_TEXT                18 // contains a chat text
-#define PROTMESSID_PING_MS                  19 // OLD (not used anymore)
-#define PROTMESSID_NETW_TRANSPORT_PROPS     20 // properties for network transport
-#define PROTMESSID_REQ_NETW_TRANSPORT_PROPS 21 // request properties for network transport
-#define PROTMESSID_DISCONNECTION            22 // OLD (not used anymore)
-#define PROTMESSID_REQ_CHANNEL_INFOS        23 // request channel infos for fader tag
-#define PROTMESSID_CONN_CLIENTS_LIST        24 // channel infos for connected clients
-#define PROTMESSID_CHANNEL_INFOS            25 // set channel infos
-#define PROTMESSID_OPUS_SUPPORTED           26 // tells that OPUS codec is supported
-#define PROTMESSID_LICENCE_REQUIRED         27 // licence required
-#define PROTMESSID_REQ_CHANNEL_LEVEL_LIST   28 // OLD (not used anymore) // TODO needed for compatibility to old servers >= 3.4.6 and <= 3.5.12
-#define PROTMESSID_VERSION_AND_OS           29 // version number and operating system
-#define PROTMESSID_CHANNEL_PAN              30 // set channel pan for mix
-#define PROTMESSID_MUTE_STATE_CHANGED       31 // mute state of your signal at another client has changed
-#define PROTMESSID_CLIENT_ID                32 // current user ID and server status
-#define PROTMESSID_RECORDER_STATE           33 // contains the state of the jam recorder (ERecorderState)
-#define PROTMESSID_REQ_SPLIT_MESS_SUPPORT   34 // request support for split messages
-#define PROTMESSID_SPLIT_MESS_SUPPORTED     35 // split messages are supported
+#define PROTMESSID_ILLEGAL                   0  // illegal ID
+#define PROTMESSID_ACKN                      1  // acknowledge
+#define PROTMESSID_JITT_BUF_SIZE             10 // jitter buffer size
+#define PROTMESSID_REQ_JITT_BUF_SIZE         11 // request jitter buffer size
+#define PROTMESSID_NET_BLSI_FACTOR           12 // OLD (not used anymore)
+#define PROTMESSID_CHANNEL_GAIN              13 // set channel gain for mix
+#define PROTMESSID_CONN_CLIENTS_LIST_NAME    14 // OLD (not used anymore)
+#define PROTMESSID_SERVER_FULL               15 // OLD (not used anymore)
+#define PROTMESSID_REQ_CONN_CLIENTS_LIST     16 // request connected client list
+#define PROTMESSID_CHANNEL_NAME              17 // OLD (not used anymore)
+#define PROTMESSID_CHAT_TEXT                 18 // contains a chat text
+#define PROTMESSID_PING_MS                   19 // OLD (not used anymore)
+#define PROTMESSID_NETW_TRANSPORT_PROPS      20 // properties for network transport
+#define PROTMESSID_REQ_NETW_TRANSPORT_PROPS  21 // request properties for network transport
+#define PROTMESSID_DISCONNECTION             22 // OLD (not used anymore)
+#define PROTMESSID_REQ_CHANNEL_INFOS         23 // request channel infos for fader tag
+#define PROTMESSID_CONN_CLIENTS_LIST         24 // channel infos for connected clients
+#define PROTMESSID_CHANNEL_INFOS             25 // set channel infos
+#define PROTMESSID_OPUS_SUPPORTED            26 // tells that OPUS codec is supported
+#define PROTMESSID_LICENCE_REQUIRED          27 // licence required
+#define PROTMESSID_REQ_CHANNEL_LEVEL_LIST    28 // OLD (not used anymore) // TODO needed for compatibility to old servers >= 3.4.6 and <= 3.5.12
+#define PROTMESSID_VERSION_AND_OS            29 // version number and operating system
+#define PROTMESSID_CHANNEL_PAN               30 // set channel pan for mix
+#define PROTMESSID_MUTE_STATE_CHANGED        31 // mute state of your signal at another client has changed
+#define PROTMESSID_CLIENT_ID                 32 // current user ID and server status
+#define PROTMESSID_RECORDER_STATE            33 // contains the state of the jam recorder (ERecorderState)
+#define PROTMESSID_REQ_SPLIT_MESS_SUPPORT    34 // request support for split messages
+#define PROTMESSID_SPLIT_MESS_SUPPORTED      35 // split messages are supported
+#define PROTMESSID_REQ_WINDOWED_MESS_SUPPORT 36 // request support for windowed messages
+#define PROTMESSID_WINDOWED_MESS_SUPPORTED   37 // windowed messages are supported
 
 // message IDs of connection less messages (CLM)
 // DEFINITION -> start at 1000, end at 1999, see IsConnectionLessMessageID
@@ -85,7 +87,8 @@
 #define PROTMESSID_CLM_RED_SERVER_LIST        1018 // reduced server list
 
 // special IDs
-#define PROTMESSID_SPECIAL_SPLIT_MESSAGE 2001 // a container for split messages
+#define PROTMESSID_SPECIAL_SPLIT_MESSAGE     2001 // a container for split messages
+#define PROTMESSID_SPECIAL_WINDOWED_MESSAGES 2002 // a container for windowed messages
 
 // lengths of message as defined in protocol.cpp file
 #define MESS_HEADER_LENGTH_BYTE    7 // TAG (2), ID (2), cnt (1), length (2)
@@ -98,6 +101,12 @@
 #define MESS_SPLIT_PART_SIZE_BYTES 550
 #define MAX_NUM_MESS_SPLIT_PARTS   ( MAX_SIZE_BYTES_NETW_BUF / MESS_SPLIT_PART_SIZE_BYTES )
 
+// windowed messages parameters: number of unacknowledged messages in flight
+// (must be a power of two and smaller than half of the counter range) and the
+// maximum size of a container in which small messages are coalesced
+#define MESS_WINDOW_SIZE             16
+#define MESS_COALESCE_MAX_SIZE_BYTES 1200
+
 /* Classes ********************************************************************/
 class CProtocol : public QObject
 {
@@ -108,6 +117,7 @@ public:
 
     void Reset();
     void SetSplitMessageSupported ( const bool bIn ) { bSplitMessageSupported = bIn; }
+    void SetWindowedMessagesSupported ( const bool bIn );
 
     void CreateJitBufMes ( const int iJitBufSize );
     void CreateReqJitBufMes();
@@ -116,6 +126,7 @@ public:
     void CreateChanPanMes ( const int iChanID, const float fPan );
     void CreateMuteStateHasChangedMes ( const int iChanID, const bool bIsMuted );
     void CreateConClientListMes ( const CVector<CChannelInfo>& vecChanInfo );
+    void CreateConClientListMes ( const CVector<uint8_t>& vecConClientListData );
     void CreateReqConnClientsList();
     void CreateChanInfoMes ( const CChannelCoreInfo ChanInfo );
     void CreateReqChanInfoMes();
@@ -124,6 +135,8 @@ public:
     void CreateReqNetwTranspPropsMes();
     void CreateReqSplitMessSupportMes();
     void CreateSplitMessSupportedMes();
+    void CreateReqWindowedMessSupportMes();
+    void CreateWindowedMessSupportedMes();
     void CreateLicenceRequiredMes ( const ELicenceType eLicenceType );
     void CreateOpusSupportedMes();
 
@@ -152,6 +165,7 @@ void CreateReqChannelLevelListMes();
     void CreateCLConnClientsListMes ( const CHostAddress& InetAddr, const CVector<CChannelInfo>& vecChanInfo );
     void CreateCLReqConnClientsListMes ( const CHostAddress& InetAddr );
     void CreateCLChannelLevelListMes ( const CHostAddress& InetAddr, const CVector<uint16_t>& vecLevelList, const int iNumClients );
+    void CreateCLChannelLevelListMes ( const CVector<CHostAddress>& vecInetAddr, const CVector<uint16_t>& vecLevelList, const int iNumClients );
     void CreateCLRegisterServerResp ( const CHostAddress& InetAddr, const ESvrRegResult eResult );
 
     static bool ParseMessageFrame ( const CVector<uint8_t>& vecbyData,
@@ -164,6 +178,11 @@ void CreateReqChannelLevelListMes();
 
     void ParseConnectionLessMessageBody ( const CVector<uint8_t>& vecbyMesBodyData, const int iRecID, const CHostAddress& InetAddr );
 
+    // broadcast support: the message data which is identical for all receivers is
+    // serialized only once and then passed to the Create*Mes functions above
+    static void GenConClientListMesData ( const CVector<CChannelInfo>& vecChanInfo, CVector<uint8_t>& vecData );
+    static void GenCLChannelLevelListMesData ( const CVector<uint16_t>& vecLevelList, const int iNumClients, CVector<uint8_t>& vecData );
+
     static bool IsConnectionLessMessageID ( const int iID ) { return ( iID >= 1000 ) && ( iID < 2000 ); }
 
     // this function is public because we need it in the test bench
@@ -173,26 +192,44 @@ protected:
     class CSendMessage
     {
     public:
-        CSendMessage() : vecMessage ( 0 ), iID ( PROTMESSID_ILLEGAL ), iCnt ( 0 ) {}
-        CSendMessage ( const CVector<uint8_t>& nMess, const int iNCnt, const int iNID ) : vecMessage ( nMess ), iID ( iNID ), iCnt ( iNCnt ) {}
+        CSendMessage() : vecMessage ( 0 ), iID ( PROTMESSID_ILLEGAL ), iCnt ( 0 ), bSent ( false ) {}
+        CSendMessage ( const CVector<uint8_t>& nMess, const int iNCnt, const int iNID ) :
+            vecMessage ( nMess ),
+            iID ( iNID ),
+            iCnt ( iNCnt ),
+            bSent ( false )
+        {}
 
         CSendMessage& operator= ( const CSendMessage& NewSendMess )
         {
             vecMessage.Init ( NewSendMess.vecMessage.Size() );
             vecMessage = NewSendMess.vecMessage;
 
-            iID  = NewSendMess.iID;
-            iCnt = NewSendMess.iCnt;
+            iID   = NewSendMess.iID;
+            iCnt  = NewSendMess.iCnt;
+            bSent = NewSendMess.bSent;
             return *this;
         }
 
         CVector<uint8_t> vecMessage;
         int              iID, iCnt;
+        bool             bSent; // only used in the windowed mode
+    };
+
+    // a message of the windowed mode which was received ahead of a missing one
+    class CRecWindowSlot
+    {
+    public:
+        CRecWindowSlot() : vecData ( 0 ), iID ( PROTMESSID_ILLEGAL ), iCnt ( 0 ), bValid ( false ) {}
+
+        CVector<uint8_t> vecData;
+        int              iID, iCnt;
+        bool             bValid;
     };
 
-    void EnqueueMessage ( CVector<uint8_t>& vecMessage, const int iCnt, const int iID );
+    void EnqueueMessage ( const int iID, const CVector<uint8_t>& vecData );
 
-    void GenMessageFrame ( CVector<uint8_t>& vecOut, const int iCnt, const int iID, const CVector<uint8_t>& vecData );
+    static void GenMessageFrame ( CVector<uint8_t>& vecOut, const int iCnt, const int iID, const CVector<uint8_t>& vecData );
 
     void GenSplitMessageContainer ( CVector<uint8_t>&       vecOut,
                                     const int               iID,
@@ -210,14 +247,14 @@ protected:
                                       int&                    iSplitCnt,
                                       int&                    iCurPartSize );
 
-    void PutValOnStream ( CVector<uint8_t>& vecIn, int& iPos, const uint32_t iVal, const int iNumOfBytes );
+    static void PutValOnStream ( CVector<uint8_t>& vecIn, int& iPos, const uint32_t iVal, const int iNumOfBytes );
 
-    void PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
-                                 int&              iPos,
-                                 const QByteArray& sStringUTF8,
-                                 const int         iNumberOfBytsLen = 2 ); // default is 2 bytes length indicator
+    static void PutStringUTF8OnStream ( CVector<uint8_t>& vecIn,
+                                        int&              iPos,
+                                        const QByteArray& sStringUTF8,
+                                        const int         iNumberOfBytsLen = 2 ); // default is 2 bytes length indicator
 
-    void PutCountryOnStream ( CVector<uint8_t>& vecIn, int& iPos, QLocale::Country eCountry );
+    static void PutCountryOnStream ( CVector<uint8_t>& vecIn, int& iPos, QLocale::Country eCountry );
 
     static uint32_t GetValFromStream ( const CVector<uint8_t>& vecIn, int& iPos, const int iNumOfBytes );
 
@@ -231,10 +268,28 @@ protected:
 
     void SendMessage();
 
+    void SendWindowedMessages ( const bool bRetransmit );
+
+    void ParseWindowedMessagesContainer ( const CVector<uint8_t>& vecbyData );
+
+    void ReceiveWindowedMessage ( const CVector<uint8_t>& vecbyMesBodyData,
+                                  const int               iRecCounter,
+                                  const int               iRecID,
+                                  CVector<uint8_t>&       vecAcknContainerData );
+
+    void EvaluateMessageBody ( const CVector<uint8_t>& vecbyMesBodyData, const int iRecID );
+
+    void EvaluateAcknMes ( const int iAcknID, const int iRecCounter );
+
     void CreateAndSendMessage ( const int iID, const CVector<uint8_t>& vecData );
 
     void CreateAndImmSendConLessMessage ( const int iID, const CVector<uint8_t>& vecData, const CHostAddress& InetAddr );
 
+    void CreateAndImmSendConLessMessage ( const int                    iID,
+                                          const CVector<uint8_t>&      vecData,
+                                          const CVector<CHostAddress>& vecInetAddr,
+                                          const int                    iNumAddr );
+
     bool EvaluateJitBufMes ( const CVector<uint8_t>& vecData );
     bool EvaluateReqJitBufMes();
     bool EvaluateClientIDMes ( const CVector<uint8_t>& vecData );
@@ -250,6 +305,8 @@ protected:
     bool EvaluateReqNetwTranspPropsMes();
     bool EvaluateReqSplitMessSupportMes();
     bool EvaluateSplitMessSupportedMes();
+    bool EvaluateReqWindowedMessSupportMes();
+    bool EvaluateWindowedMessSupportedMes();
     bool EvaluateLicenceRequiredMes ( const CVector<uint8_t>& vecData );
     bool EvaluateVersionAndOSMes ( const CVector<uint8_t>& vecData );
     bool EvaluateRecorderStateMes ( const CVector<uint8_t>& vecData );
@@ -279,16 +336,24 @@ protected:
     uint8_t                 iCounter;
     std::list<CSendMessage> SendMessQueue;
 
-    QTimer TimerSendMess;
-    QMutex Mutex;
+    CTimerWheel::CTimer TimerSendMess;
+    QMutex              Mutex;
 
     CVector<uint8_t> vecbySplitMessageStorage;
     int              iSplitMessageCnt;
     int              iSplitMessageDataIndex;
     bool             bSplitMessageSupported;
 
+    // windowed mode: sending (secured by the mutex) and receive window
+    bool           bWindowedMessagesSupported;
+    bool           bWindowFlushPending;
+    bool           bRecWindowSynced;
+    uint8_t        iRecWindowNextCnt;
+    CRecWindowSlot RecWindow[MESS_WINDOW_SIZE];
+
 public slots:
-    void OnTimerSendMess() { SendMessage(); }
+    void OnTimerSendMess();
+    void OnFlushWindowedMessages() { SendWindowedMessages ( false ); }
 
 signals:
     // transmitting
@@ -313,6 +378,8 @@ signals:
     void ReqNetTranspProps();
     void ReqSplitMessSupport();
     void SplitMessSupported();
+    void ReqWindowedMessSupport();
+    void WindowedMessSupported();
     void LicenceRequired ( ELicenceType eLicenceType );
     void VersionAndOSReceived ( COSUtil::EOpSystemType eOSType, QString strVersion );
     void RecorderStateReceived ( ERecorderState eRecorderState );
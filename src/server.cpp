@@ -23,6 +23,21 @@
 \******************************************************************************/
 
 #include "server.h"
+#include "mixkernels.h"
+
+// get the bit pattern of a float (used for hashing gains/pans)
+static inline uint32_t FloatToBits ( const float fValue )
+{
+    uint32_t iBits;
+    memcpy ( &iBits, &fValue, sizeof ( iBits ) );
+    return iBits;
+}
+
+// get the time since the given time point in ns
+static inline int64_t GetElapsedNs ( const std::chrono::steady_clock::time_point& tStart )
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> ( std::chrono::steady_clock::now() - tStart ).count();
+}
 
 // CHighPrecisionTimer implementation ******************************************
 #ifdef _WIN32
@@ -103,8 +118,15 @@ void CHighPrecisionTimer::OnTimer()
         }
 
         // minimum time error to actual required timer interval is reached,
-        // emit signal for server
-        emit timeout();
+        // call the callback or emit signal for server
+        if ( Callback )
+        {
+            Callback();
+        }
+        else
+        {
+            emit timeout();
+        }
     }
     else
     {
@@ -180,15 +202,17 @@ void CHighPrecisionTimer::run()
     // loop until the thread shall be terminated
     while ( bRun )
     {
-        // call processing routine by fireing signal
-
-        // clang-format off
-// TODO by emit a signal we leave the high priority thread -> maybe use some
-//      other connection type to have something like a true callback, e.g.
-//      "Qt::DirectConnection" -> Can this work?
-        // clang-format on
-
-        emit timeout();
+        // call processing routine directly in this high priority thread if a
+        // callback is set, otherwise by fireing signal (note that by emitting a
+        // signal we leave the high priority thread)
+        if ( Callback )
+        {
+            Callback();
+        }
+        else
+        {
+            emit timeout();
+        }
 
         // now wait until the next buffer shall be processed (we
         // use the "increment method" to make sure we do not introduce
@@ -211,33 +235,80 @@ void CHighPrecisionTimer::run()
 }
 #endif
 
+// CServerFrame implementation *************************************************
+void CServerFrame::Init ( const int iMaxNumChannels )
+{
+    iNumClients = 0;
+
+    vecChanIDsCurConChan.Init ( iMaxNumChannels );
+    vecvecfGains.Init ( iMaxNumChannels );
+    vecvecfPannings.Init ( iMaxNumChannels );
+    vecvecsData.Init ( iMaxNumChannels );
+    vecvecbyCodedData.Init ( iMaxNumChannels );
+    vecNumAudioChannels.Init ( iMaxNumChannels );
+    vecNumFrameSizeConvBlocks.Init ( iMaxNumChannels );
+    vecUseDoubleSysFraSizeConvBuf.Init ( iMaxNumChannels );
+    vecAudioComprType.Init ( iMaxNumChannels );
+    vecChanDisconnected.Init ( iMaxNumChannels, 0 );
+    vecNumMixBusCorrections.Init ( iMaxNumChannels );
+    vecMixSignatureHash.Init ( iMaxNumChannels );
+    vecDecodeTimeNs.Init ( iMaxNumChannels, 0 );
+    vecMixTimeNs.Init ( iMaxNumChannels, 0 );
+    vecEncodeTimeNs.Init ( iMaxNumChannels, 0 );
+    vecSendTimeNs.Init ( iMaxNumChannels, 0 );
+
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        // init vectors storing information of all channels
+        vecvecfGains[i].Init ( iMaxNumChannels );
+        vecvecfPannings[i].Init ( iMaxNumChannels );
+
+        // we always use stereo audio buffers (which is the worst case)
+        vecvecsData[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+
+        // allocate worst case memory for the coded data
+        vecvecbyCodedData[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+}
+
 // CServer implementation ******************************************************
-CServer::CServer ( const int          iNewMaxNumChan,
-                   const QString&     strLoggingFileName,
-                   const QString&     strServerBindIP,
-                   const quint16      iPortNumber,
-                   const quint16      iQosNumber,
-                   const QString&     strHTMLStatusFileName,
-                   const QString&     strDirectoryServer,
-                   const QString&     strServerListFileName,
-                   const QString&     strServerInfo,
-                   const QString&     strServerListFilter,
-                   const QString&     strServerPublicIP,
-                   const QString&     strNewWelcomeMessage,
-                   const QString&     strRecordingDirName,
-                   const bool         bNDisconnectAllClientsOnQuit,
-                   const bool         bNUseDoubleSystemFrameSize,
-                   const bool         bNUseMultithreading,
-                   const bool         bDisableRecording,
-                   const bool         bNDelayPan,
-                   const bool         bNEnableIPv6,
-                   const ELicenceType eNLicenceType ) :
+CServer::CServer ( const int             iNewMaxNumChan,
+                   const QString&        strLoggingFileName,
+                   const QString&        strPacketTraceFileName,
+                   const QString&        strServerBindIP,
+                   const quint16         iPortNumber,
+                   const quint16         iQosNumber,
+                   const QString&        strHTMLStatusFileName,
+                   const QString&        strDirectoryServer,
+                   const QString&        strServerListFileName,
+                   const QString&        strServerInfo,
+                   const QString&        strServerListFilter,
+                   const QString&        strServerPublicIP,
+                   const QString&        strNewWelcomeMessage,
+                   const QString&        strRecordingDirName,
+                   const bool            bNDisconnectAllClientsOnQuit,
+                   const bool            bNUseDoubleSystemFrameSize,
+                   const bool            bNUseMultithreading,
+                   const bool            bNPinWorkers,
+                   const bool            bNUsePipelining,
+                   const bool            bNUseTimerThread,
+                   const int             iNNumRecvThreads,
+                   const bool            bNUseIoUring,
+                   const bool            bDisableRecording,
+                   const bool            bNDelayPan,
+                   const bool            bNEnableIPv6,
+                   const ELicenceType    eNLicenceType,
+                   const EJitBufStrategy eNJitBufStrategy ) :
     bUseDoubleSystemFrameSize ( bNUseDoubleSystemFrameSize ),
     bUseMultithreading ( bNUseMultithreading ),
+    bUsePipelining ( bNUsePipelining ),
     iMaxNumChannels ( iNewMaxNumChan ),
     iCurNumChannels ( 0 ),
-    Socket ( this, iPortNumber, iQosNumber, strServerBindIP, bNEnableIPv6 ),
+    bUseMonoMixBus ( false ),
+    bUseStereoMixBus ( false ),
+    Socket ( this, iPortNumber, iQosNumber, strServerBindIP, bNEnableIPv6, ( iNNumRecvThreads > 1 ) && CSocket::IsReusePortSupported(), bNUseIoUring ),
     Logging(),
+    PacketTrace(),
     iFrameCount ( 0 ),
     bWriteStatusHTMLFile ( false ),
     strServerHTMLFileListName ( strHTMLStatusFileName ),
@@ -258,7 +329,14 @@ CServer::CServer ( const int          iNewMaxNumChan,
     bEnableIPv6 ( bNEnableIPv6 ),
     eLicenceType ( eNLicenceType ),
     bDisconnectAllClientsOnQuit ( bNDisconnectAllClientsOnQuit ),
-    pSignalHandler ( CSignalHandler::getSingletonP() )
+    pSignalHandler ( CSignalHandler::getSingletonP() ),
+    bUseTimerThread ( bNUseTimerThread ),
+    bDeferredEventsPosted ( false ),
+    bChanListChangedPending ( false ),
+    bServerIdlePending ( false ),
+    bChannelLevelsPending ( false ),
+    iDeferredLevelsNumClients ( 0 ),
+    iNumDeadlineMisses ( 0 )
 {
     int iOpusError;
     int i;
@@ -266,22 +344,22 @@ CServer::CServer ( const int          iNewMaxNumChan,
     // create OPUS encoder/decoder for each channel (must be done before
     // enabling the channels), create a mono and stereo encoder/decoder
     // for each channel
-    for ( i = 0; i < iMaxNumChannels; i++ )
-    {
-        // init OPUS -----------------------------------------------------------
-        OpusMode[i] = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES, &iOpusError );
+    // init OPUS (the modes are shared by all channels) -----------------------
+    OpusMode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES, &iOpusError );
 
-        Opus64Mode[i] = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ, SYSTEM_FRAME_SIZE_SAMPLES, &iOpusError );
+    Opus64Mode = opus_custom_mode_create ( SYSTEM_SAMPLE_RATE_HZ, SYSTEM_FRAME_SIZE_SAMPLES, &iOpusError );
 
+    for ( i = 0; i < iMaxNumChannels; i++ )
+    {
         // init audio encoders and decoders
-        OpusEncoderMono[i]     = opus_custom_encoder_create ( OpusMode[i], 1, &iOpusError );   // mono encoder legacy
-        OpusDecoderMono[i]     = opus_custom_decoder_create ( OpusMode[i], 1, &iOpusError );   // mono decoder legacy
-        OpusEncoderStereo[i]   = opus_custom_encoder_create ( OpusMode[i], 2, &iOpusError );   // stereo encoder legacy
-        OpusDecoderStereo[i]   = opus_custom_decoder_create ( OpusMode[i], 2, &iOpusError );   // stereo decoder legacy
-        Opus64EncoderMono[i]   = opus_custom_encoder_create ( Opus64Mode[i], 1, &iOpusError ); // mono encoder OPUS64
-        Opus64DecoderMono[i]   = opus_custom_decoder_create ( Opus64Mode[i], 1, &iOpusError ); // mono decoder OPUS64
-        Opus64EncoderStereo[i] = opus_custom_encoder_create ( Opus64Mode[i], 2, &iOpusError ); // stereo encoder OPUS64
-        Opus64DecoderStereo[i] = opus_custom_decoder_create ( Opus64Mode[i], 2, &iOpusError ); // stereo decoder OPUS64
+        OpusEncoderMono[i]     = opus_custom_encoder_create ( OpusMode, 1, &iOpusError );   // mono encoder legacy
+        OpusDecoderMono[i]     = opus_custom_decoder_create ( OpusMode, 1, &iOpusError );   // mono decoder legacy
+        OpusEncoderStereo[i]   = opus_custom_encoder_create ( OpusMode, 2, &iOpusError );   // stereo encoder legacy
+        OpusDecoderStereo[i]   = opus_custom_decoder_create ( OpusMode, 2, &iOpusError );   // stereo decoder legacy
+        Opus64EncoderMono[i]   = opus_custom_encoder_create ( Opus64Mode, 1, &iOpusError ); // mono encoder OPUS64
+        Opus64DecoderMono[i]   = opus_custom_decoder_create ( Opus64Mode, 1, &iOpusError ); // mono decoder OPUS64
+        Opus64EncoderStereo[i] = opus_custom_encoder_create ( Opus64Mode, 2, &iOpusError ); // stereo encoder OPUS64
+        Opus64DecoderStereo[i] = opus_custom_decoder_create ( Opus64Mode, 2, &iOpusError ); // stereo decoder OPUS64
 
         // we require a constant bit rate
         opus_custom_encoder_ctl ( OpusEncoderMono[i], OPUS_SET_VBR ( 0 ) );
@@ -329,33 +407,41 @@ CServer::CServer ( const int          iNewMaxNumChan,
         iServerFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
     }
 
+    // the frame period is the deadline for the processing of one frame
+    iFramePeriodNs = static_cast<int64_t> ( iServerFrameSizeSamples ) * 1000000000 / SYSTEM_SAMPLE_RATE_HZ;
+
     // To avoid audio clitches, in the entire realtime timer audio processing
     // routine including the ProcessData no memory must be allocated. Since we
     // do not know the required sizes for the vectors, we allocate memory for
     // the worst case here:
 
-    // allocate worst case memory for the temporary vectors
-    vecChanIDsCurConChan.Init ( iMaxNumChannels );
-    vecvecfGains.Init ( iMaxNumChannels );
-    vecvecfPannings.Init ( iMaxNumChannels );
-    vecvecsData.Init ( iMaxNumChannels );
+    // allocate worst case memory for the temporary vectors (the second frame
+    // buffer is only used in pipelined mode)
+    FrameData[0].Init ( iMaxNumChannels );
+    FrameData[1].Init ( bUsePipelining ? iMaxNumChannels : 0 );
     vecvecsData2.Init ( iMaxNumChannels );
     vecvecsSendData.Init ( iMaxNumChannels );
     vecvecfIntermediateProcBuf.Init ( iMaxNumChannels );
-    vecvecbyCodedData.Init ( iMaxNumChannels );
-    vecNumAudioChannels.Init ( iMaxNumChannels );
-    vecNumFrameSizeConvBlocks.Init ( iMaxNumChannels );
-    vecUseDoubleSysFraSizeConvBuf.Init ( iMaxNumChannels );
-    vecAudioComprType.Init ( iMaxNumChannels );
+    vecfMonoMixBus.Init ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+    vecfStereoMixBus.Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+    vecCeltNumCodedBytes.Init ( iMaxNumChannels );
+    vecMixGroupLeader.Init ( iMaxNumChannels );
+    vecMixGroupNext.Init ( iMaxNumChannels );
+    vecMixGroupLeaderList.Init ( iMaxNumChannels );
+    vecMTDecodeChanOrder.Init ( iMaxNumChannels );
+    vecMTDecodeChunkStart.Init ( iMaxNumChannels + 1 );
+    vecMTMixChanOrder.Init ( iMaxNumChannels );
+    vecMTMixChunkStart.Init ( iMaxNumChannels + 1 );
+    vecfDecodeCostUs.Init ( iMaxNumChannels, MT_DEF_DECODE_COST_US );
+    vecfMixEncodeCostUs.Init ( iMaxNumChannels, MT_DEF_MIX_ENCODE_COST_US );
+    vecLastEncoderChanID.Init ( iMaxNumChannels );
 
     for ( i = 0; i < iMaxNumChannels; i++ )
     {
-        // init vectors storing information of all channels
-        vecvecfGains[i].Init ( iMaxNumChannels );
-        vecvecfPannings[i].Init ( iMaxNumChannels );
+        // initially each channel is coded by its own encoder
+        ResetLastEncoder ( i );
 
         // we always use stereo audio buffers (which is the worst case)
-        vecvecsData[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
         vecvecsData2[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
 
         // (note that we only allocate iMaxNumChannels buffers for the send
@@ -364,13 +450,11 @@ CServer::CServer ( const int          iNewMaxNumChan,
 
         // allocate worst case memory for intermediate processing buffers in float precision
         vecvecfIntermediateProcBuf[i].Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
-
-        // allocate worst case memory for the coded data
-        vecvecbyCodedData[i].Init ( MAX_SIZE_BYTES_NETW_BUF );
     }
 
     // allocate worst case memory for the channel levels
     vecChannelLevels.Init ( iMaxNumChannels );
+    vecChannelLevelsAddr.Init ( iMaxNumChannels );
 
     // enable logging (if requested)
     if ( !strLoggingFileName.isEmpty() )
@@ -378,6 +462,12 @@ CServer::CServer ( const int          iNewMaxNumChan,
         Logging.Start ( strLoggingFileName );
     }
 
+    // enable the packet trace (if requested)
+    if ( !strPacketTraceFileName.isEmpty() )
+    {
+        PacketTrace.Start ( strPacketTraceFileName );
+    }
+
     // HTML status file writing
     if ( !strServerHTMLFileListName.isEmpty() )
     {
@@ -411,9 +501,13 @@ CServer::CServer ( const int          iNewMaxNumChan,
     for ( i = 0; i < iMaxNumChannels; i++ )
     {
         vecChannels[i].SetEnable ( true );
+        vecChannels[i].SetJitBufStrategy ( eNJitBufStrategy );
         vecChannelOrder[i] = i;
     }
 
+    ChannelAddrTable.Init ( iMaxNumChannels );
+    vecChanAddrKeys.Init ( iMaxNumChannels );
+
     int iAvailableCores = QThread::idealThreadCount();
 
     // setup CThreadPool if multithreading is active and possible
@@ -430,14 +524,80 @@ CServer::CServer ( const int          iNewMaxNumChan,
             iMaxNumThreads = iAvailableCores;
             qDebug() << "multithreading enabled, setting thread count to" << iMaxNumThreads;
 
-            pThreadPool = std::unique_ptr<CThreadPool> ( new CThreadPool{ static_cast<size_t> ( iMaxNumThreads ) } );
-            Futures.reserve ( iMaxNumThreads );
+            // the timer thread works on the frame as well, so we need one worker less
+            pFrameWorkers = std::unique_ptr<CFrameWorkerPool> ( new CFrameWorkerPool ( iMaxNumThreads - 1, bNPinWorkers ) );
         }
     }
 
+    // pipelining overlaps decoding and mixing on the frame workers
+    if ( bUsePipelining && !bUseMultithreading )
+    {
+        qWarning() << "pipelining requires multithreading, disabling pipelining";
+        bUsePipelining = false;
+    }
+
+    // in pipelined mode the next frame is decoded in the other frame buffer
+    // while the current frame is mixed
+    pDecodeFrame = &FrameData[0];
+    pMixFrame    = bUsePipelining ? &FrameData[1] : &FrameData[0];
+
+    if ( bUsePipelining )
+    {
+        qDebug() << "pipelining enabled, adding one frame of latency";
+    }
+
+    // the audio packets are sent in batches, one batch per frame processing thread
+    vecSendBatches.Init ( bUseMultithreading ? iMaxNumThreads : 1 );
+
+    for ( i = 0; i < vecSendBatches.Size(); i++ )
+    {
+        Socket.InitSendBatch ( vecSendBatches[i] );
+    }
+
+#if ( defined( WIN32 ) || defined( _WIN32 ) )
+    // the high precision timer of Windows fires in the main thread, there is
+    // no timer thread which could process the frames
+    if ( bUseTimerThread )
+    {
+        qWarning() << "the timer thread is not available on Windows, processing the audio frames in the main thread";
+        bUseTimerThread = false;
+    }
+#endif
+
+    // if the frame is processed in the timer thread, everything which touches
+    // Qt objects is deferred to the main thread
+    if ( bUseTimerThread )
+    {
+        DeferredAudioFrames.Init ( DEFERRED_EVENT_QUEUE_NUM_FRAMES * iMaxNumChannels );
+        vecDeferredDisconnChanIDs.Init ( iMaxNumChannels );
+        vecDeferredChannelLevels.Init ( iMaxNumChannels );
+        vecDeferredLevelsChanIDs.Init ( iMaxNumChannels );
+        vecsDeferredAudioData.Init ( 2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */ );
+
+        qDebug() << "processing the audio frames in the timer thread";
+    }
+
+    for ( i = 0; i < MAX_NUM_CHANNELS; i++ )
+    {
+        bClientDisconnectedPending[i] = false;
+        bNewChannelPending[i]         = false;
+    }
+
+    // select the fastest mixing kernels which are supported by this CPU
+    CMixKernels::Init();
+    qDebug() << "using" << CMixKernels::GetImplementationName() << "mix kernels";
+
     // Connections -------------------------------------------------------------
-    // connect timer timeout signal
-    QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout, this, &CServer::OnTimer );
+    // connect timer timeout signal (or call the frame processing directly in
+    // the timer thread)
+    if ( bUseTimerThread )
+    {
+        HighPrecisionTimer.SetCallback ( [this]() { OnTimer(); } );
+    }
+    else
+    {
+        QObject::connect ( &HighPrecisionTimer, &CHighPrecisionTimer::timeout, this, &CServer::OnTimer );
+    }
 
     QObject::connect ( &ConnLessProtocol, &CProtocol::CLMessReadyForSending, this, &CServer::OnSendCLProtMessage );
 
@@ -488,9 +648,42 @@ CServer::CServer ( const int          iNewMaxNumChan,
 
     connectChannelSignalsToServerSlots<MAX_NUM_CHANNELS>();
 
+    // additional receive sockets with their own threads share the port with
+    // the main socket, the kernel distributes the clients over the sockets
+    if ( iNNumRecvThreads > 1 )
+    {
+        if ( !CSocket::IsReusePortSupported() )
+        {
+            qWarning() << "multiple receive threads are not supported on this platform, using one receive thread";
+        }
+        else if ( Socket.IsReusePortEnabled() )
+        {
+            try
+            {
+                for ( i = 1; i < iNNumRecvThreads; i++ )
+                {
+                    vecRecvSockets.emplace_back ( new CHighPrioSocket ( this, iPortNumber, iQosNumber, strServerBindIP, bNEnableIPv6, true, bNUseIoUring ) );
+                }
+
+                qDebug() << "receiving with" << iNNumRecvThreads << "sockets on the server port";
+            }
+            catch ( const CGenErr& )
+            {
+                // an additional socket could not share the port
+                qWarning() << "cannot bind additional receive sockets to the server port, using one receive thread";
+                vecRecvSockets.clear();
+            }
+        }
+    }
+
     // start the socket (it is important to start the socket after all
     // initializations and connections)
     Socket.Start();
+
+    for ( std::unique_ptr<CHighPrioSocket>& pRecvSocket : vecRecvSockets )
+    {
+        pRecvSocket->Start();
+    }
 }
 
 template<unsigned int slotId>
@@ -548,11 +741,11 @@ CServer::~CServer()
         opus_custom_decoder_destroy ( Opus64DecoderMono[i] );
         opus_custom_encoder_destroy ( Opus64EncoderStereo[i] );
         opus_custom_decoder_destroy ( Opus64DecoderStereo[i] );
-
-        // free audio modes
-        opus_custom_mode_destroy ( OpusMode[i] );
-        opus_custom_mode_destroy ( Opus64Mode[i] );
     }
+
+    // free audio modes
+    opus_custom_mode_destroy ( OpusMode );
+    opus_custom_mode_destroy ( Opus64Mode );
 }
 
 void CServer::SendProtMessage ( int iChID, CVector<uint8_t> vecMessage )
@@ -578,6 +771,10 @@ void CServer::OnNewConnection ( int iChID, int iTotChans, CHostAddress RecHostAd
     // query support for split messages in the client
     vecChannels[iChID].CreateReqSplitMessSupportMes();
 
+    // query support for windowed messages in the client (several messages in
+    // flight and coalescing of small messages)
+    vecChannels[iChID].CreateReqWindowedMessSupportMes();
+
     // on a new connection we query the network transport properties for the
     // audio packets (to use the correct network block size and audio
     // compression properties, etc.)
@@ -727,6 +924,9 @@ void CServer::Start()
     // only start if not already running
     if ( !IsRunning() )
     {
+        // the first frame is due after one timer interval
+        tFrameDue = std::chrono::steady_clock::now() + std::chrono::nanoseconds ( iFramePeriodNs );
+
         // start timer
         HighPrecisionTimer.Start();
 
@@ -756,21 +956,30 @@ void CServer::Stop()
 
 void CServer::OnTimer()
 {
-    // clang-format off
-/*
-static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TEST do a timer jitter measurement
-*/
-    // clang-format on
+    // start time of the frame for the timing statistics
+    const auto tFrameStart = std::chrono::steady_clock::now();
+
     // Get data from all connected clients -------------------------------------
     // some inits
-    int  iNumClients          = 0; // init connected client counter
-    bool bUseMT               = false;
-    int  iNumBlocks           = 0;     // init number of blocks for multithreading
-    int  iMTBlockSize         = 0;     // init block size for multithreading
+    CServerFrame& DecodeFrame = *pDecodeFrame;
+    CServerFrame& MixFrame    = *pMixFrame; // same as the decode frame if pipelining is not used
+    int           iNumClients = 0;          // init connected client counter
+    bool          bUseMT      = false;
     bChannelIsNowDisconnected = false; // note that the flag must be a member function since QtConcurrent::run can only take 5 params
 
+    // In pipelined mode the frame which was decoded in the last timer period is
+    // mixed while the current frame is decoded. The mixing itself is done in the
+    // same phase as the decoding below.
+    if ( bUsePipelining && ( MixFrame.iNumClients > 0 ) )
     {
-        // Make put and get calls thread safe.
+        PrepareMixFrame ( MixFrame );
+    }
+
+    {
+        const auto tLockStart = std::chrono::steady_clock::now();
+
+        // Make get calls thread safe (the receive threads do not take this
+        // mutex, see PutAudioData()).
         QMutexLocker locker ( &Mutex );
 
         // first, get number and IDs of connected channels
@@ -778,267 +987,631 @@ static CTimingMeas JitterMeas ( 1000, "test2.dat" ); JitterMeas.Measure(); // TE
         {
             if ( vecChannels[i].IsConnected() )
             {
+                // reset the frame processing state of a new channel (see InitChannel())
+                if ( bNewChannelPending[i] && bNewChannelPending[i].exchange ( false ) )
+                {
+                    ResetLastEncoder ( i );
+
+                    vecfDecodeCostUs[i]    = MT_DEF_DECODE_COST_US;
+                    vecfMixEncodeCostUs[i] = MT_DEF_MIX_ENCODE_COST_US;
+                }
+
                 // add ID and increment counter (note that the vector length is
                 // according to the worst case scenario, if the number of
                 // connected clients is less, only a subset of elements of this
                 // vector are actually used and the others are dummy elements)
-                vecChanIDsCurConChan[iNumClients] = i;
+                DecodeFrame.vecChanIDsCurConChan[iNumClients] = i;
                 iNumClients++;
             }
         }
 
+        DecodeFrame.iNumClients = iNumClients;
+
+        PerfHistograms[PS_LOCK_COLLECT].Add ( GetElapsedNs ( tLockStart ) );
+
         // use multithreading for any non-zero number of clients
         // (overhead is low and it is worth doing for all numbers)
-        bUseMT = bUseMultithreading && iNumClients > 0;
+        bUseMT = bUseMultithreading && ( ( iNumClients > 0 ) || ( MixFrame.iNumClients > 0 ) );
 
         // prepare and decode connected channels
         if ( !bUseMT )
         {
             // run the OPUS decoder for all data blocks
-            DecodeReceiveDataBlocks ( this, 0, iNumClients - 1, iNumClients );
+            DecodeReceiveDataBlocks ( this, DecodeFrame, 0, iNumClients - 1 );
         }
         else
         {
-            // spread work equally among available threads
-            iNumBlocks   = std::min ( iNumClients, iMaxNumThreads );
-            iMTBlockSize = ( iNumClients - 1 ) / iNumBlocks + 1;
-
-            // processing with multithreading
-            for ( int iBlockCnt = 0; iBlockCnt < iNumBlocks; iBlockCnt++ )
-            {
-                // The work for OPUS decoding is distributed over all available processor cores.
-                // By using the future synchronizer we make sure that all
-                // threads are done when we leave the timer callback function.
-                const int iStartChanCnt = iBlockCnt * iMTBlockSize;
-                const int iStopChanCnt  = std::min ( ( iBlockCnt + 1 ) * iMTBlockSize - 1, iNumClients - 1 );
-
-                Futures.push_back ( pThreadPool->enqueue ( CServer::DecodeReceiveDataBlocks, this, iStartChanCnt, iStopChanCnt, iNumClients ) );
-            }
+            // The work for OPUS decoding is distributed over all available processor cores.
+            // The channels are split in chunks of similar estimated cost which are claimed
+            // by idle threads (most expensive first) so that all threads finish at about
+            // the same time. The frame workers return when all chunks are processed.
+            // In pipelined mode the chunks of the mixing of the last frame are processed
+            // in the same phase (they come first since they send the audio packets).
+            const int iNumDecodeChunks = CreateMTChunks ( DecodeFrame, vecfDecodeCostUs, vecMTDecodeChanOrder, vecMTDecodeChunkStart );
+            const int iNumMixChunks    = bUsePipelining ? CreateMTChunks ( MixFrame, vecfMixEncodeCostUs, vecMTMixChanOrder, vecMTMixChunkStart ) : 0;
+
+            auto DecodeChunk = [this, &DecodeFrame, &MixFrame, iNumMixChunks] ( const int iChunkCnt ) {
+                if ( iChunkCnt < iNumMixChunks )
+                {
+                    MixEncodeTransmitDataChunk ( MixFrame, iChunkCnt );
+                }
+                else
+                {
+                    DecodeReceiveDataChunk ( DecodeFrame, iChunkCnt - iNumMixChunks );
+                }
+            };
 
-            // make sure all concurrent run threads have finished when we leave this function
-            for ( auto& future : Futures )
-            {
-                future.wait();
-            }
-            Futures.clear();
+            pFrameWorkers->Run ( iNumMixChunks + iNumDecodeChunks, DecodeChunk );
         }
 
         // a channel is now disconnected, take action on it
         if ( bChannelIsNowDisconnected )
         {
+            // free the disconnected channels now that no frame worker uses them
+            for ( int iChanCnt = 0; iChanCnt < iNumClients; iChanCnt++ )
+            {
+                if ( DecodeFrame.vecChanDisconnected[iChanCnt] != 0 )
+                {
+                    FreeChannel ( DecodeFrame.vecChanIDsCurConChan[iChanCnt] ); // note that the channel is now not in use
+                }
+            }
+
             // update channel list for all currently connected clients
-            CreateAndSendChanListForAllConChannels();
+            if ( bUseTimerThread )
+            {
+                SetDeferredEvent ( bChanListChangedPending );
+            }
+            else
+            {
+                CreateAndSendChanListForAllConChannels();
+            }
         }
     }
 
     // Process data ------------------------------------------------------------
-    // Check if at least one client is connected. If not, stop server until
-    // one client is connected.
-    if ( iNumClients > 0 )
+    if ( !bUsePipelining && ( iNumClients > 0 ) )
     {
-        // calculate levels for all connected clients
-        const bool bSendChannelLevels = CreateLevelsForAllConChannels ( iNumClients, vecNumAudioChannels, vecvecsData, vecChannelLevels );
+        PrepareMixFrame ( MixFrame );
 
-        for ( int iChanCnt = 0; iChanCnt < iNumClients; iChanCnt++ )
+        if ( !bUseMT )
         {
-            // get actual ID of current channel
-            const int iCurChanID = vecChanIDsCurConChan[iChanCnt];
-
-            // update socket buffer size
-            vecChannels[iCurChanID].UpdateSocketBufferSize();
-
-            // send channel levels if they are ready
-            if ( bSendChannelLevels )
+            // generate a separate mix for each channel, OPUS encode the
+            // audio data and transmit the network packet
+            for ( int iChanCnt = 0; iChanCnt < iNumClients; iChanCnt++ )
             {
-                ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannels[iCurChanID].GetAddress(), vecChannelLevels, iNumClients );
+                MixEncodeTransmitData ( MixFrame, iChanCnt, vecSendBatches[0] );
             }
 
-            // export the audio data for recording purpose
-            if ( JamController.GetRecordingEnabled() )
-            {
-                emit AudioFrame ( iCurChanID,
-                                  vecChannels[iCurChanID].GetName(),
-                                  vecChannels[iCurChanID].GetAddress(),
-                                  vecNumAudioChannels[iChanCnt],
-                                  vecvecsData[iChanCnt] );
-            }
+            // send the packets of all channels (the time is accounted to the last channel)
+            const auto tSendStart = std::chrono::steady_clock::now();
 
-            // processing without multithreading
-            if ( !bUseMT )
-            {
-                // generate a separate mix for each channel, OPUS encode the
-                // audio data and transmit the network packet
-                MixEncodeTransmitData ( iChanCnt, iNumClients );
-            }
-        }
+            vecSendBatches[0].Flush();
 
-        // processing with multithreading
-        if ( bUseMT )
+            MixFrame.vecSendTimeNs[iNumClients - 1] += GetElapsedNs ( tSendStart );
+        }
+        else
         {
-            for ( int iBlockCnt = 0; iBlockCnt < iNumBlocks; iBlockCnt++ )
-            {
-                // Generate a separate mix for each channel, OPUS encode the
-                // audio data and transmit the network packet. The work is
-                // distributed over all available processor cores.
-                // By using the future synchronizer we make sure that all
-                // threads are done when we leave the timer callback function.
-                const int iStartChanCnt = iBlockCnt * iMTBlockSize;
-                const int iStopChanCnt  = std::min ( ( iBlockCnt + 1 ) * iMTBlockSize - 1, iNumClients - 1 );
-
-                Futures.push_back ( pThreadPool->enqueue ( CServer::MixEncodeTransmitDataBlocks, this, iStartChanCnt, iStopChanCnt, iNumClients ) );
-            }
+            // Generate a separate mix for each channel, OPUS encode the
+            // audio data and transmit the network packet. The work is
+            // distributed over all available processor cores in chunks of
+            // similar estimated cost (see decoding above).
+            const int iNumChunks = CreateMTChunks ( MixFrame, vecfMixEncodeCostUs, vecMTMixChanOrder, vecMTMixChunkStart );
 
-            // make sure all concurrent run threads have finished when we leave this function
-            for ( auto& fFuture : Futures )
-            {
-                fFuture.wait();
-            }
-            Futures.clear();
+            auto MixEncodeTransmitChunk = [this, &MixFrame] ( const int iChunkCnt ) { MixEncodeTransmitDataChunk ( MixFrame, iChunkCnt ); };
+
+            pFrameWorkers->Run ( iNumChunks, MixEncodeTransmitChunk );
         }
-        if ( bDelayPan )
+    }
+
+    if ( bDelayPan )
+    {
+        for ( int i = 0; i < MixFrame.iNumClients; i++ )
         {
-            for ( int i = 0; i < iNumClients; i++ )
+            for ( int j = 0; j < 2 * ( iServerFrameSizeSamples ); j++ )
             {
-                for ( int j = 0; j < 2 * ( iServerFrameSizeSamples ); j++ )
-                {
-                    vecvecsData2[i][j] = vecvecsData[i][j];
-                }
+                vecvecsData2[i][j] = MixFrame.vecvecsData[i][j];
             }
         }
     }
-    else
+
+    UpdatePerfStats ( DecodeFrame, MixFrame, tFrameStart );
+
+    // the frame which was just decoded is mixed in the next timer period
+    if ( bUsePipelining )
+    {
+        std::swap ( pDecodeFrame, pMixFrame );
+    }
+
+    // Check if at least one client is connected. If not, stop server until
+    // one client is connected.
+    if ( iNumClients == 0 )
     {
         // Disable server if no clients are connected. In this case the server
         // does not consume any significant CPU when no client is connected.
-        Stop();
+        // The timer thread cannot stop itself, the main thread does it.
+        if ( !bUseTimerThread )
+        {
+            Stop();
+        }
+        else
+        {
+            SetDeferredEvent ( bServerIdlePending );
+        }
     }
 }
 
-// This is a static method used as a callback, and does not inherit a "this" pointer,
-// so it is necessary for the server instance to be passed as a parameter.
-void CServer::DecodeReceiveDataBlocks ( CServer* pServer, const int iStartChanCnt, const int iStopChanCnt, const int iNumClients )
+void CServer::UpdatePerfStats ( const CServerFrame&                          DecodeFrame,
+                                const CServerFrame&                          MixFrame,
+                                const std::chrono::steady_clock::time_point& tFrameStart )
 {
-    // loop over all channels in the current block, needed for multithreading support
-    for ( int iChanCnt = iStartChanCnt; iChanCnt <= iStopChanCnt; iChanCnt++ )
+    const auto tFrameEnd = std::chrono::steady_clock::now();
+    int64_t    iDecodeNs = 0;
+    int64_t    iMixNs    = 0;
+    int64_t    iEncodeNs = 0;
+    int64_t    iSendNs   = 0;
+
+    // sum up the processing times of all channels
+    for ( int iChanCnt = 0; iChanCnt < DecodeFrame.iNumClients; iChanCnt++ )
     {
-        pServer->DecodeReceiveData ( iChanCnt, iNumClients );
+        iDecodeNs += DecodeFrame.vecDecodeTimeNs[iChanCnt];
     }
-}
 
-// This is a static method used as a callback, and does not inherit a "this" pointer,
-// so it is necessary for the server instance to be passed as a parameter.
-void CServer::MixEncodeTransmitDataBlocks ( CServer* pServer, const int iStartChanCnt, const int iStopChanCnt, const int iNumClients )
-{
-    // loop over all channels in the current block, needed for multithreading support
-    for ( int iChanCnt = iStartChanCnt; iChanCnt <= iStopChanCnt; iChanCnt++ )
+    for ( int iChanCnt = 0; iChanCnt < MixFrame.iNumClients; iChanCnt++ )
     {
-        pServer->MixEncodeTransmitData ( iChanCnt, iNumClients );
+        iMixNs    += MixFrame.vecMixTimeNs[iChanCnt];
+        iEncodeNs += MixFrame.vecEncodeTimeNs[iChanCnt];
+        iSendNs   += MixFrame.vecSendTimeNs[iChanCnt];
     }
-}
-
-void CServer::DecodeReceiveData ( const int iChanCnt, const int iNumClients )
-{
-    int                iUnused;
-    int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
-    OpusCustomDecoder* CurOpusDecoder;
-    unsigned char*     pCurCodedData;
-
-    // get actual ID of current channel
-    const int iCurChanID = vecChanIDsCurConChan[iChanCnt];
-
-    // get and store number of audio channels and compression type
-    vecNumAudioChannels[iChanCnt] = vecChannels[iCurChanID].GetNumAudioChannels();
-    vecAudioComprType[iChanCnt]   = vecChannels[iCurChanID].GetAudioCompressionType();
-
-    // get info about required frame size conversion properties
-    vecUseDoubleSysFraSizeConvBuf[iChanCnt] = ( !bUseDoubleSystemFrameSize && ( vecAudioComprType[iChanCnt] == CT_OPUS ) );
 
-    if ( bUseDoubleSystemFrameSize && ( vecAudioComprType[iChanCnt] == CT_OPUS64 ) )
+    if ( DecodeFrame.iNumClients > 0 )
     {
-        vecNumFrameSizeConvBlocks[iChanCnt] = 2;
+        PerfHistograms[PS_DECODE].Add ( iDecodeNs );
     }
-    else
+
+    if ( MixFrame.iNumClients > 0 )
     {
-        vecNumFrameSizeConvBlocks[iChanCnt] = 1;
+        PerfHistograms[PS_MIX].Add ( iMixNs );
+        PerfHistograms[PS_ENCODE].Add ( iEncodeNs );
+        PerfHistograms[PS_SEND].Add ( iSendNs );
     }
 
-    // update conversion buffer size (nothing will happen if the size stays the same)
-    if ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] )
+    PerfHistograms[PS_FRAME].Add ( std::chrono::duration_cast<std::chrono::nanoseconds> ( tFrameEnd - tFrameStart ).count() );
+    PerfHistograms[PS_WAKE_LATENESS].Add ( std::chrono::duration_cast<std::chrono::nanoseconds> ( tFrameStart - tFrameDue ).count() );
+
+    // the frame must be processed before the next frame is due
+    tFrameDue += std::chrono::nanoseconds ( iFramePeriodNs );
+
+    if ( tFrameEnd > tFrameDue )
     {
-        DoubleFrameSizeConvBufIn[iCurChanID].SetBufferSize ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] );
-        DoubleFrameSizeConvBufOut[iCurChanID].SetBufferSize ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] );
+        iNumDeadlineMisses++;
     }
+}
 
-    // select the opus decoder and raw audio frame length
-    if ( vecAudioComprType[iChanCnt] == CT_OPUS )
+void CServer::PrepareMixFrame ( CServerFrame& Frame )
+{
+    // calculate levels for all connected clients
+    const auto tLevelsStart       = std::chrono::steady_clock::now();
+    const bool bSendChannelLevels = CreateLevelsForAllConChannels ( Frame, vecChannelLevels );
+
+    PerfHistograms[PS_LEVELS].Add ( GetElapsedNs ( tLevelsStart ) );
+
+    // mix the shared mix buses if they are worth it
+    CreateSharedMixBuses ( Frame );
+
+    // find listeners with identical mixes which only have to be encoded once
+    CreateMixGroups ( Frame );
+
+    for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
     {
-        iClientFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+        // get actual ID of current channel
+        const int iCurChanID = Frame.vecChanIDsCurConChan[iChanCnt];
 
-        if ( vecNumAudioChannels[iChanCnt] == 1 )
-        {
-            CurOpusDecoder = OpusDecoderMono[iCurChanID];
-        }
-        else
+        // collect the receivers of the channel levels if they are ready
+        if ( bSendChannelLevels && !bUseTimerThread )
         {
-            CurOpusDecoder = OpusDecoderStereo[iCurChanID];
+            vecChannelLevelsAddr[iChanCnt] = vecChannels[iCurChanID].GetAddress();
         }
-    }
-    else if ( vecAudioComprType[iChanCnt] == CT_OPUS64 )
-    {
-        iClientFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
 
-        if ( vecNumAudioChannels[iChanCnt] == 1 )
+        // the channel was freed after the decoding (and may be used by a new client)
+        if ( Frame.vecChanDisconnected[iChanCnt] != 0 )
         {
-            CurOpusDecoder = Opus64DecoderMono[iCurChanID];
+            continue;
         }
-        else
+
+        // update socket buffer size
+        vecChannels[iCurChanID].UpdateSocketBufferSize();
+
+        // export the audio data for recording purpose
+        if ( JamController.GetRecordingEnabled() )
         {
-            CurOpusDecoder = Opus64DecoderStereo[iCurChanID];
+            if ( bUseTimerThread )
+            {
+                PushDeferredAudioFrame ( Frame, iChanCnt );
+            }
+            else
+            {
+                emit AudioFrame ( iCurChanID,
+                                  vecChannels[iCurChanID].GetName(),
+                                  vecChannels[iCurChanID].GetAddress(),
+                                  Frame.vecNumAudioChannels[iChanCnt],
+                                  Frame.vecvecsData[iChanCnt] );
+            }
         }
     }
-    else
+
+    // send channel levels to all clients (the message is serialized only once)
+    if ( bSendChannelLevels && !bUseTimerThread )
     {
-        CurOpusDecoder = nullptr;
+        ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannelLevelsAddr, vecChannelLevels, Frame.iNumClients );
     }
 
-    // get gains of all connected channels
-    for ( int j = 0; j < iNumClients; j++ )
+    // in the timer thread the channel levels are stored in the snapshot for the
+    // main thread (if the last levels are not sent yet, the update is skipped)
+    if ( bSendChannelLevels && bUseTimerThread && !bChannelLevelsPending )
     {
-        // The second index of "vecvecdGains" does not represent
-        // the channel ID! Therefore we have to use
-        // "vecChanIDsCurConChan" to query the IDs of the currently
-        // connected channels
-        vecvecfGains[iChanCnt][j] = vecChannels[iCurChanID].GetGain ( vecChanIDsCurConChan[j] );
+        for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
+        {
+            vecDeferredChannelLevels[iChanCnt] = vecChannelLevels[iChanCnt];
+            vecDeferredLevelsChanIDs[iChanCnt] = Frame.vecChanIDsCurConChan[iChanCnt];
+        }
 
-        // consider audio fade-in
-        vecvecfGains[iChanCnt][j] *= vecChannels[vecChanIDsCurConChan[j]].GetFadeInGain();
+        iDeferredLevelsNumClients = Frame.iNumClients;
+
+        SetDeferredEvent ( bChannelLevelsPending );
+    }
+}
+
+void CServer::PushDeferredAudioFrame ( const CServerFrame& Frame, const int iChanCnt )
+{
+    const int iCurChanID = Frame.vecChanIDsCurConChan[iChanCnt];
+
+    // while the disconnect of the last client of this channel is pending, the
+    // audio of a new client in the channel must not get into its recording
+    if ( bClientDisconnectedPending[iCurChanID] )
+    {
+        return;
+    }
+
+    CDeferredAudioFrame Deferred;
+
+    Deferred.iChanID           = iCurChanID;
+    Deferred.iNumAudioChannels = Frame.vecNumAudioChannels[iChanCnt];
+    std::copy ( Frame.vecvecsData[iChanCnt].begin(), Frame.vecvecsData[iChanCnt].end(), Deferred.vecsData );
+
+    // if the main thread does not keep up, the audio frame is dropped since
+    // the frame processing must never block
+    if ( DeferredAudioFrames.Push ( Deferred ) )
+    {
+        PostDeferredEvents();
+    }
+}
+
+void CServer::SetDeferredEvent ( std::atomic<bool>& bEventPending )
+{
+    // the flag is only cleared by the main thread after it has handled the
+    // event, so the main thread only has to be woken up if it was not set
+    if ( !bEventPending.exchange ( true ) )
+    {
+        PostDeferredEvents();
+    }
+}
+
+void CServer::PostDeferredEvents()
+{
+    // wake up the main thread if it was not already woken up
+    if ( !bDeferredEventsPosted.exchange ( true ) )
+    {
+        QCoreApplication::postEvent ( this, new CCustomEvent ( MS_DEFERRED_EVENTS, 0, 0 ) );
+    }
+}
+
+void CServer::ProcessDeferredEvents()
+{
+    CDeferredAudioFrame Deferred;
+    int                 iNumDisconnected = 0;
+
+    // the flag is reset before the events are read so that an event which is
+    // set while we are reading them wakes us up again
+    bDeferredEventsPosted = false;
+
+    // The disconnected clients are collected before the audio frames are read.
+    // All audio frames of a client are queued before its disconnect flag is set
+    // and no audio frames of the channel are queued while the flag is set, so
+    // the recorder gets the disconnect after the last audio frame of the client.
+    for ( int i = 0; i < iMaxNumChannels; i++ )
+    {
+        if ( bClientDisconnectedPending[i] )
+        {
+            vecDeferredDisconnChanIDs[iNumDisconnected++] = i;
+        }
+    }
+
+    while ( DeferredAudioFrames.Pop ( Deferred ) )
+    {
+        std::copy ( Deferred.vecsData, Deferred.vecsData + vecsDeferredAudioData.Size(), vecsDeferredAudioData.begin() );
+
+        emit AudioFrame ( Deferred.iChanID,
+                          vecChannels[Deferred.iChanID].GetName(),
+                          vecChannels[Deferred.iChanID].GetAddress(),
+                          Deferred.iNumAudioChannels,
+                          vecsDeferredAudioData );
+    }
+
+    for ( int i = 0; i < iNumDisconnected; i++ )
+    {
+        emit ClientDisconnected ( vecDeferredDisconnChanIDs[i] );
+
+        bClientDisconnectedPending[vecDeferredDisconnChanIDs[i]] = false;
+    }
+
+    if ( bChanListChangedPending.exchange ( false ) )
+    {
+        CreateAndSendChanListForAllConChannels();
+    }
+
+    if ( bChannelLevelsPending )
+    {
+        for ( int i = 0; i < iDeferredLevelsNumClients; i++ )
+        {
+            vecChannelLevelsAddr[i] = vecChannels[vecDeferredLevelsChanIDs[i]].GetAddress();
+        }
+
+        ConnLessProtocol.CreateCLChannelLevelListMes ( vecChannelLevelsAddr, vecDeferredChannelLevels, iDeferredLevelsNumClients );
+
+        bChannelLevelsPending = false;
+    }
+
+    if ( bServerIdlePending )
+    {
+        // a client may have connected in the meantime
+        if ( GetNumberOfConnectedClients() == 0 )
+        {
+            Stop();
+        }
+
+        bServerIdlePending = false;
+    }
+}
+
+void CServer::DecodeReceiveDataChunk ( CServerFrame& Frame, const int iChunkCnt )
+{
+    for ( int i = vecMTDecodeChunkStart[iChunkCnt]; i < vecMTDecodeChunkStart[iChunkCnt + 1]; i++ )
+    {
+        const int  iChanCnt = vecMTDecodeChanOrder[i];
+        const auto tStart   = std::chrono::steady_clock::now();
+
+        DecodeReceiveData ( Frame, iChanCnt );
+
+        Frame.vecDecodeTimeNs[iChanCnt] = GetElapsedNs ( tStart );
+        UpdateMTCost ( vecfDecodeCostUs, Frame.vecChanIDsCurConChan[iChanCnt], Frame.vecDecodeTimeNs[iChanCnt] );
+    }
+}
+
+void CServer::MixEncodeTransmitDataChunk ( CServerFrame& Frame, const int iChunkCnt )
+{
+    // the packets of the chunk are collected in the batch of the current thread
+    CSendBatch& SendBatch = vecSendBatches[CFrameWorkerPool::GetThreadIdx()];
+
+    for ( int i = vecMTMixChunkStart[iChunkCnt]; i < vecMTMixChunkStart[iChunkCnt + 1]; i++ )
+    {
+        const int iChanCnt = vecMTMixChanOrder[i];
+
+        MixEncodeTransmitData ( Frame, iChanCnt, SendBatch );
+
+        UpdateMTCost ( vecfMixEncodeCostUs,
+                       Frame.vecChanIDsCurConChan[iChanCnt],
+                       Frame.vecMixTimeNs[iChanCnt] + Frame.vecEncodeTimeNs[iChanCnt] + Frame.vecSendTimeNs[iChanCnt] );
+    }
+
+    // send the packets of the chunk (the time is accounted to the last channel of the chunk)
+    const auto tSendStart = std::chrono::steady_clock::now();
+
+    SendBatch.Flush();
+
+    Frame.vecSendTimeNs[vecMTMixChanOrder[vecMTMixChunkStart[iChunkCnt + 1] - 1]] += GetElapsedNs ( tSendStart );
+}
+
+int CServer::CreateMTChunks ( const CServerFrame& Frame, const CVector<float>& vecfCostUs, CVector<int>& vecChanOrder, CVector<int>& vecChunkStart )
+{
+    float fTotalCostUs = 0;
+
+    // sort the channels by their estimated cost, most expensive first
+    for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
+    {
+        vecChanOrder[iChanCnt] = iChanCnt;
+        fTotalCostUs += vecfCostUs[Frame.vecChanIDsCurConChan[iChanCnt]];
+    }
+
+    std::sort ( vecChanOrder.begin(), vecChanOrder.begin() + Frame.iNumClients, [&Frame, &vecfCostUs] ( const int iA, const int iB ) {
+        return vecfCostUs[Frame.vecChanIDsCurConChan[iA]] > vecfCostUs[Frame.vecChanIDsCurConChan[iB]];
+    } );
+
+    // Cut the sorted list in chunks with about the target cost. Expensive
+    // channels end up in single channel chunks at the beginning, cheap
+    // channels are combined to larger chunks at the end which are used by
+    // the threads to fill up the remaining time.
+    const float fTargetCostUs = fTotalCostUs / ( iMaxNumThreads * MT_NUM_CHUNKS_PER_THREAD );
+    float       fChunkCostUs  = 0;
+    bool        bChunkIsOpen  = false;
+    int         iNumChunks    = 0;
+
+    for ( int i = 0; i < Frame.iNumClients; i++ )
+    {
+        if ( !bChunkIsOpen )
+        {
+            vecChunkStart[iNumChunks] = i;
+            iNumChunks++;
+            bChunkIsOpen = true;
+        }
+
+        fChunkCostUs += vecfCostUs[Frame.vecChanIDsCurConChan[vecChanOrder[i]]];
+
+        if ( fChunkCostUs >= fTargetCostUs )
+        {
+            fChunkCostUs = 0;
+            bChunkIsOpen = false;
+        }
+    }
+
+    vecChunkStart[iNumChunks] = Frame.iNumClients;
+
+    return iNumChunks;
+}
+
+void CServer::UpdateMTCost ( CVector<float>& vecfCostUs, const int iChanID, const int64_t iTimeNs )
+{
+    const float fMeasUs = static_cast<float> ( iTimeNs ) / 1000;
+    float&      fCostUs = vecfCostUs[iChanID];
+
+    // moving average of the processing time of the channel (note that each
+    // channel is only processed by one thread)
+    fCostUs += MT_COST_IIR_WEIGHT * ( fMeasUs - fCostUs );
+}
+
+// This is a static method used as a callback, and does not inherit a "this" pointer,
+// so it is necessary for the server instance to be passed as a parameter.
+void CServer::DecodeReceiveDataBlocks ( CServer* pServer, CServerFrame& Frame, const int iStartChanCnt, const int iStopChanCnt )
+{
+    // loop over all channels in the current block, needed for multithreading support
+    for ( int iChanCnt = iStartChanCnt; iChanCnt <= iStopChanCnt; iChanCnt++ )
+    {
+        const auto tStart = std::chrono::steady_clock::now();
+
+        pServer->DecodeReceiveData ( Frame, iChanCnt );
+
+        Frame.vecDecodeTimeNs[iChanCnt] = GetElapsedNs ( tStart );
+    }
+}
+
+void CServer::DecodeReceiveData ( CServerFrame& Frame, const int iChanCnt )
+{
+    int                iUnused;
+    int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
+    OpusCustomDecoder* CurOpusDecoder;
+    unsigned char*     pCurCodedData;
+
+    // get actual ID of current channel
+    const int iCurChanID = Frame.vecChanIDsCurConChan[iChanCnt];
+
+    // get and store number of audio channels and compression type
+    Frame.vecNumAudioChannels[iChanCnt] = vecChannels[iCurChanID].GetNumAudioChannels();
+    Frame.vecAudioComprType[iChanCnt]   = vecChannels[iCurChanID].GetAudioCompressionType();
+    Frame.vecChanDisconnected[iChanCnt] = 0;
+
+    // get info about required frame size conversion properties
+    Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] = ( !bUseDoubleSystemFrameSize && ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS ) );
+
+    if ( bUseDoubleSystemFrameSize && ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS64 ) )
+    {
+        Frame.vecNumFrameSizeConvBlocks[iChanCnt] = 2;
+    }
+    else
+    {
+        Frame.vecNumFrameSizeConvBlocks[iChanCnt] = 1;
+    }
+
+    // update conversion buffer size (nothing will happen if the size stays the same)
+    if ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] )
+    {
+        DoubleFrameSizeConvBufIn[iCurChanID].SetBufferSize ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] );
+        DoubleFrameSizeConvBufOut[iCurChanID].SetBufferSize ( DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] );
+    }
+
+    // select the opus decoder and raw audio frame length
+    if ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS )
+    {
+        iClientFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+
+        if ( Frame.vecNumAudioChannels[iChanCnt] == 1 )
+        {
+            CurOpusDecoder = OpusDecoderMono[iCurChanID];
+        }
+        else
+        {
+            CurOpusDecoder = OpusDecoderStereo[iCurChanID];
+        }
+    }
+    else if ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS64 )
+    {
+        iClientFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+
+        if ( Frame.vecNumAudioChannels[iChanCnt] == 1 )
+        {
+            CurOpusDecoder = Opus64DecoderMono[iCurChanID];
+        }
+        else
+        {
+            CurOpusDecoder = Opus64DecoderStereo[iCurChanID];
+        }
+    }
+    else
+    {
+        CurOpusDecoder = nullptr;
+    }
+
+    // get gains of all connected channels (the mixer settings are read
+    // without a lock from the settings which are published by the channel)
+    const CMixerSettings* pMixerSettings        = vecChannels[iCurChanID].AcquireMixerSettings();
+    int                   iNumMixBusCorrections = 0;
+    uint32_t              iMixSignatureHash     = 2166136261u; // FNV-1a offset basis
+
+    for ( int j = 0; j < Frame.iNumClients; j++ )
+    {
+        // The second index of "vecvecdGains" does not represent
+        // the channel ID! Therefore we have to use
+        // "Frame.vecChanIDsCurConChan" to query the IDs of the currently
+        // connected channels
+        Frame.vecvecfGains[iChanCnt][j] = pMixerSettings->fGains[Frame.vecChanIDsCurConChan[j]];
+
+        // consider audio fade-in
+        Frame.vecvecfGains[iChanCnt][j] *= vecChannels[Frame.vecChanIDsCurConChan[j]].GetFadeInGain();
 
         // use the fade in of the current channel for all other connected clients
         // as well to avoid the client volumes are at 100% when joining a server (#628)
         if ( j != iChanCnt )
         {
-            vecvecfGains[iChanCnt][j] *= vecChannels[iCurChanID].GetFadeInGain();
+            Frame.vecvecfGains[iChanCnt][j] *= vecChannels[iCurChanID].GetFadeInGain();
         }
 
         // panning
-        vecvecfPannings[iChanCnt][j] = vecChannels[iCurChanID].GetPan ( vecChanIDsCurConChan[j] );
+        Frame.vecvecfPannings[iChanCnt][j] = pMixerSettings->fPannings[Frame.vecChanIDsCurConChan[j]];
+
+        // hash the gains (and pans for a stereo target) to quickly find
+        // listeners with identical mixes
+        iMixSignatureHash = ( iMixSignatureHash ^ FloatToBits ( Frame.vecvecfGains[iChanCnt][j] ) ) * 16777619u;
+
+        if ( Frame.vecNumAudioChannels[iChanCnt] != 1 )
+        {
+            iMixSignatureHash = ( iMixSignatureHash ^ FloatToBits ( Frame.vecvecfPannings[iChanCnt][j] ) ) * 16777619u;
+        }
+
+        // count the channels which have to be corrected if the shared mix bus is used
+        if ( IsMixBusCorrection ( Frame, iChanCnt, j ) )
+        {
+            iNumMixBusCorrections++;
+        }
     }
 
+    vecChannels[iCurChanID].ReleaseMixerSettings ( pMixerSettings );
+
+    Frame.vecNumMixBusCorrections[iChanCnt] = iNumMixBusCorrections;
+    Frame.vecMixSignatureHash[iChanCnt]     = iMixSignatureHash;
+
     // If the server frame size is smaller than the received OPUS frame size, we need a conversion
     // buffer which stores the large buffer.
     // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
     // is false and the Get() function is not called at all. Therefore if the buffer is not needed
     // we do not spend any time in the function but go directly inside the if condition.
-    if ( ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] == 0 ) ||
-         !DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[iChanCnt], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] ) )
+    if ( ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] == 0 ) ||
+         !DoubleFrameSizeConvBufIn[iCurChanID].Get ( Frame.vecvecsData[iChanCnt], SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] ) )
     {
         // get current number of OPUS coded bytes
         const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetCeltNumCodedBytes();
 
-        for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[iChanCnt]; iB++ )
+        for ( int iB = 0; iB < Frame.vecNumFrameSizeConvBlocks[iChanCnt]; iB++ )
         {
             // get data
-            const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( vecvecbyCodedData[iChanCnt], iCeltNumCodedBytes );
+            const EGetDataStat eGetStat = vecChannels[iCurChanID].GetData ( Frame.vecvecbyCodedData[iChanCnt], iCeltNumCodedBytes );
 
             // if channel was just disconnected, set flag that connected
             // client list is sent to all other clients
@@ -1047,10 +1620,19 @@ void CServer::DecodeReceiveData ( const int iChanCnt, const int iNumClients )
             {
                 if ( JamController.GetRecordingEnabled() )
                 {
-                    emit ClientDisconnected ( iCurChanID ); // TODO do this outside the mutex lock?
+                    if ( bUseTimerThread )
+                    {
+                        SetDeferredEvent ( bClientDisconnectedPending[iCurChanID] );
+                    }
+                    else
+                    {
+                        emit ClientDisconnected ( iCurChanID ); // TODO do this outside the mutex lock?
+                    }
                 }
 
-                FreeChannel ( iCurChanID ); // note that the channel is now not in use
+                // the channel is freed after the decoding of all channels since
+                // other frame workers may still mix and send to it
+                Frame.vecChanDisconnected[iChanCnt] = 1;
 
                 // note that no mutex is needed for this shared resource since it is not a
                 // read-modify-write operation but an atomic write and also each thread can
@@ -1064,7 +1646,7 @@ void CServer::DecodeReceiveData ( const int iChanCnt, const int iNumClients )
             // get pointer to coded data
             if ( eGetStat == GS_BUFFER_OK )
             {
-                pCurCodedData = &vecvecbyCodedData[iChanCnt][0];
+                pCurCodedData = &Frame.vecvecbyCodedData[iChanCnt][0];
             }
             else
             {
@@ -1075,97 +1657,315 @@ void CServer::DecodeReceiveData ( const int iChanCnt, const int iNumClients )
             // OPUS decode received data stream
             if ( CurOpusDecoder != nullptr )
             {
-                const int iOffset = iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt];
+                const int iOffset = iB * SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt];
 
                 iUnused = opus_custom_decode ( CurOpusDecoder,
                                                pCurCodedData,
                                                iCeltNumCodedBytes,
-                                               &vecvecsData[iChanCnt][iOffset],
+                                               &Frame.vecvecsData[iChanCnt][iOffset],
                                                iClientFrameSizeSamples );
             }
         }
 
         // a new large frame is ready, if the conversion buffer is required, put it in the buffer
         // and read out the small frame size immediately for further processing
-        if ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 )
+        if ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 )
         {
-            DoubleFrameSizeConvBufIn[iCurChanID].PutAll ( vecvecsData[iChanCnt] );
-            DoubleFrameSizeConvBufIn[iCurChanID].Get ( vecvecsData[iChanCnt], SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] );
+            DoubleFrameSizeConvBufIn[iCurChanID].PutAll ( Frame.vecvecsData[iChanCnt] );
+            DoubleFrameSizeConvBufIn[iCurChanID].Get ( Frame.vecvecsData[iChanCnt], SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] );
         }
     }
 
     Q_UNUSED ( iUnused )
 }
 
+/// @brief Check if the mix of a channel deviates from the shared mix bus in the given client
+bool CServer::IsMixBusCorrection ( const CServerFrame& Frame, const int iChanCnt, const int j ) const
+{
+    const float fGain = Frame.vecvecfGains[iChanCnt][j];
+
+    if ( Frame.vecNumAudioChannels[iChanCnt] == 1 )
+    {
+        // the panning is not used for a mono target channel
+        return fGain != 1.0f;
+    }
+
+    const float fPan = bDelayPan ? 0.5f : Frame.vecvecfPannings[iChanCnt][j];
+
+    return ( MathUtils::GetLeftPan ( fPan, false ) * fGain != 1.0f ) || ( MathUtils::GetRightPan ( fPan, false ) * fGain != 1.0f );
+}
+
+/// @brief Mix all clients at default gain/pan on the shared mix buses
+void CServer::CreateSharedMixBuses ( const CServerFrame& Frame )
+{
+    int iMonoSavings   = 0;
+    int iStereoSavings = 0;
+
+    // Each mix which is based on a mix bus needs one copy plus one pass per
+    // corrected channel instead of one pass per connected client. Creating
+    // the mix bus costs one pass per connected client, so it only pays off
+    // if the sum of all savings is larger than that. The mix bus cannot be
+    // used with delay panning since the delay cannot be corrected.
+    if ( !bDelayPan )
+    {
+        for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
+        {
+            const int iSavings = Frame.iNumClients - 1 - Frame.vecNumMixBusCorrections[iChanCnt];
+
+            if ( iSavings > 0 )
+            {
+                if ( Frame.vecNumAudioChannels[iChanCnt] == 1 )
+                {
+                    iMonoSavings += iSavings;
+                }
+                else
+                {
+                    iStereoSavings += iSavings;
+                }
+            }
+        }
+    }
+
+    bUseMonoMixBus   = ( iMonoSavings > Frame.iNumClients );
+    bUseStereoMixBus = ( iStereoSavings > Frame.iNumClients );
+
+    if ( bUseMonoMixBus )
+    {
+        vecfMonoMixBus.Reset ( 0 );
+
+        for ( int j = 0; j < Frame.iNumClients; j++ )
+        {
+            if ( Frame.vecNumAudioChannels[j] == 1 )
+            {
+                CMixKernels::MixMonoToMono ( &vecfMonoMixBus[0], &Frame.vecvecsData[j][0], 1.0f, iServerFrameSizeSamples );
+            }
+            else
+            {
+                CMixKernels::MixStereoToMono ( &vecfMonoMixBus[0], &Frame.vecvecsData[j][0], 1.0f, iServerFrameSizeSamples );
+            }
+        }
+    }
+
+    if ( bUseStereoMixBus )
+    {
+        vecfStereoMixBus.Reset ( 0 );
+
+        for ( int j = 0; j < Frame.iNumClients; j++ )
+        {
+            if ( Frame.vecNumAudioChannels[j] == 1 )
+            {
+                CMixKernels::MixMonoToStereo ( &vecfStereoMixBus[0], &Frame.vecvecsData[j][0], 1.0f, 1.0f, iServerFrameSizeSamples );
+            }
+            else
+            {
+                CMixKernels::MixStereoToStereo ( &vecfStereoMixBus[0], &Frame.vecvecsData[j][0], 1.0f, 1.0f, iServerFrameSizeSamples );
+            }
+        }
+    }
+}
+
+/// @brief Check if two listeners get identical coded audio data
+bool CServer::IsSameMix ( const CServerFrame& Frame, const int iChanCntA, const int iChanCntB ) const
+{
+    if ( ( Frame.vecMixSignatureHash[iChanCntA] != Frame.vecMixSignatureHash[iChanCntB] ) ||
+         ( Frame.vecAudioComprType[iChanCntA] != Frame.vecAudioComprType[iChanCntB] ) ||
+         ( Frame.vecNumAudioChannels[iChanCntA] != Frame.vecNumAudioChannels[iChanCntB] ) ||
+         ( vecCeltNumCodedBytes[iChanCntA] != vecCeltNumCodedBytes[iChanCntB] ) ||
+         ( Frame.vecNumFrameSizeConvBlocks[iChanCntA] != Frame.vecNumFrameSizeConvBlocks[iChanCntB] ) )
+    {
+        return false;
+    }
+
+    // the hash may have collisions, compare the actual gains/pans bitwise
+    if ( memcmp ( &Frame.vecvecfGains[iChanCntA][0], &Frame.vecvecfGains[iChanCntB][0], Frame.iNumClients * sizeof ( float ) ) != 0 )
+    {
+        return false;
+    }
+
+    return ( Frame.vecNumAudioChannels[iChanCntA] == 1 ) ||
+           ( memcmp ( &Frame.vecvecfPannings[iChanCntA][0], &Frame.vecvecfPannings[iChanCntB][0], Frame.iNumClients * sizeof ( float ) ) == 0 );
+}
+
+/// @brief Group listeners with identical mixes so that each mix is only encoded once
+void CServer::CreateMixGroups ( const CServerFrame& Frame )
+{
+    int iNumLeaders = 0;
+
+    for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
+    {
+        vecCeltNumCodedBytes[iChanCnt] = vecChannels[Frame.vecChanIDsCurConChan[iChanCnt]].GetCeltNumCodedBytes();
+        vecMixGroupLeader[iChanCnt]    = iChanCnt;
+        vecMixGroupNext[iChanCnt]      = INVALID_INDEX;
+
+        // Channels which use the frame size conversion buffer are not grouped
+        // since the state of the conversion buffer is different per channel.
+        // Disconnected channels are not mixed at all.
+        if ( ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 ) || ( Frame.vecChanDisconnected[iChanCnt] != 0 ) )
+        {
+            continue;
+        }
+
+        for ( int iLeaderCnt = 0; iLeaderCnt < iNumLeaders; iLeaderCnt++ )
+        {
+            const int iLeader = vecMixGroupLeaderList[iLeaderCnt];
+
+            if ( IsSameMix ( Frame, iLeader, iChanCnt ) )
+            {
+                // add the channel to the group of the leader
+                vecMixGroupLeader[iChanCnt] = iLeader;
+                vecMixGroupNext[iChanCnt]   = vecMixGroupNext[iLeader];
+                vecMixGroupNext[iLeader]    = iChanCnt;
+                break;
+            }
+        }
+
+        if ( vecMixGroupLeader[iChanCnt] == iChanCnt )
+        {
+            vecMixGroupLeaderList[iNumLeaders] = iChanCnt;
+            iNumLeaders++;
+        }
+    }
+
+    // The OPUS encoder of a leader continues the stream which was sent to the
+    // leader in the last frame. If that stream was coded by another encoder
+    // (i.e. the leader was a member of another group), the state of that
+    // encoder is copied so that the client decoder does not see a discontinuity.
+    // Note that the source encoder was a leader in the last frame and is
+    // therefore never a copy destination in this frame.
+    for ( int iChanCnt = 0; iChanCnt < Frame.iNumClients; iChanCnt++ )
+    {
+        if ( ( vecMixGroupLeader[iChanCnt] != iChanCnt ) || ( Frame.vecChanDisconnected[iChanCnt] != 0 ) )
+        {
+            continue;
+        }
+
+        const int          iCurChanID      = Frame.vecChanIDsCurConChan[iChanCnt];
+        const int          iLastChanID     = vecLastEncoderChanID[iCurChanID];
+        OpusCustomEncoder* pCurOpusEncoder = GetOpusEncoder ( iCurChanID, Frame.vecAudioComprType[iChanCnt], Frame.vecNumAudioChannels[iChanCnt] );
+
+        if ( pCurOpusEncoder == nullptr )
+        {
+            continue;
+        }
+
+        // the state can only be copied if the last encoder has the same mode
+        // (frame size) and number of channels as the current one, which is the
+        // case if it is the encoder of the current coding type of the other
+        // channel (all encoders of a coding type share the same mode)
+        if ( ( pLastEncoder[iCurChanID] != nullptr ) && ( iLastChanID != iCurChanID ) &&
+             ( GetOpusEncoder ( iLastChanID, Frame.vecAudioComprType[iChanCnt], Frame.vecNumAudioChannels[iChanCnt] ) == pLastEncoder[iCurChanID] ) )
+        {
+            const OpusCustomMode* pMode = ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS ) ? OpusMode : Opus64Mode;
+
+            memcpy ( pCurOpusEncoder, pLastEncoder[iCurChanID], opus_custom_encoder_get_size ( pMode, Frame.vecNumAudioChannels[iChanCnt] ) );
+        }
+
+        for ( int iMember = iChanCnt; iMember != INVALID_INDEX; iMember = vecMixGroupNext[iMember] )
+        {
+            vecLastEncoderChanID[Frame.vecChanIDsCurConChan[iMember]] = iCurChanID;
+            pLastEncoder[Frame.vecChanIDsCurConChan[iMember]]         = pCurOpusEncoder;
+        }
+    }
+}
+
+void CServer::ResetLastEncoder ( const int iChanID )
+{
+    vecLastEncoderChanID[iChanID] = iChanID;
+    pLastEncoder[iChanID]         = nullptr;
+}
+
+OpusCustomEncoder* CServer::GetOpusEncoder ( const int iChanID, const EAudComprType eAudioComprType, const int iNumAudioChannels )
+{
+    if ( eAudioComprType == CT_OPUS )
+    {
+        return ( iNumAudioChannels == 1 ) ? OpusEncoderMono[iChanID] : OpusEncoderStereo[iChanID];
+    }
+    else if ( eAudioComprType == CT_OPUS64 )
+    {
+        return ( iNumAudioChannels == 1 ) ? Opus64EncoderMono[iChanID] : Opus64EncoderStereo[iChanID];
+    }
+
+    return nullptr;
+}
+
 /// @brief Mix all audio data from all clients together, encode and transmit
-void CServer::MixEncodeTransmitData ( const int iChanCnt, const int iNumClients )
+void CServer::MixEncodeTransmitData ( CServerFrame& Frame, const int iChanCnt, CSendBatch& SendBatch )
 {
     int               i, j, k, iUnused;
     CVector<float>&   vecfIntermProcBuf = vecvecfIntermediateProcBuf[iChanCnt]; // use reference for faster access
     CVector<int16_t>& vecsSendData      = vecvecsSendData[iChanCnt];            // use reference for faster access
+    const auto        tStart            = std::chrono::steady_clock::now();
+
+    // init the timing statistics of this channel
+    Frame.vecMixTimeNs[iChanCnt]    = 0;
+    Frame.vecEncodeTimeNs[iChanCnt] = 0;
+    Frame.vecSendTimeNs[iChanCnt]   = 0;
+
+    // the mix of group members is mixed, encoded and sent by the group leader
+    // and the channels which were freed after the decoding are not mixed
+    if ( ( vecMixGroupLeader[iChanCnt] != iChanCnt ) || ( Frame.vecChanDisconnected[iChanCnt] != 0 ) )
+    {
+        return;
+    }
 
     // get actual ID of current channel
-    const int iCurChanID = vecChanIDsCurConChan[iChanCnt];
+    const int iCurChanID = Frame.vecChanIDsCurConChan[iChanCnt];
+
+    // check if the shared mix bus can be used as the base of this mix
+    const bool bUseMixBus = ( Frame.vecNumAudioChannels[iChanCnt] == 1 ? bUseMonoMixBus : bUseStereoMixBus ) &&
+                            ( Frame.vecNumMixBusCorrections[iChanCnt] + 1 < Frame.iNumClients );
 
-    // init intermediate processing vector with zeros since we mix all channels on that vector
-    vecfIntermProcBuf.Reset ( 0 );
+    if ( bUseMixBus )
+    {
+        // start with the shared mix bus so that we only have to mix the
+        // channels which deviate from the default gain/pan
+        const CVector<float>& vecfMixBus = ( Frame.vecNumAudioChannels[iChanCnt] == 1 ) ? vecfMonoMixBus : vecfStereoMixBus;
+
+        std::copy ( vecfMixBus.begin(),
+                    vecfMixBus.begin() + Frame.vecNumAudioChannels[iChanCnt] * iServerFrameSizeSamples,
+                    vecfIntermProcBuf.begin() );
+    }
+    else
+    {
+        // init intermediate processing vector with zeros since we mix all channels on that vector
+        vecfIntermProcBuf.Reset ( 0 );
+    }
 
     // distinguish between stereo and mono mode
-    if ( vecNumAudioChannels[iChanCnt] == 1 )
+    if ( Frame.vecNumAudioChannels[iChanCnt] == 1 )
     {
         // Mono target channel -------------------------------------------------
-        for ( j = 0; j < iNumClients; j++ )
+        for ( j = 0; j < Frame.iNumClients; j++ )
         {
             // get a reference to the audio data and gain of the current client
-            const CVector<int16_t>& vecsData = vecvecsData[j];
-            const float             fGain    = vecvecfGains[iChanCnt][j];
+            const CVector<int16_t>& vecsData = Frame.vecvecsData[j];
+            float                   fGain    = Frame.vecvecfGains[iChanCnt][j];
 
-            // if channel gain is 1, avoid multiplication for speed optimization
-            if ( fGain == 1.0f )
+            if ( bUseMixBus )
             {
-                if ( vecNumAudioChannels[j] == 1 )
-                {
-                    // mono
-                    for ( i = 0; i < iServerFrameSizeSamples; i++ )
-                    {
-                        vecfIntermProcBuf[i] += vecsData[i];
-                    }
-                }
-                else
+                // the channel is already on the mix bus with a gain of one
+                if ( !IsMixBusCorrection ( Frame, iChanCnt, j ) )
                 {
-                    // stereo: apply stereo-to-mono attenuation
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
-                    {
-                        vecfIntermProcBuf[i] += ( static_cast<float> ( vecsData[k] ) + vecsData[k + 1] ) / 2;
-                    }
+                    continue;
                 }
+
+                fGain -= 1.0f;
+            }
+
+            if ( Frame.vecNumAudioChannels[j] == 1 )
+            {
+                // mono
+                CMixKernels::MixMonoToMono ( &vecfIntermProcBuf[0], &vecsData[0], fGain, iServerFrameSizeSamples );
             }
             else
             {
-                if ( vecNumAudioChannels[j] == 1 )
-                {
-                    // mono
-                    for ( i = 0; i < iServerFrameSizeSamples; i++ )
-                    {
-                        vecfIntermProcBuf[i] += vecsData[i] * fGain;
-                    }
-                }
-                else
-                {
-                    // stereo: apply stereo-to-mono attenuation
-                    for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
-                    {
-                        vecfIntermProcBuf[i] += fGain * ( static_cast<float> ( vecsData[k] ) + vecsData[k + 1] ) / 2;
-                    }
-                }
+                // stereo: apply stereo-to-mono attenuation
+                CMixKernels::MixStereoToMono ( &vecfIntermProcBuf[0], &vecsData[0], fGain, iServerFrameSizeSamples );
             }
         }
 
         // convert from double to short with clipping
-        for ( i = 0; i < iServerFrameSizeSamples; i++ )
-        {
-            vecsSendData[i] = Float2Short ( vecfIntermProcBuf[i] );
-        }
+        CMixKernels::Float2ShortBlock ( &vecsSendData[0], &vecfIntermProcBuf[0], iServerFrameSizeSamples );
     }
     else
     {
@@ -1176,67 +1976,84 @@ void CServer::MixEncodeTransmitData ( const int iChanCnt, const int iNumClients
         int iPanDelL = 0, iPanDelR = 0, iPanDel;
         int iLpan, iRpan, iPan;
 
-        for ( j = 0; j < iNumClients; j++ )
+        for ( j = 0; j < Frame.iNumClients; j++ )
         {
             // get a reference to the audio data and gain/pan of the current client
-            const CVector<int16_t>& vecsData  = vecvecsData[j];
+            const CVector<int16_t>& vecsData  = Frame.vecvecsData[j];
             const CVector<int16_t>& vecsData2 = vecvecsData2[j];
 
-            const float fGain = vecvecfGains[iChanCnt][j];
-            const float fPan  = bDelayPan ? 0.5f : vecvecfPannings[iChanCnt][j];
+            const float fGain = Frame.vecvecfGains[iChanCnt][j];
+            const float fPan  = bDelayPan ? 0.5f : Frame.vecvecfPannings[iChanCnt][j];
 
             // calculate combined gain/pan for each stereo channel where we define
             // the panning that center equals full gain for both channels
-            const float fGainL = MathUtils::GetLeftPan ( fPan, false ) * fGain;
-            const float fGainR = MathUtils::GetRightPan ( fPan, false ) * fGain;
+            float fGainL = MathUtils::GetLeftPan ( fPan, false ) * fGain;
+            float fGainR = MathUtils::GetRightPan ( fPan, false ) * fGain;
+
+            if ( bUseMixBus )
+            {
+                // the channel is already on the mix bus with a gain of one
+                // (note that the mix bus is never used with delay panning)
+                if ( !IsMixBusCorrection ( Frame, iChanCnt, j ) )
+                {
+                    continue;
+                }
+
+                fGainL -= 1.0f;
+                fGainR -= 1.0f;
+            }
 
             if ( bDelayPan )
             {
-                iPanDel  = lround ( (float) ( 2 * maxPanDelay - 2 ) * ( vecvecfPannings[iChanCnt][j] - 0.5f ) );
+                iPanDel  = lround ( (float) ( 2 * maxPanDelay - 2 ) * ( Frame.vecvecfPannings[iChanCnt][j] - 0.5f ) );
                 iPanDelL = ( iPanDel > 0 ) ? iPanDel : 0;
                 iPanDelR = ( iPanDel < 0 ) ? -iPanDel : 0;
             }
 
-            if ( vecNumAudioChannels[j] == 1 )
+            if ( !bDelayPan )
+            {
+                if ( Frame.vecNumAudioChannels[j] == 1 )
+                {
+                    // mono: copy same mono data in both out stereo audio channels
+                    CMixKernels::MixMonoToStereo ( &vecfIntermProcBuf[0], &vecsData[0], fGainL, fGainR, iServerFrameSizeSamples );
+                }
+                else
+                {
+                    // stereo
+                    CMixKernels::MixStereoToStereo ( &vecfIntermProcBuf[0], &vecsData[0], fGainL, fGainR, iServerFrameSizeSamples );
+                }
+            }
+            else if ( Frame.vecNumAudioChannels[j] == 1 )
             {
                 // mono: copy same mono data in both out stereo audio channels
                 for ( i = 0, k = 0; i < iServerFrameSizeSamples; i++, k += 2 )
                 {
-                    // left/right channel
-                    if ( bDelayPan )
+                    // pan address shift
+
+                    // left channel
+                    iLpan = i - iPanDelL;
+                    if ( iLpan < 0 )
+                    {
+                        // get from second
+                        iLpan = iLpan + iServerFrameSizeSamples;
+                        vecfIntermProcBuf[k] += vecsData2[iLpan] * fGainL;
+                    }
+                    else
+                    {
+                        vecfIntermProcBuf[k] += vecsData[iLpan] * fGainL;
+                    }
+
+                    // right channel
+                    iRpan = i - iPanDelR;
+                    if ( iRpan < 0 )
                     {
-                        // pan address shift
-
-                        // left channel
-                        iLpan = i - iPanDelL;
-                        if ( iLpan < 0 )
-                        {
-                            // get from second
-                            iLpan = iLpan + iServerFrameSizeSamples;
-                            vecfIntermProcBuf[k] += vecsData2[iLpan] * fGainL;
-                        }
-                        else
-                        {
-                            vecfIntermProcBuf[k] += vecsData[iLpan] * fGainL;
-                        }
-
-                        // right channel
-                        iRpan = i - iPanDelR;
-                        if ( iRpan < 0 )
-                        {
-                            // get from second
-                            iRpan = iRpan + iServerFrameSizeSamples;
-                            vecfIntermProcBuf[k + 1] += vecsData2[iRpan] * fGainR;
-                        }
-                        else
-                        {
-                            vecfIntermProcBuf[k + 1] += vecsData[iRpan] * fGainR;
-                        }
+                        // get from second
+                        iRpan = iRpan + iServerFrameSizeSamples;
+                        vecfIntermProcBuf[k + 1] += vecsData2[iRpan] * fGainR;
                     }
                     else
                     {
-                        vecfIntermProcBuf[k] += vecsData[i] * fGainL;
-                        vecfIntermProcBuf[k + 1] += vecsData[i] * fGainR;
+                        vecfIntermProcBuf[k + 1] += vecsData[iRpan] * fGainR;
                     }
                 }
             }
@@ -1245,100 +2062,58 @@ void CServer::MixEncodeTransmitData ( const int iChanCnt, const int iNumClients
                 // stereo
                 for ( i = 0; i < ( 2 * iServerFrameSizeSamples ); i++ )
                 {
-                    // left/right channel
-                    if ( bDelayPan )
+                    // pan address shift
+                    if ( ( i & 1 ) == 0 )
                     {
-                        // pan address shift
-                        if ( ( i & 1 ) == 0 )
-                        {
-                            iPan = i - 2 * iPanDelL; // if even : left channel
-                        }
-                        else
-                        {
-                            iPan = i - 2 * iPanDelR; // if odd  : right channel
-                        }
-                        // interleaved channels
-                        if ( iPan < 0 )
-                        {
-                            // get from second
-                            iPan = iPan + 2 * iServerFrameSizeSamples;
-                            vecfIntermProcBuf[i] += vecsData2[iPan] * fGain;
-                        }
-                        else
-                        {
-                            vecfIntermProcBuf[i] += vecsData[iPan] * fGain;
-                        }
+                        iPan = i - 2 * iPanDelL; // if even : left channel
                     }
                     else
                     {
-                        if ( ( i & 1 ) == 0 )
-                        {
-                            // if even : left channel
-                            vecfIntermProcBuf[i] += vecsData[i] * fGainL;
-                        }
-                        else
-                        {
-                            // if odd  : right channel
-                            vecfIntermProcBuf[i] += vecsData[i] * fGainR;
-                        }
+                        iPan = i - 2 * iPanDelR; // if odd  : right channel
+                    }
+                    // interleaved channels
+                    if ( iPan < 0 )
+                    {
+                        // get from second
+                        iPan = iPan + 2 * iServerFrameSizeSamples;
+                        vecfIntermProcBuf[i] += vecsData2[iPan] * fGain;
+                    }
+                    else
+                    {
+                        vecfIntermProcBuf[i] += vecsData[iPan] * fGain;
                     }
                 }
             }
         }
 
         // convert from double to short with clipping
-        for ( i = 0; i < ( 2 * iServerFrameSizeSamples ); i++ )
-        {
-            vecsSendData[i] = Float2Short ( vecfIntermProcBuf[i] );
-        }
+        CMixKernels::Float2ShortBlock ( &vecsSendData[0], &vecfIntermProcBuf[0], 2 * iServerFrameSizeSamples );
     }
 
-    int                iClientFrameSizeSamples = 0; // initialize to avoid a compiler warning
-    OpusCustomEncoder* pCurOpusEncoder         = nullptr;
-
-    // get current number of CELT coded bytes
-    const int iCeltNumCodedBytes = vecChannels[iCurChanID].GetCeltNumCodedBytes();
+    const auto tMixEnd = std::chrono::steady_clock::now();
 
-    // select the opus encoder and raw audio frame length
-    if ( vecAudioComprType[iChanCnt] == CT_OPUS )
-    {
-        iClientFrameSizeSamples = DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES;
+    Frame.vecMixTimeNs[iChanCnt] = std::chrono::duration_cast<std::chrono::nanoseconds> ( tMixEnd - tStart ).count();
 
-        if ( vecNumAudioChannels[iChanCnt] == 1 )
-        {
-            pCurOpusEncoder = OpusEncoderMono[iCurChanID];
-        }
-        else
-        {
-            pCurOpusEncoder = OpusEncoderStereo[iCurChanID];
-        }
-    }
-    else if ( vecAudioComprType[iChanCnt] == CT_OPUS64 )
-    {
-        iClientFrameSizeSamples = SYSTEM_FRAME_SIZE_SAMPLES;
+    // get current number of CELT coded bytes (as used for the mix groups)
+    const int iCeltNumCodedBytes = vecCeltNumCodedBytes[iChanCnt];
 
-        if ( vecNumAudioChannels[iChanCnt] == 1 )
-        {
-            pCurOpusEncoder = Opus64EncoderMono[iCurChanID];
-        }
-        else
-        {
-            pCurOpusEncoder = Opus64EncoderStereo[iCurChanID];
-        }
-    }
+    // select the opus encoder and raw audio frame length
+    OpusCustomEncoder* pCurOpusEncoder = GetOpusEncoder ( iCurChanID, Frame.vecAudioComprType[iChanCnt], Frame.vecNumAudioChannels[iChanCnt] );
+    const int          iClientFrameSizeSamples =
+        ( Frame.vecAudioComprType[iChanCnt] == CT_OPUS ) ? DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES : SYSTEM_FRAME_SIZE_SAMPLES;
 
     // If the server frame size is smaller than the received OPUS frame size, we need a conversion
     // buffer which stores the large buffer.
     // Note that we have a shortcut here. If the conversion buffer is not needed, the boolean flag
     // is false and the Get() function is not called at all. Therefore if the buffer is not needed
     // we do not spend any time in the function but go directly inside the if condition.
-    if ( ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] == 0 ) ||
-         DoubleFrameSizeConvBufOut[iCurChanID].Put ( vecsSendData, SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] ) )
+    if ( ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] == 0 ) ||
+         DoubleFrameSizeConvBufOut[iCurChanID].Put ( vecsSendData, SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] ) )
     {
-        if ( vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 )
+        if ( Frame.vecUseDoubleSysFraSizeConvBuf[iChanCnt] != 0 )
         {
             // get the large frame from the conversion buffer
-            DoubleFrameSizeConvBufOut[iCurChanID].GetAll ( vecsSendData, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt] );
+            DoubleFrameSizeConvBufOut[iCurChanID].GetAll ( vecsSendData, DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt] );
         }
 
         // OPUS encoding
@@ -1350,22 +2125,34 @@ void CServer::MixEncodeTransmitData ( const int iChanCnt, const int iNumClients
 opus_custom_encoder_ctl ( pCurOpusEncoder, OPUS_SET_BITRATE ( CalcBitRateBitsPerSecFromCodedBytes ( iCeltNumCodedBytes, iClientFrameSizeSamples ) ) );
             // clang-format on
 
-            for ( int iB = 0; iB < vecNumFrameSizeConvBlocks[iChanCnt]; iB++ )
+            for ( int iB = 0; iB < Frame.vecNumFrameSizeConvBlocks[iChanCnt]; iB++ )
             {
-                const int iOffset = iB * SYSTEM_FRAME_SIZE_SAMPLES * vecNumAudioChannels[iChanCnt];
+                const int iOffset = iB * SYSTEM_FRAME_SIZE_SAMPLES * Frame.vecNumAudioChannels[iChanCnt];
 
                 iUnused = opus_custom_encode ( pCurOpusEncoder,
                                                &vecsSendData[iOffset],
                                                iClientFrameSizeSamples,
-                                               &vecvecbyCodedData[iChanCnt][0],
+                                               &Frame.vecvecbyCodedData[iChanCnt][0],
                                                iCeltNumCodedBytes );
 
-                // send separate mix to current clients
-                vecChannels[iCurChanID].PrepAndSendPacket ( &Socket, vecvecbyCodedData[iChanCnt], iCeltNumCodedBytes );
+                // send separate mix to current clients (i.e. to all members of the mix group)
+                const auto tSendStart = std::chrono::steady_clock::now();
+
+                for ( int iMember = iChanCnt; iMember != INVALID_INDEX; iMember = vecMixGroupNext[iMember] )
+                {
+                    vecChannels[Frame.vecChanIDsCurConChan[iMember]].PrepAndSendPacket ( SendBatch,
+                                                                                         Frame.vecvecbyCodedData[iChanCnt],
+                                                                                         iCeltNumCodedBytes );
+                }
+
+                Frame.vecSendTimeNs[iChanCnt] += GetElapsedNs ( tSendStart );
             }
         }
     }
 
+    // the encoding time is the time after the mixing which was not used for sending
+    Frame.vecEncodeTimeNs[iChanCnt] = GetElapsedNs ( tMixEnd ) - Frame.vecSendTimeNs[iChanCnt];
+
     Q_UNUSED ( iUnused )
 }
 
@@ -1388,16 +2175,19 @@ CVector<CChannelInfo> CServer::CreateChannelList()
 
 void CServer::CreateAndSendChanListForAllConChannels()
 {
-    // create channel list
-    CVector<CChannelInfo> vecChanInfo ( CreateChannelList() );
+    // create channel list and serialize it once for all clients
+    CVector<uint8_t> vecConClientListData;
 
-    // now send connected channels list to all connected clients
+    CProtocol::GenConClientListMesData ( CreateChannelList(), vecConClientListData );
+
+    // now send connected channels list to all connected clients (each channel
+    // only does the framing with its own message counter)
     for ( int i = 0; i < iMaxNumChannels; i++ )
     {
         if ( vecChannels[i].IsConnected() )
         {
             // send message
-            vecChannels[i].CreateConClientListMes ( vecChanInfo );
+            vecChannels[i].CreateConClientListMes ( vecConClientListData );
         }
     }
 
@@ -1475,61 +2265,47 @@ int CServer::GetNumberOfConnectedClients()
 
 // CServer::FindChannel() is called for every received audio packet or connected protocol
 // packet, to find the channel ID associated with the source IP address and port.
-// In order to search as efficiently as possible, a list of active channel IDs is stored
-// in vecChannelOrder[], sorted by IP and port (according to CHostAddress::Compare()),
-// and a binary search is used to find either the existing channel, or the position at
-// which a new channel should be inserted.
+// The connected channels are stored in a hash table keyed on the raw address which is
+// read without locking. Only the creation of a new channel takes the channel order mutex.
+// The active channel IDs are stored in vecChannelOrder[0 .. iCurNumChannels - 1] and
+// the free channel IDs follow in ascending order, so that the lowest free ID is reused.
 
 int CServer::FindChannel ( const CHostAddress& CheckAddr, const bool bAllowNew )
 {
-    int iNewChanID = INVALID_CHANNEL_ID;
-
-    QMutexLocker locker ( &MutexChanOrder );
+    const CChannelAddrKey Key     = CChannelAddrKey::FromHostAddr ( CheckAddr );
+    const int             iChanID = ChannelAddrTable.Find ( Key );
 
-    int l = 0, r = iCurNumChannels, i;
+    if ( iChanID != INVALID_INDEX )
+    {
+        return iChanID;
+    }
 
-    // use binary search to find the channel
-    while ( r > l )
+    // existing channel not found - return if we cannot create a new channel
+    if ( !bAllowNew )
     {
-        int t   = ( r + l ) / 2;
-        int cmp = CheckAddr.Compare ( vecChannels[vecChannelOrder[t]].GetAddress() );
+        return INVALID_CHANNEL_ID;
+    }
 
-        if ( cmp == 0 )
-        {
-            // address and port match
-            return vecChannelOrder[t];
-        }
+    QMutexLocker locker ( &MutexChanOrder );
 
-        if ( cmp > 0 )
-        {
-            l = t + 1;
-        }
-        else
-        {
-            r = t;
-        }
+    // the channel may have been created meanwhile
+    const int iExistingChanID = ChannelAddrTable.Find ( Key );
+
+    if ( iExistingChanID != INVALID_INDEX )
+    {
+        return iExistingChanID;
     }
 
-    // existing channel not found - return if we cannot create a new channel
-    if ( !bAllowNew || iCurNumChannels >= iMaxNumChannels )
+    if ( iCurNumChannels >= iMaxNumChannels )
     {
         return INVALID_CHANNEL_ID;
     }
 
-    // allocate a new channel
-    i          = iCurNumChannels++; // save index of free channel and increment count
-    iNewChanID = vecChannelOrder[i];
+    // allocate a new channel (the first free channel ID)
+    const int iNewChanID = vecChannelOrder[iCurNumChannels++];
     InitChannel ( iNewChanID, CheckAddr );
 
-    // now l == r == position in vecChannelOrder to insert iNewChanID
-    // move channel IDs up by one starting at the top and working down
-    while ( i > r )
-    {
-        int j              = i--;
-        vecChannelOrder[j] = vecChannelOrder[i];
-    }
-    // insert the new channel ID in the correct place
-    vecChannelOrder[i] = iNewChanID;
+    ChannelAddrTable.Insert ( Key, iNewChanID );
 
     // DumpChannels ( __FUNCTION__ );
 
@@ -1538,8 +2314,12 @@ int CServer::FindChannel ( const CHostAddress& CheckAddr, const bool bAllowNew )
 
 void CServer::InitChannel ( const int iNewChanID, const CHostAddress& InetAddr )
 {
+    // the receive threads put packets into the channel as soon as the key is set
+    QMutexLocker locker ( &MutexChanAlloc[iNewChanID] );
+
     // initialize new channel by storing the calling host address
-    vecChannels[iNewChanID].SetAddress ( InetAddr );
+    vecChannels[iNewChanID].SetAddress ( InetAddr, &Socket );
+    vecChanAddrKeys[iNewChanID] = CChannelAddrKey::FromHostAddr ( InetAddr );
 
     // reset channel info
     vecChannels[iNewChanID].ResetInfo();
@@ -1556,6 +2336,11 @@ void CServer::InitChannel ( const int iNewChanID, const CHostAddress& InetAddr )
         vecChannels[i].SetGain ( iNewChanID, 1.0 );
         vecChannels[i].SetPan ( iNewChanID, 0.5 );
     }
+
+    // the new client has not received any coded audio yet and its processing
+    // time is not known yet, the frame processing state is reset by the timer
+    // thread (see OnTimer())
+    bNewChannelPending[iNewChanID] = true;
 }
 
 // CServer::FreeChannel() is called to remove a channel from the list of active channels.
@@ -1570,6 +2355,15 @@ void CServer::FreeChannel ( const int iCurChanID )
     {
         if ( vecChannelOrder[i] == iCurChanID )
         {
+            {
+                QMutexLocker locker ( &MutexChanAlloc[iCurChanID] );
+
+                ChannelAddrTable.Remove ( CChannelAddrKey::FromHostAddr ( vecChannels[iCurChanID].GetAddress() ) );
+                vecChanAddrKeys[iCurChanID] = CChannelAddrKey();
+            }
+
+            ResetLastEncoder ( iCurChanID );
+
             --iCurNumChannels;
 
             // move channel IDs down by one starting at the freed channel and working up the active channels
@@ -1608,7 +2402,7 @@ void CServer::DumpChannels ( const QString& title )
     }
 }
 
-void CServer::OnProtocolCLMessageReceived ( int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr )
+void CServer::OnProtocolCLMessageReceived ( const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr )
 {
     QMutexLocker locker ( &Mutex );
 
@@ -1616,7 +2410,10 @@ void CServer::OnProtocolCLMessageReceived ( int iRecID, CVector<uint8_t> vecbyMe
     ConnLessProtocol.ParseConnectionLessMessageBody ( vecbyMesBodyData, iRecID, RecHostAddr );
 }
 
-void CServer::OnProtocolMessageReceived ( int iRecCounter, int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr )
+void CServer::OnProtocolMessageReceived ( const int               iRecCounter,
+                                         const int               iRecID,
+                                         const CVector<uint8_t>& vecbyMesBodyData,
+                                         const CHostAddress&     RecHostAddr )
 {
     QMutexLocker locker ( &Mutex );
 
@@ -1630,29 +2427,76 @@ void CServer::OnProtocolMessageReceived ( int iRecCounter, int iRecID, CVector<u
     }
 }
 
-bool CServer::PutAudioData ( const CVector<uint8_t>& vecbyRecBuf, const int iNumBytesRead, const CHostAddress& HostAdr, int& iCurChanID )
+void CServer::PutAudioData ( CVector<CRecvPacket>& vecPackets, const int iNumPackets )
 {
-    QMutexLocker locker ( &Mutex );
+    // Note that the server mutex is not taken here so that the receive threads
+    // do not wait for each other or for the frame processing. The address
+    // table lookup is lock-free and only the channel of the packet is locked.
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        CRecvPacket& Packet = vecPackets[i];
 
-    bool bNewConnection = false; // init return value
+        if ( !Packet.bIsAudio )
+        {
+            continue;
+        }
 
-    // Get channel ID ------------------------------------------------------
-    // check address
-    iCurChanID = FindChannel ( HostAdr, true /* allow new */ );
+        // Get channel ID ------------------------------------------------------
+        const CChannelAddrKey Key = CChannelAddrKey::FromSockAddr ( Packet.SockAddr );
 
-    // If channel is valid or new, put received audio data in jitter buffer ----------------------------
-    if ( iCurChanID != INVALID_CHANNEL_ID )
-    {
-        // put packet in socket buffer
-        if ( vecChannels[iCurChanID].PutAudioData ( vecbyRecBuf, iNumBytesRead, HostAdr ) == PS_NEW_CONNECTION )
+        Packet.iChanID        = ChannelAddrTable.Find ( Key );
+        Packet.bNewConnection = false;
+
+        if ( ( Packet.iChanID != INVALID_INDEX ) && PutAudioPacket ( Packet, Key ) )
+        {
+            continue;
+        }
+
+        // the channel is not connected yet (new connection or server full) or
+        // it was freed after the lookup, the host address is only needed here
+        CSocket::GetHostAddr ( Packet.SockAddr, Packet.HostAddr );
+
+        Packet.iChanID = FindChannel ( Packet.HostAddr, true /* allow new */ );
+
+        // If channel is valid or new, put received audio data in jitter buffer ----------------------------
+        if ( Packet.iChanID != INVALID_CHANNEL_ID )
         {
-            // in case we have a new connection return this information
-            bNewConnection = true;
+            PutAudioPacket ( Packet, Key );
         }
     }
+}
+
+bool CServer::PutAudioPacket ( CRecvPacket& Packet, const CChannelAddrKey& Key )
+{
+    QMutexLocker locker ( &MutexChanAlloc[Packet.iChanID] );
+
+    // the channel may have been freed (and reused) after the lookup, so it is
+    // only valid if it is still allocated to the address of the packet
+    if ( !( vecChanAddrKeys[Packet.iChanID] == Key ) )
+    {
+        return false;
+    }
+
+    CChannel& Channel = vecChannels[Packet.iChanID];
 
-    // return the state if a new connection was happening
-    return bNewConnection;
+    // put packet in socket buffer (in case we have a new connection
+    // return this information)
+    Packet.bNewConnection = ( Channel.PutAudioData ( Packet.vecbyData, Packet.iNumBytes, Channel.GetAddress(), Packet.iArrivalTimeNs ) == PS_NEW_CONNECTION );
+
+    if ( PacketTrace.IsActive() )
+    {
+        PacketTrace.AddPacket ( Packet.iChanID,
+                                Packet.iArrivalTimeNs,
+                                Packet.vecbyData,
+                                Packet.iNumBytes,
+                                CPacketTraceChanProps ( Channel.GetCeltNumCodedBytes(),
+                                                        Channel.GetNetwFrameSizeFact(),
+                                                        Channel.GetUseSequenceNumber(),
+                                                        Channel.GetAudioCompressionType() == CT_OPUS ),
+                                Packet.bNewConnection );
+    }
+
+    return true;
 }
 
 void CServer::GetConCliParam ( CVector<CHostAddress>& vecHostAddresses,
@@ -1691,6 +2535,19 @@ void CServer::SetEnableRecording ( bool bNewEnableRecording )
     CreateAndSendRecorderStateForAllConChannels();
 }
 
+uint64_t CServer::GetNumDroppedProtPackets() const
+{
+    // each receive socket has its own protocol message queue
+    uint64_t iNumDropped = Socket.GetNumDroppedProtPackets();
+
+    for ( const std::unique_ptr<CHighPrioSocket>& pRecvSocket : vecRecvSockets )
+    {
+        iNumDropped += pRecvSocket->GetNumDroppedProtPackets();
+    }
+
+    return iNumDropped;
+}
+
 void CServer::SetWelcomeMessage ( const QString& strNWelcMess )
 {
     // we need a mutex to secure access
@@ -1763,15 +2620,17 @@ void CServer::customEvent ( QEvent* pEvent )
             // no effect
             Start();
             break;
+
+        case MS_DEFERRED_EVENTS:
+            // handle the events of the frame processing in the timer thread
+            ProcessDeferredEvents();
+            break;
         }
     }
 }
 
 /// @brief Compute frame peak level for each client
-bool CServer::CreateLevelsForAllConChannels ( const int                       iNumClients,
-                                              const CVector<int>&             vecNumAudioChannels,
-                                              const CVector<CVector<int16_t>> vecvecsData,
-                                              CVector<uint16_t>&              vecLevelsOut )
+bool CServer::CreateLevelsForAllConChannels ( const CServerFrame& Frame, CVector<uint16_t>& vecLevelsOut )
 {
     bool bLevelsWereUpdated = false;
 
@@ -1781,12 +2640,13 @@ bool CServer::CreateLevelsForAllConChannels ( const int                       iN
         iFrameCount        = 0;
         bLevelsWereUpdated = true;
 
-        for ( int j = 0; j < iNumClients; j++ )
+        for ( int j = 0; j < Frame.iNumClients; j++ )
         {
             // update and get signal level for meter in dB for each channel
-            const double dCurSigLevelForMeterdB = vecChannels[vecChanIDsCurConChan[j]].UpdateAndGetLevelForMeterdB ( vecvecsData[j],
-                                                                                                                     iServerFrameSizeSamples,
-                                                                                                                     vecNumAudioChannels[j] > 1 );
+            const double dCurSigLevelForMeterdB =
+                vecChannels[Frame.vecChanIDsCurConChan[j]].UpdateAndGetLevelForMeterdB ( Frame.vecvecsData[j],
+                                                                                         iServerFrameSizeSamples,
+                                                                                         Frame.vecNumAudioChannels[j] > 1 );
 
             // map value to integer for transmission via the protocol (4 bit available)
             vecLevelsOut[j] = static_cast<uint16_t> ( std::ceil ( dCurSigLevelForMeterdB ) );
@@ -42,15 +42,35 @@
 #include "channel.h"
 #include "util.h"
 #include "serverlogging.h"
+#include "packettrace.h"
 #include "serverlist.h"
 #include "recorder/jamcontroller.h"
 
-#include "threadpool.h"
+#include "frameworkerpool.h"
+#include "lockfreequeue.h"
+#include "chanaddrtable.h"
+#include <chrono>
+#include <functional>
 
 /* Definitions ****************************************************************/
 // no valid channel number
 #define INVALID_CHANNEL_ID ( MAX_NUM_CHANNELS + 1 )
 
+// number of work chunks per thread for multithreading (more chunks give a
+// better load balance at the cost of more synchronization)
+#define MT_NUM_CHUNKS_PER_THREAD 4
+
+// weight of the moving average of the per channel processing time
+#define MT_COST_IIR_WEIGHT 0.01f
+
+// initial per channel processing time of a new channel until it is measured
+#define MT_DEF_DECODE_COST_US     20.0f
+#define MT_DEF_MIX_ENCODE_COST_US 50.0f
+
+// size of the queue for the events which are deferred from the timer thread
+// to the main thread (in frames with all channels connected)
+#define DEFERRED_EVENT_QUEUE_NUM_FRAMES 8
+
 /* Classes ********************************************************************/
 #if ( defined( WIN32 ) || defined( _WIN32 ) )
 // using QTimer for Windows
@@ -65,12 +85,17 @@ public:
     void Stop();
     bool isActive() const { return Timer.isActive(); }
 
+    // if a callback is set, it is called directly instead of emitting the
+    // timeout() signal
+    void SetCallback ( const std::function<void()>& NewCallback ) { Callback = NewCallback; }
+
 protected:
-    QTimer       Timer;
-    CVector<int> veciTimeOutIntervals;
-    int          iCurPosInVector;
-    int          iIntervalCounter;
-    bool         bUseDoubleSystemFrameSize;
+    QTimer                Timer;
+    CVector<int>          veciTimeOutIntervals;
+    int                   iCurPosInVector;
+    int                   iIntervalCounter;
+    bool                  bUseDoubleSystemFrameSize;
+    std::function<void()> Callback;
 
 public slots:
     void OnTimer();
@@ -99,10 +124,15 @@ public:
     void Stop();
     bool isActive() { return bRun; }
 
+    // if a callback is set, it is called directly in the timer thread instead
+    // of emitting the timeout() signal
+    void SetCallback ( const std::function<void()>& NewCallback ) { Callback = NewCallback; }
+
 protected:
     virtual void run();
 
-    bool     bRun;
+    bool                  bRun;
+    std::function<void()> Callback;
 
 #    if defined( __APPLE__ ) || defined( __MACOSX )
     uint64_t Delay;
@@ -117,6 +147,71 @@ signals:
 };
 #endif
 
+// Stages of the frame processing for the timing statistics. The decoding,
+// mixing, encoding and sending are measured per channel and summed over all
+// threads (CPU time), the others are measured in the timer thread.
+enum EServerPerfStage
+{
+    PS_LOCK_COLLECT  = 0, // locking and collecting the connected channels
+    PS_DECODE        = 1, // decoding (CPU time)
+    PS_LEVELS        = 2, // channel level computation
+    PS_MIX           = 3, // mixing (CPU time)
+    PS_ENCODE        = 4, // encoding (CPU time)
+    PS_SEND          = 5, // sending (CPU time)
+    PS_FRAME         = 6, // entire frame processing (wall time)
+    PS_WAKE_LATENESS = 7, // frame start compared to the ideal timer interval
+    PS_NUM_STAGES    = 8
+};
+
+// Data of one frame which is produced by the decoding of the received audio
+// and used by the mixing. In pipelined mode the server has two of them, one
+// is decoded (frame N + 1) while the other one is mixed (frame N).
+class CServerFrame
+{
+public:
+    CServerFrame() : iNumClients ( 0 ) {}
+
+    void Init ( const int iMaxNumChannels );
+
+    int                       iNumClients;
+    CVector<int>              vecChanIDsCurConChan;
+    CVector<CVector<float>>   vecvecfGains;
+    CVector<CVector<float>>   vecvecfPannings;
+    CVector<CVector<int16_t>> vecvecsData;
+    CVector<CVector<uint8_t>> vecvecbyCodedData;
+    CVector<int>              vecNumAudioChannels;
+    CVector<int>              vecNumFrameSizeConvBlocks;
+    CVector<int>              vecUseDoubleSysFraSizeConvBuf;
+    CVector<EAudComprType>    vecAudioComprType;
+
+    // channels which were disconnected while the frame was decoded, they are
+    // freed after the decoding and must not be mixed anymore (the channel ID
+    // may already be used by a new client)
+    CVector<int> vecChanDisconnected;
+
+    // number of channels which deviate from the shared mix bus and hash of
+    // the gains/pans of each listener (see CServer)
+    CVector<int>      vecNumMixBusCorrections;
+    CVector<uint32_t> vecMixSignatureHash;
+
+    // processing times of each channel for the timing statistics
+    CVector<int64_t> vecDecodeTimeNs;
+    CVector<int64_t> vecMixTimeNs;
+    CVector<int64_t> vecEncodeTimeNs;
+    CVector<int64_t> vecSendTimeNs;
+};
+
+// Audio data for the jam recorder which has to be handled in the main thread
+// because it touches Qt objects (only used if the frame is processed in the
+// timer thread).
+class CDeferredAudioFrame
+{
+public:
+    int     iChanID;
+    int     iNumAudioChannels;
+    int16_t vecsData[2 /* stereo */ * DOUBLE_SYSTEM_FRAME_SIZE_SAMPLES /* worst case buffer size */];
+};
+
 template<unsigned int slotId>
 class CServerSlots : public CServerSlots<slotId - 1>
 {
@@ -151,26 +246,33 @@ class CServer : public QObject, public CServerSlots<MAX_NUM_CHANNELS>
     Q_OBJECT
 
 public:
-    CServer ( const int          iNewMaxNumChan,
-              const QString&     strLoggingFileName,
-              const QString&     strServerBindIP,
-              const quint16      iPortNumber,
-              const quint16      iQosNumber,
-              const QString&     strHTMLStatusFileName,
-              const QString&     strDirectoryServer,
-              const QString&     strServerListFileName,
-              const QString&     strServerInfo,
-              const QString&     strServerListFilter,
-              const QString&     strServerPublicIP,
-              const QString&     strNewWelcomeMessage,
-              const QString&     strRecordingDirName,
-              const bool         bNDisconnectAllClientsOnQuit,
-              const bool         bNUseDoubleSystemFrameSize,
-              const bool         bNUseMultithreading,
-              const bool         bDisableRecording,
-              const bool         bNDelayPan,
-              const bool         bNEnableIPv6,
-              const ELicenceType eNLicenceType );
+    CServer ( const int             iNewMaxNumChan,
+              const QString&        strLoggingFileName,
+              const QString&        strPacketTraceFileName,
+              const QString&        strServerBindIP,
+              const quint16         iPortNumber,
+              const quint16         iQosNumber,
+              const QString&        strHTMLStatusFileName,
+              const QString&        strDirectoryServer,
+              const QString&        strServerListFileName,
+              const QString&        strServerInfo,
+              const QString&        strServerListFilter,
+              const QString&        strServerPublicIP,
+              const QString&        strNewWelcomeMessage,
+              const QString&        strRecordingDirName,
+              const bool            bNDisconnectAllClientsOnQuit,
+              const bool            bNUseDoubleSystemFrameSize,
+              const bool            bNUseMultithreading,
+              const bool            bNPinWorkers,
+              const bool            bNUsePipelining,
+              const bool            bNUseTimerThread,
+              const int             iNNumRecvThreads,
+              const bool            bNUseIoUring,
+              const bool            bDisableRecording,
+              const bool            bNDelayPan,
+              const bool            bNEnableIPv6,
+              const ELicenceType    eNLicenceType,
+              const EJitBufStrategy eNJitBufStrategy );
 
     virtual ~CServer();
 
@@ -178,7 +280,9 @@ public:
     void Stop();
     bool IsRunning() { return HighPrecisionTimer.isActive(); }
 
-    bool PutAudioData ( const CVector<uint8_t>& vecbyRecBuf, const int iNumBytesRead, const CHostAddress& HostAdr, int& iCurChanID );
+    // puts the audio packets of a receive batch of the socket and sets their
+    // channel ID and new connection flag
+    void PutAudioData ( CVector<CRecvPacket>& vecPackets, const int iNumPackets );
 
     int GetNumberOfConnectedClients();
 
@@ -195,6 +299,8 @@ public:
     // GUI settings ------------------------------------------------------------
     int GetClientNumAudioChannels ( const int iChanNum ) { return vecChannels[iChanNum].GetNumAudioChannels(); }
 
+    void GetClientArrivalJitterInfo ( const int iChanNum, CArrivalJitterInfo& Info ) { vecChannels[iChanNum].GetArrivalJitterInfo ( Info ); }
+
     void           SetDirectoryType ( const EDirectoryType eNCSAT ) { ServerListManager.SetDirectoryType ( eNCSAT ); }
     EDirectoryType GetDirectoryType() { return ServerListManager.GetDirectoryType(); }
     bool           IsDirectoryServer() { return ServerListManager.IsDirectoryServer(); }
@@ -219,6 +325,12 @@ public:
     }
     QString GetRecordingDir() { return JamController.GetRecordingDir(); }
 
+    // frame timing statistics
+    const CTimingHistogram& GetPerfHistogram ( const EServerPerfStage eStage ) const { return PerfHistograms[eStage]; }
+    uint64_t                GetNumDeadlineMisses() const { return iNumDeadlineMisses; }
+    int64_t                 GetFramePeriodNs() const { return iFramePeriodNs; }
+    uint64_t                GetNumDroppedProtPackets() const;
+
     void    SetWelcomeMessage ( const QString& strNWelcMess );
     QString GetWelcomeMessage() { return strWelcomeMessage; }
 
@@ -241,6 +353,7 @@ protected:
     int                   FindChannel ( const CHostAddress& CheckAddr, const bool bAllowNew = false );
     void                  InitChannel ( const int iNewChanID, const CHostAddress& InetAddr );
     void                  FreeChannel ( const int iCurChanID );
+    bool                  PutAudioPacket ( CRecvPacket& Packet, const CChannelAddrKey& Key );
     void                  DumpChannels ( const QString& title );
     CVector<CChannelInfo> CreateChannelList();
 
@@ -261,13 +374,30 @@ protected:
     void WriteHTMLChannelList();
     void WriteHTMLServerQuit();
 
-    static void DecodeReceiveDataBlocks ( CServer* pServer, const int iStartChanCnt, const int iStopChanCnt, const int iNumClients );
+    static void DecodeReceiveDataBlocks ( CServer* pServer, CServerFrame& Frame, const int iStartChanCnt, const int iStopChanCnt );
+
+    void DecodeReceiveData ( CServerFrame& Frame, const int iChanCnt );
+
+    void PrepareMixFrame ( CServerFrame& Frame );
+
+    void MixEncodeTransmitData ( CServerFrame& Frame, const int iChanCnt, CSendBatch& SendBatch );
 
-    static void MixEncodeTransmitDataBlocks ( CServer* pServer, const int iStartChanCnt, const int iStopChanCnt, const int iNumClients );
+    bool IsMixBusCorrection ( const CServerFrame& Frame, const int iChanCnt, const int j ) const;
 
-    void DecodeReceiveData ( const int iChanCnt, const int iNumClients );
+    void CreateSharedMixBuses ( const CServerFrame& Frame );
 
-    void MixEncodeTransmitData ( const int iChanCnt, const int iNumClients );
+    bool IsSameMix ( const CServerFrame& Frame, const int iChanCntA, const int iChanCntB ) const;
+
+    void CreateMixGroups ( const CServerFrame& Frame );
+
+    void PushDeferredAudioFrame ( const CServerFrame& Frame, const int iChanCnt );
+    void SetDeferredEvent ( std::atomic<bool>& bEventPending );
+    void PostDeferredEvents();
+
+    void ProcessDeferredEvents();
+
+    OpusCustomEncoder* GetOpusEncoder ( const int iChanID, const EAudComprType eAudioComprType, const int iNumAudioChannels );
+    void               ResetLastEncoder ( const int iChanID );
 
     virtual void customEvent ( QEvent* pEvent );
 
@@ -278,14 +408,25 @@ protected:
     int  iServerFrameSizeSamples;
 
     // variables needed for multithreading support
-    bool                       bUseMultithreading;
-    int                        iMaxNumThreads;
-    CVector<std::future<void>> Futures;
-
-    bool CreateLevelsForAllConChannels ( const int                       iNumClients,
-                                         const CVector<int>&             vecNumAudioChannels,
-                                         const CVector<CVector<int16_t>> vecvecsData,
-                                         CVector<uint16_t>&              vecLevelsOut );
+    bool           bUseMultithreading;
+    bool           bUsePipelining;
+    int            iMaxNumThreads;
+    CVector<int>   vecMTDecodeChanOrder;
+    CVector<int>   vecMTDecodeChunkStart;
+    CVector<int>   vecMTMixChanOrder;
+    CVector<int>   vecMTMixChunkStart;
+    CVector<float> vecfDecodeCostUs;    // estimated cost per channel ID
+    CVector<float> vecfMixEncodeCostUs; // estimated cost per channel ID
+
+    // outgoing audio packets, one batch per frame processing thread
+    CVector<CSendBatch> vecSendBatches;
+
+    int CreateMTChunks ( const CServerFrame& Frame, const CVector<float>& vecfCostUs, CVector<int>& vecChanOrder, CVector<int>& vecChunkStart );
+    void UpdateMTCost ( CVector<float>& vecfCostUs, const int iChanID, const int64_t iTimeNs );
+    void DecodeReceiveDataChunk ( CServerFrame& Frame, const int iChunkCnt );
+    void MixEncodeTransmitDataChunk ( CServerFrame& Frame, const int iChunkCnt );
+
+    bool CreateLevelsForAllConChannels ( const CServerFrame& Frame, CVector<uint16_t>& vecLevelsOut );
 
     // do not use the vector class since CChannel does not have appropriate
     // copy constructor/operator
@@ -296,18 +437,31 @@ protected:
     int    vecChannelOrder[MAX_NUM_CHANNELS];
     QMutex MutexChanOrder;
 
+    // address to channel ID lookup for the connected channels and the address
+    // key each channel is allocated to (to validate a lock-free lookup, the key
+    // is protected by the allocation mutex of the channel)
+    CChannelAddrTable        ChannelAddrTable;
+    CVector<CChannelAddrKey> vecChanAddrKeys;
+    QMutex                   MutexChanAlloc[MAX_NUM_CHANNELS];
+
+    // set by InitChannel() in the receive threads, the frame processing state
+    // of the new channel (encoder tracking, cost estimates) is reset by the
+    // timer thread before the channel is processed the first time
+    std::atomic<bool> bNewChannelPending[MAX_NUM_CHANNELS];
+
     CProtocol ConnLessProtocol;
     QMutex    Mutex;
     QMutex    MutexWelcomeMessage;
     bool      bChannelIsNowDisconnected;
 
-    // audio encoder/decoder
-    OpusCustomMode*    Opus64Mode[MAX_NUM_CHANNELS];
+    // audio encoder/decoder (the modes are shared by all channels so that the
+    // state of an encoder may be copied to the encoder of another channel)
+    OpusCustomMode*    Opus64Mode;
     OpusCustomEncoder* Opus64EncoderMono[MAX_NUM_CHANNELS];
     OpusCustomDecoder* Opus64DecoderMono[MAX_NUM_CHANNELS];
     OpusCustomEncoder* Opus64EncoderStereo[MAX_NUM_CHANNELS];
     OpusCustomDecoder* Opus64DecoderStereo[MAX_NUM_CHANNELS];
-    OpusCustomMode*    OpusMode[MAX_NUM_CHANNELS];
+    OpusCustomMode*    OpusMode;
     OpusCustomEncoder* OpusEncoderMono[MAX_NUM_CHANNELS];
     OpusCustomDecoder* OpusDecoderMono[MAX_NUM_CHANNELS];
     OpusCustomEncoder* OpusEncoderStereo[MAX_NUM_CHANNELS];
@@ -316,29 +470,56 @@ protected:
     CConvBuf<int16_t>  DoubleFrameSizeConvBufOut[MAX_NUM_CHANNELS];
 
     CVector<QString> vstrChatColors;
-    CVector<int>     vecChanIDsCurConChan;
 
-    CVector<CVector<float>>   vecvecfGains;
-    CVector<CVector<float>>   vecvecfPannings;
-    CVector<CVector<int16_t>> vecvecsData;
+    // decoded frame data (in pipelined mode the next frame is decoded in the
+    // second buffer while the current frame is mixed)
+    CServerFrame  FrameData[2];
+    CServerFrame* pDecodeFrame;
+    CServerFrame* pMixFrame;
+
     CVector<CVector<int16_t>> vecvecsData2;
-    CVector<int>              vecNumAudioChannels;
-    CVector<int>              vecNumFrameSizeConvBlocks;
-    CVector<int>              vecUseDoubleSysFraSizeConvBuf;
-    CVector<EAudComprType>    vecAudioComprType;
     CVector<CVector<int16_t>> vecvecsSendData;
     CVector<CVector<float>>   vecvecfIntermediateProcBuf;
-    CVector<CVector<uint8_t>> vecvecbyCodedData;
 
-    // Channel levels
-    CVector<uint16_t> vecChannelLevels;
+    // shared mix buses ("mix-minus"): sum of all clients at default gain/pan
+    // which are used as the base of all mixes which only deviate in a few
+    // channels from the default
+    CVector<float> vecfMonoMixBus;
+    CVector<float> vecfStereoMixBus;
+    bool           bUseMonoMixBus;
+    bool           bUseStereoMixBus;
+
+    // listeners with identical mixes (same gains/pans, codec and coded bytes)
+    // are grouped so that their mix is only mixed and encoded once by the
+    // group leader which sends the coded data to all group members
+    CVector<int> vecCeltNumCodedBytes;
+    CVector<int> vecMixGroupLeader;
+    CVector<int> vecMixGroupNext;
+    CVector<int> vecMixGroupLeaderList;
+
+    // the encoder which has produced the last coded packet of each channel
+    // (indexed by the channel ID), used to keep the encoder state continuous
+    // if the group of a channel changes
+    CVector<int>       vecLastEncoderChanID;
+    OpusCustomEncoder* pLastEncoder[MAX_NUM_CHANNELS];
+
+    // Channel levels and the addresses the level list is sent to
+    CVector<uint16_t>     vecChannelLevels;
+    CVector<CHostAddress> vecChannelLevelsAddr;
 
     // actual working objects
     CHighPrioSocket Socket;
 
+    // additional receive sockets on the same port as the main socket (all
+    // packets are sent through the main socket)
+    std::vector<std::unique_ptr<CHighPrioSocket>> vecRecvSockets;
+
     // logging
     CServerLogging Logging;
 
+    // recording of the packet arrivals for the jitter buffer evaluation
+    CPacketTraceWriter PacketTrace;
+
     // channel level update frame interval counter
     int iFrameCount;
 
@@ -371,7 +552,35 @@ protected:
 
     CSignalHandler* pSignalHandler;
 
-    std::unique_ptr<CThreadPool> pThreadPool;
+    std::unique_ptr<CFrameWorkerPool> pFrameWorkers;
+
+    // frame processing in the timer thread: events which touch Qt objects are
+    // deferred to the main thread. The audio frames for the jam recorder are
+    // passed in a bounded queue and are dropped if it is full. All other events
+    // are flags which are set by the timer thread and cleared by the main
+    // thread, so they are never lost. The channel levels are passed in a
+    // snapshot which is only written by the timer thread if it is not pending.
+    bool                                bUseTimerThread;
+    CLockFreeQueue<CDeferredAudioFrame> DeferredAudioFrames;
+    std::atomic<bool>                   bDeferredEventsPosted;
+    std::atomic<bool>                   bChanListChangedPending;
+    std::atomic<bool>                   bServerIdlePending;
+    std::atomic<bool>                   bChannelLevelsPending;
+    std::atomic<bool>                   bClientDisconnectedPending[MAX_NUM_CHANNELS];
+    CVector<int>                        vecDeferredDisconnChanIDs;
+    CVector<uint16_t>                   vecDeferredChannelLevels;
+    CVector<int>                        vecDeferredLevelsChanIDs;
+    int                                 iDeferredLevelsNumClients;
+    CVector<int16_t>                    vecsDeferredAudioData;
+
+    // frame timing statistics (the due time of the next frame is according to
+    // the ideal timer interval)
+    CTimingHistogram                      PerfHistograms[PS_NUM_STAGES];
+    std::atomic<uint64_t>                 iNumDeadlineMisses;
+    int64_t                               iFramePeriodNs;
+    std::chrono::steady_clock::time_point tFrameDue;
+
+    void UpdatePerfStats ( const CServerFrame& DecodeFrame, const CServerFrame& MixFrame, const std::chrono::steady_clock::time_point& tFrameStart );
 
 signals:
     void Started();
@@ -401,9 +610,9 @@ public slots:
 
     void OnSendCLProtMessage ( CHostAddress InetAddr, CVector<uint8_t> vecMessage );
 
-    void OnProtocolCLMessageReceived ( int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr );
+    void OnProtocolCLMessageReceived ( const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr );
 
-    void OnProtocolMessageReceived ( int iRecCounter, int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress RecHostAddr );
+    void OnProtocolMessageReceived ( const int iRecCounter, const int iRecID, const CVector<uint8_t>& vecbyMesBodyData, const CHostAddress& RecHostAddr );
 
     void OnCLPingReceived ( CHostAddress InetAddr, int iMs ) { ConnLessProtocol.CreateCLPingMes ( InetAddr, iMs ); }
 
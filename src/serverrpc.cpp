@@ -62,6 +62,15 @@ CServerRpc::CServerRpc ( CServer* pServer, CRpcServer* pRpcServer, QObject* pare
     /// @result {string} result.clients[*].name - The client’s name.
     /// @result {number} result.clients[*].jitterBufferSize - The client’s jitter buffer size.
     /// @result {number} result.clients[*].channels - The number of audio channels of the client.
+    /// @result {object} result.clients[*].arrivalJitter - The statistic of the audio packet arrival times (kernel receive timestamps).
+    /// @result {number} result.clients[*].arrivalJitter.packets - The number of packets in the statistic.
+    /// @result {number} result.clients[*].arrivalJitter.meanIntervalMs - The mean inter-arrival time in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.p99IntervalMs - The 99th percentile of the inter-arrival times in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.p50DelayMs - The median packet delay compared to the fastest packets in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.p95DelayMs - The 95th percentile of the packet delay in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.p99DelayMs - The 99th percentile of the packet delay in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.maxDelayMs - The maximum packet delay in milliseconds.
+    /// @result {number} result.clients[*].arrivalJitter.driftPpm - The deviation of the mean inter-arrival time from the nominal packet interval in ppm.
     pRpcServer->HandleMethod ( "jamulusserver/getClients", [=] ( const QJsonObject& params, QJsonObject& response ) {
         QJsonArray            clients;
         CVector<CHostAddress> vecHostAddresses;
@@ -81,12 +90,27 @@ CServerRpc::CServerRpc ( CServer* pServer, CRpcServer* pRpcServer, QObject* pare
             {
                 continue;
             }
+            CArrivalJitterInfo ArrivalJitterInfo;
+            pServer->GetClientArrivalJitterInfo ( i, ArrivalJitterInfo );
+
+            QJsonObject arrivalJitter{
+                { "packets", ArrivalJitterInfo.iNumPackets },
+                { "meanIntervalMs", ArrivalJitterInfo.dMeanIntervalMs },
+                { "p99IntervalMs", ArrivalJitterInfo.dIntervalP99Ms },
+                { "p50DelayMs", ArrivalJitterInfo.dDelayP50Ms },
+                { "p95DelayMs", ArrivalJitterInfo.dDelayP95Ms },
+                { "p99DelayMs", ArrivalJitterInfo.dDelayP99Ms },
+                { "maxDelayMs", ArrivalJitterInfo.dDelayMaxMs },
+                { "driftPpm", ArrivalJitterInfo.dDriftPpm },
+            };
+
             QJsonObject client{
                 { "id", i },
                 { "address", vecHostAddresses[i].toString ( CHostAddress::SM_IP_PORT ) },
                 { "name", vecsName[i] },
                 { "jitterBufferSize", veciJitBufNumFrames[i] },
                 { "channels", pServer->GetClientNumAudioChannels ( i ) },
+                { "arrivalJitter", arrivalJitter },
             };
             clients.append ( client );
         }
@@ -99,6 +123,70 @@ CServerRpc::CServerRpc ( CServer* pServer, CRpcServer* pRpcServer, QObject* pare
         Q_UNUSED ( params );
     } );
 
+    /// @rpc_method jamulusserver/getPerformanceStats
+    /// @brief Returns the timing statistics of the audio frame processing since the server was started.
+    /// @param {object} params - No parameters (empty object).
+    /// @result {number} result.framePeriodUs - The frame period (the processing deadline of a frame) in microseconds.
+    /// @result {number} result.deadlineMisses - The number of frames which were not processed before the next frame was due.
+    /// @result {number} result.droppedProtocolMessages - The number of received protocol messages which were dropped since the receive queue was full.
+    /// @result {array} result.stages - The statistics of the processing stages.
+    /// @result {string} result.stages[*].name - The name of the stage: lockCollect, decode, levels, mix, encode, send, frame or wakeLateness.
+    ///  The decode, mix, encode and send times are summed over all channels and threads (CPU time).
+    ///  The wake lateness is the delay of the frame start compared to the ideal timer interval.
+    /// @result {number} result.stages[*].count - The number of measured frames.
+    /// @result {number} result.stages[*].meanUs - The mean time in microseconds.
+    /// @result {number} result.stages[*].p50Us - The median time in microseconds (bucket upper bound).
+    /// @result {number} result.stages[*].p99Us - The 99th percentile in microseconds (bucket upper bound).
+    /// @result {number} result.stages[*].p999Us - The 99.9th percentile in microseconds (bucket upper bound).
+    /// @result {number} result.stages[*].maxUs - The maximum time in microseconds.
+    /// @result {array} result.stages[*].histogram - The non-empty histogram buckets.
+    /// @result {number} result.stages[*].histogram[*].upperUs - The upper bound of the bucket in microseconds (exclusive).
+    /// @result {number} result.stages[*].histogram[*].count - The number of frames in the bucket.
+    pRpcServer->HandleMethod ( "jamulusserver/getPerformanceStats", [=] ( const QJsonObject& params, QJsonObject& response ) {
+        QJsonArray stages;
+
+        for ( int i = 0; i < PS_NUM_STAGES; i++ )
+        {
+            const CTimingHistogram& Histogram = pServer->GetPerfHistogram ( static_cast<EServerPerfStage> ( i ) );
+            QJsonArray              histogram;
+
+            for ( int iBucket = 0; iBucket < TIMING_HIST_NUM_BUCKETS; iBucket++ )
+            {
+                const uint64_t iCount = Histogram.GetBucketCount ( iBucket );
+
+                if ( iCount > 0 )
+                {
+                    QJsonObject bucket{
+                        { "upperUs", CTimingHistogram::GetBucketUpperUs ( iBucket ) },
+                        { "count", static_cast<double> ( iCount ) },
+                    };
+                    histogram.append ( bucket );
+                }
+            }
+
+            QJsonObject stage{
+                { "name", SerializePerfStage ( static_cast<EServerPerfStage> ( i ) ) },
+                { "count", static_cast<double> ( Histogram.GetCount() ) },
+                { "meanUs", Histogram.GetMeanUs() },
+                { "p50Us", Histogram.GetPercentileUs ( 50 ) },
+                { "p99Us", Histogram.GetPercentileUs ( 99 ) },
+                { "p999Us", Histogram.GetPercentileUs ( 99.9 ) },
+                { "maxUs", Histogram.GetMaxUs() },
+                { "histogram", histogram },
+            };
+            stages.append ( stage );
+        }
+
+        QJsonObject result{
+            { "framePeriodUs", static_cast<double> ( pServer->GetFramePeriodNs() ) / 1000 },
+            { "deadlineMisses", static_cast<double> ( pServer->GetNumDeadlineMisses() ) },
+            { "droppedProtocolMessages", static_cast<double> ( pServer->GetNumDroppedProtPackets() ) },
+            { "stages", stages },
+        };
+        response["result"] = result;
+        Q_UNUSED ( params );
+    } );
+
     /// @rpc_method jamulusserver/getServerProfile
     /// @brief Returns the server registration profile and status.
     /// @param {object} params - No parameters (empty object).
@@ -244,3 +332,38 @@ QJsonValue CServerRpc::SerializeRegistrationStatus ( ESvrRegStatus eSvrRegStatus
 
     return QString ( "unknown(%1)" ).arg ( eSvrRegStatus );
 }
+
+QJsonValue CServerRpc::SerializePerfStage ( EServerPerfStage eStage )
+{
+    switch ( eStage )
+    {
+    case PS_LOCK_COLLECT:
+        return "lockCollect";
+
+    case PS_DECODE:
+        return "decode";
+
+    case PS_LEVELS:
+        return "levels";
+
+    case PS_MIX:
+        return "mix";
+
+    case PS_ENCODE:
+        return "encode";
+
+    case PS_SEND:
+        return "send";
+
+    case PS_FRAME:
+        return "frame";
+
+    case PS_WAKE_LATENESS:
+        return "wakeLateness";
+
+    case PS_NUM_STAGES:
+        break;
+    }
+
+    return QString ( "unknown(%1)" ).arg ( eStage );
+}
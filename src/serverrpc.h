@@ -36,4 +36,5 @@ class CServerRpc : public QObject
 public:
     CServerRpc ( CServer* pServer, CRpcServer* pRpcServer, QObject* parent = nullptr );
     static QJsonValue SerializeRegistrationStatus ( ESvrRegStatus eSvrRegStatus );
+    static QJsonValue SerializePerfStage ( EServerPerfStage eStage );
 };
@@ -31,8 +31,22 @@
 #else
 #    include <arpa/inet.h>
 #endif
+#ifdef __linux__
+#    include <netinet/udp.h>
+#    ifndef UDP_SEGMENT
+#        define UDP_SEGMENT 103 // older C library headers do not define it
+#    endif
+#endif
+#include <cerrno>
+#include <chrono>
 
 /* Implementation *************************************************************/
+#ifdef __linux__
+// a GSO message which fails with one of these errors is not supported by the
+// network device (e.g. no checksum offload), other errors like ENOBUFS or
+// EAGAIN are transient and only drop the message
+static bool IsGsoUnsupportedError ( const int iError ) { return ( iError == EIO ) || ( iError == EINVAL ) || ( iError == EOPNOTSUPP ); }
+#endif
 
 // Connections -------------------------------------------------------------
 // it is important to do the following connections in this class since we
@@ -42,32 +56,48 @@
 
 CSocket::CSocket ( CChannel* pNewChannel, const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP, bool bEnableIPv6 ) :
     pChannel ( pNewChannel ),
+    bProtPacketsPosted ( false ),
     bIsClient ( true ),
     bJitterBufferOK ( true ),
-    bEnableIPv6 ( bEnableIPv6 )
+    bEnableIPv6 ( bEnableIPv6 ),
+    bReusePort ( false ),
+    bUseIoUring ( false )
 {
-    Init ( iPortNumber, iQosNumber, strServerBindIP );
+    ProtPacketQueue.Init ( NUM_PROT_PACKET_SLOTS );
+    vecbyRecMesBodyData.reserve ( MAX_SIZE_BYTES_NETW_BUF );
 
-    // client connections:
-    QObject::connect ( this, &CSocket::ProtocolMessageReceived, pChannel, &CChannel::OnProtocolMessageReceived );
+    Init ( iPortNumber, iQosNumber, strServerBindIP );
 
-    QObject::connect ( this, &CSocket::ProtocolCLMessageReceived, pChannel, &CChannel::OnProtocolCLMessageReceived );
+    // client connections (the queued protocol messages are processed in the
+    // thread of the channel):
+    QObject::connect ( this, &CSocket::ProtocolPacketsQueued, pChannel, [this]() { ProcessProtocolPackets(); } );
 
     QObject::connect ( this, static_cast<void ( CSocket::* )()> ( &CSocket::NewConnection ), pChannel, &CChannel::OnNewConnection );
 }
 
-CSocket::CSocket ( CServer* pNServP, const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP, bool bEnableIPv6 ) :
+CSocket::CSocket ( CServer*       pNServP,
+                   const quint16  iPortNumber,
+                   const quint16  iQosNumber,
+                   const QString& strServerBindIP,
+                   bool           bEnableIPv6,
+                   bool           bReusePort,
+                   bool           bUseIoUring ) :
     pServer ( pNServP ),
+    bProtPacketsPosted ( false ),
     bIsClient ( false ),
     bJitterBufferOK ( true ),
-    bEnableIPv6 ( bEnableIPv6 )
+    bEnableIPv6 ( bEnableIPv6 ),
+    bReusePort ( bReusePort ),
+    bUseIoUring ( bUseIoUring )
 {
-    Init ( iPortNumber, iQosNumber, strServerBindIP );
+    ProtPacketQueue.Init ( NUM_PROT_PACKET_SLOTS );
+    vecbyRecMesBodyData.reserve ( MAX_SIZE_BYTES_NETW_BUF );
 
-    // server connections:
-    QObject::connect ( this, &CSocket::ProtocolMessageReceived, pServer, &CServer::OnProtocolMessageReceived );
+    Init ( iPortNumber, iQosNumber, strServerBindIP );
 
-    QObject::connect ( this, &CSocket::ProtocolCLMessageReceived, pServer, &CServer::OnProtocolCLMessageReceived );
+    // server connections (the queued protocol messages are processed in the
+    // thread of the server):
+    QObject::connect ( this, &CSocket::ProtocolPacketsQueued, pServer, [this]() { ProcessProtocolPackets(); } );
 
     QObject::connect ( this,
                        static_cast<void ( CSocket::* ) ( int, int, CHostAddress )> ( &CSocket::NewConnection ),
@@ -163,14 +193,72 @@ void CSocket::Init ( const quint16 iNewPortNumber, const quint16 iNewQosNumber,
         }
     }
 
+#ifdef __linux__
+    if ( bReusePort )
+    {
+        // allow multiple server sockets on the same port, the kernel distributes
+        // the incoming packets by the source address over the sockets
+        const int iReusePort = 1;
+
+        if ( setsockopt ( UdpSocket, SOL_SOCKET, SO_REUSEPORT, &iReusePort, sizeof ( iReusePort ) ) != 0 )
+        {
+            // the socket still works on its own, the server uses no other
+            // receive sockets in this case
+            qWarning() << "SO_REUSEPORT is not supported (error" << errno << "), using one receive thread";
+            bReusePort = false;
+        }
+    }
+#endif
+
 #ifdef Q_OS_IOS
     // ignore the broken pipe signal to avoid crash (iOS)
     int valueone = 1;
     setsockopt ( UdpSocket, SOL_SOCKET, SO_NOSIGPIPE, &valueone, sizeof ( valueone ) );
 #endif
 
-    // allocate memory for network receive and send buffer in samples
-    vecbyRecBuf.Init ( MAX_SIZE_BYTES_NETW_BUF );
+    // allocate memory for the network receive batch
+    const int iRecBatchSize = bIsClient ? 1 : NUM_RECV_BATCH_PACKETS;
+
+    vecRecPackets.Init ( iRecBatchSize );
+
+    for ( int i = 0; i < iRecBatchSize; i++ )
+    {
+        vecRecPackets[i].vecbyData.Init ( MAX_SIZE_BYTES_NETW_BUF );
+    }
+
+#ifdef __linux__
+    // the message headers of recvmmsg point directly to the packet slots
+    vecRecMsgHdrs.resize ( iRecBatchSize );
+    vecRecIoVecs.resize ( iRecBatchSize );
+    vecRecCtrlBufs.resize ( iRecBatchSize );
+
+    for ( int i = 0; i < iRecBatchSize; i++ )
+    {
+        vecRecIoVecs[i].iov_base = &vecRecPackets[i].vecbyData[0];
+        vecRecIoVecs[i].iov_len  = MAX_SIZE_BYTES_NETW_BUF;
+
+        memset ( &vecRecMsgHdrs[i], 0, sizeof ( struct mmsghdr ) );
+        vecRecMsgHdrs[i].msg_hdr.msg_name    = &vecRecPackets[i].SockAddr;
+        vecRecMsgHdrs[i].msg_hdr.msg_namelen = sizeof ( uSockAddr );
+        vecRecMsgHdrs[i].msg_hdr.msg_iov     = &vecRecIoVecs[i];
+        vecRecMsgHdrs[i].msg_hdr.msg_iovlen  = 1;
+        vecRecMsgHdrs[i].msg_hdr.msg_control = vecRecCtrlBufs[i].buf;
+    }
+
+    // let the kernel timestamp the received packets for the jitter statistic
+    const int iEnableTimestamps = 1;
+    setsockopt ( UdpSocket, SOL_SOCKET, SO_TIMESTAMPNS, &iEnableTimestamps, sizeof ( iEnableTimestamps ) );
+
+    bUseRecvMMsg = !bIsClient;
+    bUseSendMMsg = true;
+
+    // the server can send multiple packets to the same client with one GSO
+    // message if the kernel supports it (Linux 4.18)
+    int       iGsoSize    = 0;
+    socklen_t iGsoSizeLen = sizeof ( iGsoSize );
+
+    bUseGso = !bIsClient && ( getsockopt ( UdpSocket, IPPROTO_UDP, UDP_SEGMENT, &iGsoSize, &iGsoSizeLen ) == 0 );
+#endif
 
     // initialize the listening socket
     bool bSuccess;
@@ -223,6 +311,39 @@ void CSocket::Init ( const quint16 iNewPortNumber, const quint16 iNewQosNumber,
                         "the software is already running).",
                         "Network Error" );
     }
+
+    if ( bUseIoUring )
+    {
+        InitIoUring();
+    }
+}
+
+void CSocket::InitIoUring()
+{
+#ifdef HAVE_IO_URING
+    pRecvRing.reset ( new CIoUring );
+
+    if ( pRecvRing->Init ( IO_URING_RECV_NUM_BUFS ) && pRecvRing->InitBufRing ( 0, IO_URING_RECV_NUM_BUFS, IO_URING_RECV_BUF_SIZE ) )
+    {
+        // the multishot receive only uses the address and control lengths of
+        // the message header
+        memset ( &RecvRingMsgHdr, 0, sizeof ( RecvRingMsgHdr ) );
+        RecvRingMsgHdr.msg_namelen    = sizeof ( uSockAddr );
+        RecvRingMsgHdr.msg_controllen = sizeof ( uRecvCtrlBuf );
+
+        bRecvRingArmed = false;
+
+        qInfo() << "using the io_uring network backend";
+        return;
+    }
+
+    pRecvRing.reset();
+    qWarning() << "io_uring is not supported by the kernel, using the socket network backend";
+#else
+    qWarning() << "io_uring is not supported by this build, using the socket network backend";
+#endif
+
+    bUseIoUring = false;
 }
 
 void CSocket::Close()
@@ -251,95 +372,321 @@ CSocket::~CSocket()
 #endif
 }
 
-void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf, const CHostAddress& HostAddr )
+int CSocket::GetSockAddr ( const CHostAddress& HostAddr, uSockAddr& SockAddr ) const
 {
-    int status = 0;
+    memset ( &SockAddr, 0, sizeof ( SockAddr ) );
+
+    if ( HostAddr.InetAddr.protocol() == QAbstractSocket::IPv4Protocol )
+    {
+        if ( bEnableIPv6 )
+        {
+            // Linux and Mac allow to pass an AF_INET address to a dual-stack socket,
+            // but Windows does not. So use a V4MAPPED address in an AF_INET6 sockaddr,
+            // which works on all platforms.
+
+            SockAddr.sa6.sin6_family = AF_INET6;
+            SockAddr.sa6.sin6_port   = htons ( HostAddr.iPort );
+
+            uint32_t* addr = (uint32_t*) &SockAddr.sa6.sin6_addr;
 
+            addr[0] = 0;
+            addr[1] = 0;
+            addr[2] = htonl ( 0xFFFF );
+            addr[3] = htonl ( HostAddr.InetAddr.toIPv4Address() );
+
+            return sizeof ( SockAddr.sa6 );
+        }
+
+        SockAddr.sa4.sin_family      = AF_INET;
+        SockAddr.sa4.sin_port        = htons ( HostAddr.iPort );
+        SockAddr.sa4.sin_addr.s_addr = htonl ( HostAddr.InetAddr.toIPv4Address() );
+
+        return sizeof ( SockAddr.sa4 );
+    }
+
+    if ( bEnableIPv6 )
+    {
+        const Q_IPV6ADDR Addr6 = HostAddr.InetAddr.toIPv6Address();
+
+        SockAddr.sa6.sin6_family = AF_INET6;
+        SockAddr.sa6.sin6_port   = htons ( HostAddr.iPort );
+        memcpy ( &SockAddr.sa6.sin6_addr, Addr6.c, sizeof ( Addr6.c ) );
+
+        return sizeof ( SockAddr.sa6 );
+    }
+
+    // an IPv6 address cannot be used with an IPv4 socket
+    return 0;
+}
+
+void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf, const CHostAddress& HostAddr )
+{
     uSockAddr UdpSocketAddr;
 
-    memset ( &UdpSocketAddr, 0, sizeof ( UdpSocketAddr ) );
+    const int iSockAddrLen = GetSockAddr ( HostAddr, UdpSocketAddr );
+
+    SendPacket ( vecbySendBuf, UdpSocketAddr, iSockAddrLen );
+}
+
+void CSocket::SendPacket ( const CVector<uint8_t>& vecbySendBuf, const uSockAddr& SockAddr, const int iSockAddrLen )
+{
+    int status = 0;
 
     QMutexLocker locker ( &Mutex );
 
     const int iVecSizeOut = vecbySendBuf.Size();
 
-    if ( iVecSizeOut > 0 )
+    // note that the address length is zero if the address cannot be used with this socket
+    if ( ( iVecSizeOut > 0 ) && ( iSockAddrLen > 0 ) )
     {
-        // send packet through network (we have to convert the constant unsigned
-        // char vector in "const char*", for this we first convert the const
-        // uint8_t vector in a read/write uint8_t vector and then do the cast to
-        // const char *)
-
+        // send packet through network
         for ( int tries = 0; tries < 2; tries++ ) // retry loop in case send fails on iOS
         {
-            if ( HostAddr.InetAddr.protocol() == QAbstractSocket::IPv4Protocol )
+            status = sendto ( UdpSocket, (const char*) &vecbySendBuf[0], iVecSizeOut, 0, &SockAddr.sa, iSockAddrLen );
+
+            if ( status >= 0 )
             {
-                if ( bEnableIPv6 )
+                break; // do not retry if success
+            }
+
+#ifdef Q_OS_IOS
+            // qDebug("Socket send exception - mostly happens in iOS when returning from idle");
+            Init ( iPortNumber, iQosNumber, strServerBindIP ); // reinit
+
+            // loop back to retry
+#endif
+        }
+    }
+}
+
+void CSocket::SendBatch ( CSendBatch& SendBatch )
+{
+    int iNumSent = 0;
+
+#ifdef HAVE_IO_URING
+    if ( SendBatch.pSendRing )
+    {
+        // queue one send operation per message and submit them with one system
+        // call (we have to wait for all completions since the batch buffers
+        // are reused afterwards)
+        CIoUring* const       pRing        = SendBatch.pSendRing.get();
+        const bool            bGso         = bUseGso;
+        const int             iNumMsgs     = bGso ? SendBatch.PrepareGsoMsgHdrs() : SendBatch.iNumPackets;
+        struct mmsghdr* const pMsgHdrs     = bGso ? &SendBatch.vecGsoMsgHdrs[0] : &SendBatch.vecMsgHdrs[0];
+        int                   iNumQueued   = 0; // messages handed to the ring
+        int                   iNumInFlight = 0; // handed messages which did not complete yet
+        bool                  bRingFailed  = false;
+
+        for ( ;; )
+        {
+            struct io_uring_cqe* pCqe;
+
+            while ( ( pCqe = pRing->PeekCqe() ) != nullptr )
+            {
+                const int iMsg = static_cast<int> ( pCqe->user_data );
+
+                if ( bGso && ( pCqe->res < 0 ) && IsGsoUnsupportedError ( -pCqe->res ) &&
+                     ( SendBatch.vecGsoFirstPacket[iMsg + 1] - SendBatch.vecGsoFirstPacket[iMsg] > 1 ) )
                 {
-                    // Linux and Mac allow to pass an AF_INET address to a dual-stack socket,
-                    // but Windows does not. So use a V4MAPPED address in an AF_INET6 sockaddr,
-                    // which works on all platforms.
-
-                    UdpSocketAddr.sa6.sin6_family = AF_INET6;
-                    UdpSocketAddr.sa6.sin6_port   = htons ( HostAddr.iPort );
-
-                    uint32_t* addr = (uint32_t*) &UdpSocketAddr.sa6.sin6_addr;
-
-                    addr[0] = 0;
-                    addr[1] = 0;
-                    addr[2] = htonl ( 0xFFFF );
-                    addr[3] = htonl ( HostAddr.InetAddr.toIPv4Address() );
-
-                    status = sendto ( UdpSocket,
-                                      (const char*) &( (CVector<uint8_t>) vecbySendBuf )[0],
-                                      iVecSizeOut,
-                                      0,
-                                      &UdpSocketAddr.sa,
-                                      sizeof ( UdpSocketAddr.sa6 ) );
+                    // the GSO message was rejected by the network device, send
+                    // its packets one by one
+                    if ( bUseGso.exchange ( false ) )
+                    {
+                        qWarning() << "UDP GSO is not supported, sending single packets";
+                    }
+
+                    SendBatchPackets ( SendBatch, SendBatch.vecGsoFirstPacket[iMsg], SendBatch.vecGsoFirstPacket[iMsg + 1] );
                 }
-                else
+
+                // other failed sends are dropped (like with sendto)
+                pRing->SeenCqe();
+                iNumInFlight--;
+            }
+
+            if ( ( iNumInFlight == 0 ) && ( bRingFailed || ( iNumQueued == iNumMsgs ) ) )
+            {
+                break;
+            }
+
+            if ( !bRingFailed )
+            {
+                // queue as many send operations as the submission queue can
+                // take, the remaining ones are queued after the next submission
+                struct io_uring_sqe* pSqe;
+
+                while ( ( iNumQueued < iNumMsgs ) && ( ( pSqe = pRing->GetSqe() ) != nullptr ) )
                 {
-                    UdpSocketAddr.sa4.sin_family      = AF_INET;
-                    UdpSocketAddr.sa4.sin_port        = htons ( HostAddr.iPort );
-                    UdpSocketAddr.sa4.sin_addr.s_addr = htonl ( HostAddr.InetAddr.toIPv4Address() );
-
-                    status = sendto ( UdpSocket,
-                                      (const char*) &( (CVector<uint8_t>) vecbySendBuf )[0],
-                                      iVecSizeOut,
-                                      0,
-                                      &UdpSocketAddr.sa,
-                                      sizeof ( UdpSocketAddr.sa4 ) );
+                    pSqe->opcode    = IORING_OP_SENDMSG;
+                    pSqe->fd        = UdpSocket;
+                    pSqe->addr      = reinterpret_cast<uint64_t> ( &pMsgHdrs[iNumQueued].msg_hdr );
+                    pSqe->len       = 1;
+                    pSqe->user_data = static_cast<uint64_t> ( iNumQueued );
+
+                    iNumQueued++;
+                    iNumInFlight++;
                 }
             }
-            else if ( bEnableIPv6 )
+
+            if ( pRing->SubmitAndWait ( static_cast<unsigned> ( iNumInFlight ) ) < 0 )
             {
-                UdpSocketAddr.sa6.sin6_family = AF_INET6;
-                UdpSocketAddr.sa6.sin6_port   = htons ( HostAddr.iPort );
-                inet_pton ( AF_INET6, HostAddr.InetAddr.toString().toLocal8Bit().constData(), &UdpSocketAddr.sa6.sin6_addr );
-
-                status = sendto ( UdpSocket,
-                                  (const char*) &( (CVector<uint8_t>) vecbySendBuf )[0],
-                                  iVecSizeOut,
-                                  0,
-                                  &UdpSocketAddr.sa,
-                                  sizeof ( UdpSocketAddr.sa6 ) );
+                if ( bRingFailed )
+                {
+                    // the outstanding completions cannot be reaped, give up
+                    break;
+                }
+
+                // the entries which were not consumed by the kernel must not
+                // stay in the queue (they would be submitted with the next
+                // batch), the submitted ones are still reaped above
+                const int iNumDiscarded = static_cast<int> ( pRing->DiscardSqes() );
+
+                iNumQueued -= iNumDiscarded;
+                iNumInFlight -= iNumDiscarded;
+                bRingFailed = true;
             }
+        }
 
-            if ( status >= 0 )
+        if ( !bRingFailed )
+        {
+            return;
+        }
+
+        // send the messages which were not submitted with sendmmsg from now on
+        qWarning() << "io_uring send failed, using sendmmsg";
+        SendBatch.pSendRing.reset();
+        iNumSent = bGso ? SendBatch.vecGsoFirstPacket[iNumQueued] : iNumQueued;
+    }
+#endif
+
+#ifdef __linux__
+    if ( bUseGso && bUseSendMMsg && ( iNumSent == 0 ) )
+    {
+        const int iNumMsgs = SendBatch.PrepareGsoMsgHdrs();
+
+        // only use the GSO messages if at least two packets could be combined
+        if ( iNumMsgs < SendBatch.iNumPackets )
+        {
+            int iNumMsgsSent = 0;
+
+            while ( iNumMsgsSent < iNumMsgs )
             {
-                break; // do not retry if success
+                const int iRet = sendmmsg ( UdpSocket, &SendBatch.vecGsoMsgHdrs[iNumMsgsSent], iNumMsgs - iNumMsgsSent, 0 );
+
+                if ( iRet > 0 )
+                {
+                    iNumMsgsSent += iRet;
+                }
+                else if ( errno == ENOSYS )
+                {
+                    // handled by the sendmmsg fallback below
+                    break;
+                }
+                else if ( IsGsoUnsupportedError ( errno ) &&
+                          ( SendBatch.vecGsoFirstPacket[iNumMsgsSent + 1] - SendBatch.vecGsoFirstPacket[iNumMsgsSent] > 1 ) )
+                {
+                    // the GSO message was rejected by the network device, send
+                    // the remaining packets without GSO
+                    qWarning() << "UDP GSO is not supported, sending single packets";
+                    bUseGso = false;
+                    break;
+                }
+                else
+                {
+                    // the packets of the message which could not be sent are
+                    // dropped (like with sendto)
+                    iNumMsgsSent++;
+                }
             }
 
-#ifdef Q_OS_IOS
-            // qDebug("Socket send exception - mostly happens in iOS when returning from idle");
-            Init ( iPortNumber, iQosNumber, strServerBindIP ); // reinit
+            iNumSent = SendBatch.vecGsoFirstPacket[iNumMsgsSent];
+        }
+    }
 
-            // loop back to retry
+    if ( bUseSendMMsg )
+    {
+        while ( iNumSent < SendBatch.iNumPackets )
+        {
+            const int iRet = sendmmsg ( UdpSocket, &SendBatch.vecMsgHdrs[iNumSent], SendBatch.iNumPackets - iNumSent, 0 );
+
+            if ( iRet > 0 )
+            {
+                iNumSent += iRet;
+            }
+            else if ( errno == ENOSYS )
+            {
+                // the kernel does not support sendmmsg, use sendto from now on
+                qWarning() << "sendmmsg is not supported, using single packet send";
+                bUseSendMMsg = false;
+                break;
+            }
+            else
+            {
+                // the packet which could not be sent is dropped (like with sendto)
+                iNumSent++;
+            }
+        }
+    }
 #endif
+
+    // send the remaining packets one by one
+    SendBatchPackets ( SendBatch, iNumSent, SendBatch.iNumPackets );
+}
+
+void CSocket::SendBatchPackets ( CSendBatch& SendBatch, const int iFirstPacket, const int iEndPacket )
+{
+    if ( iFirstPacket < iEndPacket )
+    {
+        QMutexLocker locker ( &Mutex );
+
+        for ( int i = iFirstPacket; i < iEndPacket; i++ )
+        {
+            sendto ( UdpSocket,
+                     (const char*) &SendBatch.vecbyData[SendBatch.veciOffset[i]],
+                     SendBatch.veciSize[i],
+                     0,
+                     &SendBatch.vecSockAddr[i].sa,
+                     SendBatch.veciSockAddrLen[i] );
         }
     }
 }
 
+void CSocket::ProcessProtocolPackets()
+{
+    CProtPacketSlot* pSlot;
+
+    // the flag is reset before the queue is read so that a message which is
+    // pushed while we are reading it wakes us up again
+    bProtPacketsPosted = false;
+
+    while ( ( pSlot = ProtPacketQueue.Pop() ) != nullptr )
+    {
+        if ( bIsClient )
+        {
+            if ( pSlot->bIsConnectionLess )
+            {
+                pChannel->OnProtocolCLMessageReceived ( pSlot->iRecID, pSlot->vecbyMesBodyData, pSlot->HostAddr );
+            }
+            else
+            {
+                pChannel->OnProtocolMessageReceived ( pSlot->iRecCounter, pSlot->iRecID, pSlot->vecbyMesBodyData, pSlot->HostAddr );
+            }
+        }
+        else
+        {
+            if ( pSlot->bIsConnectionLess )
+            {
+                pServer->OnProtocolCLMessageReceived ( pSlot->iRecID, pSlot->vecbyMesBodyData, pSlot->HostAddr );
+            }
+            else
+            {
+                pServer->OnProtocolMessageReceived ( pSlot->iRecCounter, pSlot->iRecID, pSlot->vecbyMesBodyData, pSlot->HostAddr );
+            }
+        }
+
+        ProtPacketQueue.Release ( pSlot );
+    }
+}
+
 bool CSocket::GetAndResetbJitterBufferOKFlag()
 {
     // check jitter buffer status
@@ -355,118 +702,552 @@ bool CSocket::GetAndResetbJitterBufferOKFlag()
     return true;
 }
 
-void CSocket::OnDataReceived()
+void CProtPacketQueue::Init ( const int iNumSlots )
 {
-    /*
-        The strategy of this function is that only the "put audio" function is
-        called directly (i.e. the high thread priority is used) and all other less
-        important things like protocol parsing and acting on protocol messages is
-        done in the low priority thread. To get a thread transition, we have to
-        use the signal/slot mechanism (i.e. we use messages for that).
-    */
+    pSlots.reset ( new CProtPacketSlot[iNumSlots] );
+    FreeSlots.Init ( iNumSlots );
+    FilledSlots.Init ( iNumSlots );
 
-    // read block from network interface and query address of sender
-    uSockAddr UdpSocketAddr;
-#ifdef _WIN32
-    int SenderAddrSize = sizeof ( UdpSocketAddr );
-#else
-    socklen_t SenderAddrSize = sizeof ( UdpSocketAddr );
+    for ( int i = 0; i < iNumSlots; i++ )
+    {
+        // reserve the memory so that copying a message into the slot does not
+        // allocate (Init() keeps the capacity of the vector)
+        pSlots[i].vecbyMesBodyData.reserve ( PROT_PACKET_SLOT_SIZE_BYTES );
+
+        FreeSlots.Push ( &pSlots[i] );
+    }
+}
+
+CProtPacketSlot* CProtPacketQueue::GetFreeSlot()
+{
+    CProtPacketSlot* pSlot;
+
+    return FreeSlots.Pop ( pSlot ) ? pSlot : nullptr;
+}
+
+CProtPacketSlot* CProtPacketQueue::Pop()
+{
+    CProtPacketSlot* pSlot;
+
+    return FilledSlots.Pop ( pSlot ) ? pSlot : nullptr;
+}
+
+void CSendBatch::Init ( CSocket* pNSocket )
+{
+    pSocket     = pNSocket;
+    iNumPackets = 0;
+    iNumBytes   = 0;
+
+    vecbyData.Init ( SEND_BATCH_SIZE_BYTES );
+    veciOffset.Init ( NUM_SEND_BATCH_PACKETS );
+    veciSize.Init ( NUM_SEND_BATCH_PACKETS );
+    vecSockAddr.Init ( NUM_SEND_BATCH_PACKETS );
+    veciSockAddrLen.Init ( NUM_SEND_BATCH_PACKETS );
+
+#ifdef HAVE_IO_URING
+    // the packets of the batch are sent through a ring of the batch
+    pSendRing.reset();
+
+    if ( pSocket->IsIoUringEnabled() )
+    {
+        pSendRing.reset ( new CIoUring );
+
+        if ( !pSendRing->Init ( NUM_SEND_BATCH_PACKETS ) )
+        {
+            pSendRing.reset();
+        }
+    }
 #endif
 
-    const long iNumBytesRead = recvfrom ( UdpSocket, (char*) &vecbyRecBuf[0], MAX_SIZE_BYTES_NETW_BUF, 0, &UdpSocketAddr.sa, &SenderAddrSize );
+#ifdef __linux__
+    // the message headers point to the addresses and the I/O vectors of the slots
+    vecMsgHdrs.resize ( NUM_SEND_BATCH_PACKETS );
+    vecIoVecs.resize ( NUM_SEND_BATCH_PACKETS );
 
-    // check if an error occurred or no data could be read
-    if ( iNumBytesRead <= 0 )
+    for ( int i = 0; i < NUM_SEND_BATCH_PACKETS; i++ )
+    {
+        memset ( &vecMsgHdrs[i], 0, sizeof ( struct mmsghdr ) );
+        vecMsgHdrs[i].msg_hdr.msg_name   = &vecSockAddr[i];
+        vecMsgHdrs[i].msg_hdr.msg_iov    = &vecIoVecs[i];
+        vecMsgHdrs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // the GSO message headers are set up for each send since the runs of
+    // packets are only known when the batch is complete
+    vecGsoMsgHdrs.resize ( NUM_SEND_BATCH_PACKETS );
+    vecGsoIoVecs.resize ( NUM_SEND_BATCH_PACKETS );
+    vecGsoCtrlBufs.resize ( NUM_SEND_BATCH_PACKETS );
+    vecGsoFirstPacket.resize ( NUM_SEND_BATCH_PACKETS + 1 );
+
+    for ( int i = 0; i < NUM_SEND_BATCH_PACKETS; i++ )
+    {
+        memset ( &vecGsoMsgHdrs[i], 0, sizeof ( struct mmsghdr ) );
+        vecGsoMsgHdrs[i].msg_hdr.msg_iov    = &vecGsoIoVecs[i];
+        vecGsoMsgHdrs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+}
+
+#ifdef __linux__
+int CSendBatch::PrepareGsoMsgHdrs()
+{
+    int iNumMsgs = 0;
+    int iPacket  = 0;
+
+    while ( iPacket < iNumPackets )
+    {
+        const int iSize       = veciSize[iPacket];
+        const int iAddrLen    = veciSockAddrLen[iPacket];
+        int       iEndPacket  = iPacket + 1;
+        int       iTotalBytes = iSize;
+
+        // the packets of the batch are stored contiguously, so a run of packets
+        // with the same size and destination is one block of the batch buffer
+        while ( ( iEndPacket < iNumPackets ) && ( veciSize[iEndPacket] == iSize ) && ( veciSockAddrLen[iEndPacket] == iAddrLen ) &&
+                ( veciOffset[iEndPacket] == veciOffset[iPacket] + iTotalBytes ) && ( iTotalBytes + iSize <= UDP_GSO_MAX_SIZE_BYTES ) &&
+                ( memcmp ( &vecSockAddr[iEndPacket], &vecSockAddr[iPacket], iAddrLen ) == 0 ) )
+        {
+            iTotalBytes += iSize;
+            iEndPacket++;
+        }
+
+        struct msghdr& MsgHdr = vecGsoMsgHdrs[iNumMsgs].msg_hdr;
+
+        MsgHdr.msg_name                 = &vecSockAddr[iPacket];
+        MsgHdr.msg_namelen              = iAddrLen;
+        vecGsoIoVecs[iNumMsgs].iov_base = &vecbyData[veciOffset[iPacket]];
+        vecGsoIoVecs[iNumMsgs].iov_len  = iTotalBytes;
+
+        if ( iEndPacket - iPacket > 1 )
+        {
+            // the kernel splits the message in packets of the segment size
+            MsgHdr.msg_control    = vecGsoCtrlBufs[iNumMsgs].buf;
+            MsgHdr.msg_controllen = sizeof ( uGsoCtrlBuf );
+
+            struct cmsghdr* pCmsg        = CMSG_FIRSTHDR ( &MsgHdr );
+            const uint16_t  iSegmentSize = static_cast<uint16_t> ( iSize );
+
+            pCmsg->cmsg_level = IPPROTO_UDP;
+            pCmsg->cmsg_type  = UDP_SEGMENT;
+            pCmsg->cmsg_len   = CMSG_LEN ( sizeof ( uint16_t ) );
+            memcpy ( CMSG_DATA ( pCmsg ), &iSegmentSize, sizeof ( uint16_t ) );
+        }
+        else
+        {
+            MsgHdr.msg_control    = nullptr;
+            MsgHdr.msg_controllen = 0;
+        }
+
+        vecGsoFirstPacket[iNumMsgs] = iPacket;
+        iNumMsgs++;
+
+        iPacket = iEndPacket;
+    }
+
+    // the end of the last message
+    vecGsoFirstPacket[iNumMsgs] = iNumPackets;
+
+    return iNumMsgs;
+}
+#endif
+
+void CSendBatch::Add ( const CVector<uint8_t>& vecbySendBuf, const uSockAddr& SockAddr, const int iSockAddrLen )
+{
+    const int iSize = vecbySendBuf.Size();
+
+    if ( ( iSize <= 0 ) || ( iSockAddrLen <= 0 ) )
     {
         return;
     }
 
-    if ( UdpSocketAddr.sa.sa_family == AF_INET6 )
+    // a packet which does not fit in the batch buffer is sent directly
+    if ( iSize > SEND_BATCH_SIZE_BYTES )
     {
-        if ( IN6_IS_ADDR_V4MAPPED ( &( UdpSocketAddr.sa6.sin6_addr ) ) )
+        pSocket->SendPacket ( vecbySendBuf, SockAddr, iSockAddrLen );
+        return;
+    }
+
+    if ( ( iNumPackets == NUM_SEND_BATCH_PACKETS ) || ( iNumBytes + iSize > SEND_BATCH_SIZE_BYTES ) )
+    {
+        Flush();
+    }
+
+    memcpy ( &vecSockAddr[iNumPackets], &SockAddr, iSockAddrLen );
+    memcpy ( &vecbyData[iNumBytes], &vecbySendBuf[0], iSize );
+
+    veciOffset[iNumPackets]      = iNumBytes;
+    veciSize[iNumPackets]        = iSize;
+    veciSockAddrLen[iNumPackets] = iSockAddrLen;
+
+#ifdef __linux__
+    vecIoVecs[iNumPackets].iov_base             = &vecbyData[iNumBytes];
+    vecIoVecs[iNumPackets].iov_len              = iSize;
+    vecMsgHdrs[iNumPackets].msg_hdr.msg_namelen = iSockAddrLen;
+#endif
+
+    iNumBytes += iSize;
+    iNumPackets++;
+}
+
+void CSendBatch::Flush()
+{
+    if ( iNumPackets > 0 )
+    {
+        pSocket->SendBatch ( *this );
+
+        iNumPackets = 0;
+        iNumBytes   = 0;
+    }
+}
+
+void CSocket::GetHostAddr ( const uSockAddr& SockAddr, CHostAddress& HostAddr )
+{
+    if ( SockAddr.sa.sa_family == AF_INET6 )
+    {
+        if ( IN6_IS_ADDR_V4MAPPED ( &( SockAddr.sa6.sin6_addr ) ) )
         {
-            const uint32_t addr = ( (const uint32_t*) ( &( UdpSocketAddr.sa6.sin6_addr ) ) )[3];
-            RecHostAddr.InetAddr.setAddress ( ntohl ( addr ) );
+            const uint32_t addr = ( (const uint32_t*) ( &( SockAddr.sa6.sin6_addr ) ) )[3];
+            HostAddr.InetAddr.setAddress ( ntohl ( addr ) );
         }
         else
         {
-            RecHostAddr.InetAddr.setAddress ( UdpSocketAddr.sa6.sin6_addr.s6_addr );
+            HostAddr.InetAddr.setAddress ( SockAddr.sa6.sin6_addr.s6_addr );
         }
-        RecHostAddr.iPort = ntohs ( UdpSocketAddr.sa6.sin6_port );
+        HostAddr.iPort = ntohs ( SockAddr.sa6.sin6_port );
     }
     else
     {
         // convert address of client
-        RecHostAddr.InetAddr.setAddress ( ntohl ( UdpSocketAddr.sa4.sin_addr.s_addr ) );
-        RecHostAddr.iPort = ntohs ( UdpSocketAddr.sa4.sin_port );
+        HostAddr.InetAddr.setAddress ( ntohl ( SockAddr.sa4.sin_addr.s_addr ) );
+        HostAddr.iPort = ntohs ( SockAddr.sa4.sin_port );
     }
+}
 
-    // check if this is a protocol message
-    int              iRecCounter;
-    int              iRecID;
-    CVector<uint8_t> vecbyMesBodyData;
+int CSocket::ReceiveBatchIoUring()
+{
+#ifdef HAVE_IO_URING
+    if ( !bRecvRingArmed )
+    {
+        // start a multishot receive which produces a completion for each
+        // received packet until it is terminated (e.g. if no buffer is left)
+        struct io_uring_sqe* pSqe = pRecvRing->GetSqe();
 
-    if ( !CProtocol::ParseMessageFrame ( vecbyRecBuf, iNumBytesRead, vecbyMesBodyData, iRecCounter, iRecID ) )
+        if ( pSqe != nullptr )
+        {
+            pSqe->opcode    = IORING_OP_RECVMSG;
+            pSqe->fd        = UdpSocket;
+            pSqe->addr      = reinterpret_cast<uint64_t> ( &RecvRingMsgHdr );
+            pSqe->len       = 1;
+            pSqe->ioprio    = IORING_RECV_MULTISHOT;
+            pSqe->flags     = IOSQE_BUFFER_SELECT;
+            pSqe->buf_group = pRecvRing->GetBufGroupID();
+
+            bRecvRingArmed = true;
+        }
+    }
+
+    // wait for the first packet (with a timeout so that the receive thread can
+    // check if it shall be stopped)
+    pRecvRing->SubmitAndWait ( 1, IO_URING_RECV_TIMEOUT_MS );
+
+    const int            iBatchSize  = vecRecPackets.Size();
+    int                  iNumPackets = 0;
+    struct io_uring_cqe* pCqe;
+
+    while ( ( iNumPackets < iBatchSize ) && ( ( pCqe = pRecvRing->PeekCqe() ) != nullptr ) )
     {
-        // this is a protocol message, check the type of the message
-        if ( CProtocol::IsConnectionLessMessageID ( iRecID ) )
+        if ( ( pCqe->flags & IORING_CQE_F_MORE ) == 0 )
         {
+            // the multishot receive was terminated, restart it with the next call
+            bRecvRingArmed = false;
+        }
 
-            // clang-format off
-// TODO a copy of the vector is used -> avoid malloc in real-time routine
-            // clang-format on
+        if ( pCqe->res == -EINVAL )
+        {
+            // the kernel does not support the multishot receive (kernel 6.0)
+            pRecvRing->SeenCqe();
+            pRecvRing.reset();
 
-            emit ProtocolCLMessageReceived ( iRecID, vecbyMesBodyData, RecHostAddr );
+            qWarning() << "io_uring multishot receive is not supported, using the socket network backend for receiving";
+            return iNumPackets;
         }
-        else
+
+        if ( ( pCqe->res >= 0 ) && ( pCqe->flags & IORING_CQE_F_BUFFER ) )
         {
+            // the buffer contains the receive header, the sender address and the payload
+            const uint16_t                     iBufID   = static_cast<uint16_t> ( pCqe->flags >> IORING_CQE_BUFFER_SHIFT );
+            const uint8_t*                     pBuf     = pRecvRing->GetBuf ( iBufID );
+            const struct io_uring_recvmsg_out* pOut     = reinterpret_cast<const struct io_uring_recvmsg_out*> ( pBuf );
+            const uint8_t*                     pName    = pBuf + sizeof ( struct io_uring_recvmsg_out );
+            const uint8_t*                     pPayload = pName + RecvRingMsgHdr.msg_namelen + RecvRingMsgHdr.msg_controllen;
+
+            // drop truncated packets
+            if ( ( ( pOut->flags & MSG_TRUNC ) == 0 ) && ( pOut->payloadlen <= MAX_SIZE_BYTES_NETW_BUF ) )
+            {
+                CRecvPacket& Packet = vecRecPackets[iNumPackets];
+
+                // the control messages follow the address
+                struct msghdr CtrlMsgHdr;
+                memset ( &CtrlMsgHdr, 0, sizeof ( CtrlMsgHdr ) );
+                CtrlMsgHdr.msg_control    = const_cast<uint8_t*> ( pName + RecvRingMsgHdr.msg_namelen );
+                CtrlMsgHdr.msg_controllen = pOut->controllen;
 
-            // clang-format off
-// TODO a copy of the vector is used -> avoid malloc in real-time routine
-            // clang-format on
+                memcpy ( &Packet.SockAddr, pName, std::min<size_t> ( pOut->namelen, sizeof ( uSockAddr ) ) );
+                memcpy ( &Packet.vecbyData[0], pPayload, pOut->payloadlen );
+                Packet.iNumBytes      = static_cast<int> ( pOut->payloadlen );
+                Packet.iArrivalTimeNs = GetRecvTimestampNs ( CtrlMsgHdr );
 
-            emit ProtocolMessageReceived ( iRecCounter, iRecID, vecbyMesBodyData, RecHostAddr );
+                iNumPackets++;
+            }
+
+            pRecvRing->RecycleBuf ( iBufID );
         }
+
+        pRecvRing->SeenCqe();
     }
-    else
+
+    return iNumPackets;
+#else
+    return 0;
+#endif
+}
+
+int CSocket::ReceiveBatch()
+{
+#ifdef HAVE_IO_URING
+    if ( pRecvRing )
     {
-        // this is most probably a regular audio packet
-        if ( bIsClient )
+        return ReceiveBatchIoUring();
+    }
+#endif
+
+#ifdef __linux__
+    if ( bUseRecvMMsg )
+    {
+        const int iBatchSize = static_cast<int> ( vecRecMsgHdrs.size() );
+
+        for ( int i = 0; i < iBatchSize; i++ )
         {
-            // client:
+            // the address and control lengths are overwritten by the kernel
+            vecRecMsgHdrs[i].msg_hdr.msg_namelen    = sizeof ( uSockAddr );
+            vecRecMsgHdrs[i].msg_hdr.msg_controllen = sizeof ( uRecvCtrlBuf );
+        }
+
+        // block until the first packet arrives and then take all packets which
+        // are already queued in the socket without blocking
+        const int iNumPackets = recvmmsg ( UdpSocket, &vecRecMsgHdrs[0], iBatchSize, MSG_WAITFORONE, nullptr );
 
-            switch ( pChannel->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr ) )
+        if ( iNumPackets >= 0 )
+        {
+            for ( int i = 0; i < iNumPackets; i++ )
             {
-            case PS_AUDIO_ERR:
-            case PS_GEN_ERROR:
-                bJitterBufferOK = false;
-                break;
+                vecRecPackets[i].iNumBytes      = static_cast<int> ( vecRecMsgHdrs[i].msg_len );
+                vecRecPackets[i].iArrivalTimeNs = GetRecvTimestampNs ( vecRecMsgHdrs[i].msg_hdr );
+            }
 
-            case PS_NEW_CONNECTION:
-                // inform other objects that new connection was established
-                emit NewConnection();
-                break;
+            return iNumPackets;
+        }
 
-            case PS_AUDIO_INVALID:
-                // inform about received invalid packet by fireing an event
-                emit InvalidPacketReceived ( RecHostAddr );
-                break;
+        if ( errno != ENOSYS )
+        {
+            return 0;
+        }
 
-            default:
-                // do nothing
-                break;
+        // the kernel does not support recvmmsg, use recvmsg from now on
+        qWarning() << "recvmmsg is not supported, using single packet receive";
+        bUseRecvMMsg = false;
+    }
+
+    // read a single packet with the receive timestamp
+    struct msghdr& MsgHdr = vecRecMsgHdrs[0].msg_hdr;
+
+    MsgHdr.msg_namelen    = sizeof ( uSockAddr );
+    MsgHdr.msg_controllen = sizeof ( uRecvCtrlBuf );
+
+    const long iNumBytesReceived = recvmsg ( UdpSocket, &MsgHdr, 0 );
+
+    if ( iNumBytesReceived <= 0 )
+    {
+        return 0;
+    }
+
+    vecRecPackets[0].iNumBytes      = static_cast<int> ( iNumBytesReceived );
+    vecRecPackets[0].iArrivalTimeNs = GetRecvTimestampNs ( MsgHdr );
+
+    return 1;
+#else
+    // read block from network interface and query address of sender
+    CRecvPacket& Packet = vecRecPackets[0];
+#ifdef _WIN32
+    int SenderAddrSize = sizeof ( Packet.SockAddr );
+#else
+    socklen_t SenderAddrSize = sizeof ( Packet.SockAddr );
+#endif
+
+    const long iNumBytesRead =
+        recvfrom ( UdpSocket, (char*) &Packet.vecbyData[0], MAX_SIZE_BYTES_NETW_BUF, 0, &Packet.SockAddr.sa, &SenderAddrSize );
+
+    // check if an error occurred or no data could be read
+    if ( iNumBytesRead <= 0 )
+    {
+        return 0;
+    }
+
+    Packet.iNumBytes      = static_cast<int> ( iNumBytesRead );
+    Packet.iArrivalTimeNs = GetArrivalTimeNs();
+
+    return 1;
+#endif
+}
+
+int64_t CSocket::GetArrivalTimeNs()
+{
+    // the kernel timestamps use the system clock
+    return std::chrono::duration_cast<std::chrono::nanoseconds> ( std::chrono::system_clock::now().time_since_epoch() ).count();
+}
+
+#ifdef __linux__
+int64_t CSocket::GetRecvTimestampNs ( const struct msghdr& MsgHdr )
+{
+    for ( struct cmsghdr* pCmsg = CMSG_FIRSTHDR ( &MsgHdr ); pCmsg != nullptr; pCmsg = CMSG_NXTHDR ( const_cast<struct msghdr*> ( &MsgHdr ), pCmsg ) )
+    {
+        if ( ( pCmsg->cmsg_level == SOL_SOCKET ) && ( pCmsg->cmsg_type == SCM_TIMESTAMPNS ) )
+        {
+            struct timespec Timestamp;
+            memcpy ( &Timestamp, CMSG_DATA ( pCmsg ), sizeof ( Timestamp ) );
+
+            return static_cast<int64_t> ( Timestamp.tv_sec ) * 1000000000 + Timestamp.tv_nsec;
+        }
+    }
+
+    // no kernel timestamp available, use the current time instead
+    return GetArrivalTimeNs();
+}
+#endif
+
+void CSocket::OnDataReceived()
+{
+    /*
+        The strategy of this function is that only the "put audio" function is
+        called directly (i.e. the high thread priority is used) and all other less
+        important things like protocol parsing and acting on protocol messages is
+        done in the low priority thread. The protocol messages are handed over
+        through the lock-free protocol packet queue, the low priority thread is
+        woken up with a signal if it has drained the queue before.
+    */
+
+    const int iNumPackets = ReceiveBatch();
+    bool      bHasAudio   = false;
+
+    for ( int i = 0; i < iNumPackets; i++ )
+    {
+        CRecvPacket& Packet = vecRecPackets[i];
+
+        Packet.bIsAudio = false;
+
+        // ignore empty packets
+        if ( Packet.iNumBytes <= 0 )
+        {
+            continue;
+        }
+
+        // check if this is a protocol message (the message body vector is
+        // preallocated so that parsing does not allocate memory)
+        int iRecCounter;
+        int iRecID;
+
+        const bool bIsAudio = CProtocol::ParseMessageFrame ( Packet.vecbyData, Packet.iNumBytes, vecbyRecMesBodyData, iRecCounter, iRecID );
+
+        // the server looks up the channel of an audio packet directly with the
+        // native address, otherwise convert the address of the sender
+        if ( bIsClient || !bIsAudio )
+        {
+            GetHostAddr ( Packet.SockAddr, Packet.HostAddr );
+        }
+
+        if ( !bIsAudio )
+        {
+            // this is a protocol message, hand it to the protocol thread (if no
+            // slot is free, the message is dropped and counted)
+            CProtPacketSlot* pSlot = ProtPacketQueue.GetFreeSlot();
+
+            if ( pSlot != nullptr )
+            {
+                pSlot->vecbyMesBodyData  = vecbyRecMesBodyData; // does not allocate if the slot is large enough
+                pSlot->HostAddr          = Packet.HostAddr;
+                pSlot->iRecCounter       = iRecCounter;
+                pSlot->iRecID            = iRecID;
+                pSlot->bIsConnectionLess = CProtocol::IsConnectionLessMessageID ( iRecID );
+
+                ProtPacketQueue.Push ( pSlot );
+
+                if ( !bProtPacketsPosted.exchange ( true ) )
+                {
+                    emit ProtocolPacketsQueued();
+                }
+            }
+            else
+            {
+                ProtPacketQueue.CountDropped();
             }
         }
         else
         {
-            // server:
+            // this is most probably a regular audio packet
+            if ( bIsClient )
+            {
+                // client:
+
+                switch ( pChannel->PutAudioData ( Packet.vecbyData, Packet.iNumBytes, Packet.HostAddr, Packet.iArrivalTimeNs ) )
+                {
+                case PS_AUDIO_ERR:
+                case PS_GEN_ERROR:
+                    bJitterBufferOK = false;
+                    break;
+
+                case PS_NEW_CONNECTION:
+                    // inform other objects that new connection was established
+                    emit NewConnection();
+                    break;
+
+                case PS_AUDIO_INVALID:
+                    // inform about received invalid packet by fireing an event
+                    emit InvalidPacketReceived ( Packet.HostAddr );
+                    break;
+
+                default:
+                    // do nothing
+                    break;
+                }
+            }
+            else
+            {
+                // server: the audio packets of the batch are put together
+                Packet.bIsAudio = true;
+                bHasAudio       = true;
+            }
+        }
+    }
+
+    if ( bHasAudio )
+    {
+        // server:
+
+        pServer->PutAudioData ( vecRecPackets, iNumPackets );
+
+        for ( int i = 0; i < iNumPackets; i++ )
+        {
+            const CRecvPacket& Packet = vecRecPackets[i];
 
-            int iCurChanID;
+            if ( !Packet.bIsAudio )
+            {
+                continue;
+            }
 
-            if ( pServer->PutAudioData ( vecbyRecBuf, iNumBytesRead, RecHostAddr, iCurChanID ) )
+            if ( Packet.bNewConnection )
             {
                 // we have a new connection, emit a signal
-                emit NewConnection ( iCurChanID, pServer->GetNumberOfConnectedClients(), RecHostAddr );
+                emit NewConnection ( Packet.iChanID, pServer->GetNumberOfConnectedClients(), Packet.HostAddr );
 
                 // this was an audio packet, start server if it is in sleep mode
                 if ( !pServer->IsRunning() )
@@ -477,10 +1258,10 @@ void CSocket::OnDataReceived()
             }
 
             // check if no channel is available
-            if ( iCurChanID == INVALID_CHANNEL_ID )
+            if ( Packet.iChanID == INVALID_CHANNEL_ID )
             {
                 // fire message for the state that no free channel is available
-                emit ServerFull ( RecHostAddr );
+                emit ServerFull ( Packet.HostAddr );
             }
         }
     }
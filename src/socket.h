@@ -28,25 +28,196 @@
 #include <QThread>
 #include <QMutex>
 #include <vector>
+#include <atomic>
+#include <memory>
 #include "global.h"
 #include "protocol.h"
 #include "util.h"
+#include "iouring.h"
+#include "lockfreequeue.h"
 #ifndef _WIN32
 #    include <netinet/in.h>
 #    include <sys/socket.h>
 #endif
+#ifdef __linux__
+#    include <sys/uio.h>
+#endif
 
 // The header files channel.h and server.h require to include this header file
 // so we get a cyclic dependency. To solve this issue, a prototype of the
 // channel class and server class is defined here.
 class CServer;  // forward declaration of CServer
 class CChannel; // forward declaration of CChannel
+class CSocket;  // forward declaration of CSocket (used by CSendBatch)
 
 /* Definitions ****************************************************************/
 // number of ports we try to bind until we give up
 #define NUM_SOCKET_PORTS_TO_TRY 100
 
+// maximum number of packets the server reads from the socket with one system
+// call (the client only receives one audio stream and reads single packets)
+#define NUM_RECV_BATCH_PACKETS 16
+
+// maximum number of server sockets on the same port with their own receive thread
+#define MAX_NUM_RECV_THREADS 16
+
+// io_uring backend: number and size of the provided receive buffers (larger
+// packets are dropped) and the receive wait timeout which allows to stop the
+// receive thread
+#define IO_URING_RECV_NUM_BUFS   128
+#define IO_URING_RECV_BUF_SIZE   8192
+#define IO_URING_RECV_TIMEOUT_MS 100
+
+// maximum number of packets and bytes which are collected in a send batch
+// before it is sent with one system call
+#define NUM_SEND_BATCH_PACKETS 64
+#define SEND_BATCH_SIZE_BYTES  65536
+
+// maximum payload of a UDP GSO message which is split in equally sized packets
+// by the kernel (the maximum number of packets is 64 which is not exceeded
+// since it is the maximum number of packets in a send batch)
+#define UDP_GSO_MAX_SIZE_BYTES 65507
+
+// number of preallocated slots for the protocol messages which are handed from
+// the socket thread to the protocol thread and the initial size of a slot
+// (a slot is enlarged once if a larger message is received)
+#define NUM_PROT_PACKET_SLOTS       128
+#define PROT_PACKET_SLOT_SIZE_BYTES 2048
+
+// overlay generic, IPv4 and IPv6 sockaddr structures
+typedef union
+{
+    struct sockaddr     sa;
+    struct sockaddr_in  sa4;
+    struct sockaddr_in6 sa6;
+} uSockAddr;
+
+#ifdef __linux__
+// control message buffer for the kernel receive timestamp (SO_TIMESTAMPNS)
+typedef union
+{
+    struct cmsghdr hdr;
+    char           buf[CMSG_SPACE ( sizeof ( struct timespec ) )];
+} uRecvCtrlBuf;
+#endif
+
 /* Classes ********************************************************************/
+/* Received packet ---------------------------------------------------------- */
+// one slot of the receive batch of the socket
+class CRecvPacket
+{
+public:
+    CRecvPacket() : iNumBytes ( 0 ), iArrivalTimeNs ( 0 ), iChanID ( 0 ), bIsAudio ( false ), bNewConnection ( false ) {}
+
+    CVector<uint8_t> vecbyData;
+    int              iNumBytes;
+    int64_t          iArrivalTimeNs; // kernel receive timestamp (system clock) if available
+    uSockAddr        SockAddr;
+    CHostAddress     HostAddr; // not converted for audio packets of known server channels
+
+    // audio packet dispatch (the channel ID and the new connection flag are
+    // set by the server)
+    int  iChanID;
+    bool bIsAudio;
+    bool bNewConnection;
+};
+
+/* Protocol packet queue ---------------------------------------------------- */
+// A received protocol message which is handed from the socket thread to the
+// protocol thread.
+class CProtPacketSlot
+{
+public:
+    CProtPacketSlot() : iRecCounter ( 0 ), iRecID ( 0 ), bIsConnectionLess ( false ) {}
+
+    CVector<uint8_t> vecbyMesBodyData;
+    CHostAddress     HostAddr;
+    int              iRecCounter;
+    int              iRecID;
+    bool             bIsConnectionLess;
+};
+
+// Pool of preallocated protocol message slots. The socket thread takes a free
+// slot, fills it and pushes it to the queue of filled slots, the protocol
+// thread pops it and releases it back to the pool. Both queues are lock-free
+// and never allocate, so the real-time socket thread does no heap allocation
+// for the protocol messages. If the pool is exhausted, the message is dropped
+// and counted. Only the connection messages are retransmitted by the sender,
+// dropped connection less messages (e.g. ping, server list or registration
+// requests) are lost.
+class CProtPacketQueue
+{
+public:
+    CProtPacketQueue() : iNumDropped ( 0 ) {}
+
+    void Init ( const int iNumSlots );
+
+    CProtPacketSlot* GetFreeSlot();
+    void             Push ( CProtPacketSlot* pSlot ) { FilledSlots.Push ( pSlot ); }
+
+    CProtPacketSlot* Pop();
+    void             Release ( CProtPacketSlot* pSlot ) { FreeSlots.Push ( pSlot ); }
+
+    void     CountDropped() { iNumDropped++; }
+    uint64_t GetNumDropped() const { return iNumDropped; }
+
+protected:
+    std::unique_ptr<CProtPacketSlot[]> pSlots;
+    CLockFreeQueue<CProtPacketSlot*>   FreeSlots;
+    CLockFreeQueue<CProtPacketSlot*>   FilledSlots;
+    std::atomic<uint64_t>              iNumDropped; // messages dropped since the pool was exhausted
+};
+
+/* Send batch --------------------------------------------------------------- */
+// Preallocated collection of outgoing packets. The packets are copied into one
+// buffer together with their native destination address and are sent with
+// one sendmmsg call on Linux when the batch is flushed (or full). A batch must
+// only be used by one thread at a time.
+class CSendBatch
+{
+public:
+    CSendBatch() : pSocket ( nullptr ), iNumPackets ( 0 ), iNumBytes ( 0 ) {}
+
+    void Init ( CSocket* pNSocket );
+    void Add ( const CVector<uint8_t>& vecbySendBuf, const uSockAddr& SockAddr, const int iSockAddrLen );
+    void Flush();
+
+protected:
+    friend class CSocket;
+
+#ifdef __linux__
+    // combines runs of equally sized packets to the same destination in UDP
+    // GSO messages, returns the number of messages
+    int PrepareGsoMsgHdrs();
+
+    typedef union
+    {
+        struct cmsghdr hdr;
+        char           buf[CMSG_SPACE ( sizeof ( uint16_t ) )];
+    } uGsoCtrlBuf;
+#endif
+
+    CSocket*           pSocket;
+    CVector<uint8_t>   vecbyData;
+    CVector<int>       veciOffset;
+    CVector<int>       veciSize;
+    CVector<uSockAddr> vecSockAddr;
+    CVector<int>       veciSockAddrLen;
+    int                iNumPackets;
+    int                iNumBytes;
+#ifdef __linux__
+    std::vector<struct mmsghdr> vecMsgHdrs;
+    std::vector<struct iovec>   vecIoVecs;
+    std::vector<struct mmsghdr> vecGsoMsgHdrs;
+    std::vector<struct iovec>   vecGsoIoVecs;
+    std::vector<uGsoCtrlBuf>    vecGsoCtrlBufs;
+    std::vector<int>            vecGsoFirstPacket; // first packet of each message
+#endif
+#ifdef HAVE_IO_URING
+    std::unique_ptr<CIoUring> pSendRing;
+#endif
+};
+
 /* Base socket class -------------------------------------------------------- */
 class CSocket : public QObject
 {
@@ -54,17 +225,64 @@ class CSocket : public QObject
 
 public:
     CSocket ( CChannel* pNewChannel, const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP, bool bEnableIPv6 );
-    CSocket ( CServer* pNServP, const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP, bool bEnableIPv6 );
+    CSocket ( CServer*       pNServP,
+              const quint16  iPortNumber,
+              const quint16  iQosNumber,
+              const QString& strServerBindIP,
+              bool           bEnableIPv6,
+              bool           bReusePort  = false,
+              bool           bUseIoUring = false );
 
     virtual ~CSocket();
 
     void SendPacket ( const CVector<uint8_t>& vecbySendBuf, const CHostAddress& HostAddr );
+    void SendPacket ( const CVector<uint8_t>& vecbySendBuf, const uSockAddr& SockAddr, const int iSockAddrLen );
+    void SendBatch ( CSendBatch& SendBatch );
+
+    // converts the address to the native address for this socket, returns the
+    // address length or zero if the address cannot be used with this socket
+    int GetSockAddr ( const CHostAddress& HostAddr, uSockAddr& SockAddr ) const;
+
+    // converts a received native address to the host address
+    static void GetHostAddr ( const uSockAddr& SockAddr, CHostAddress& HostAddr );
+
+    // current time of the clock of the receive timestamps
+    static int64_t GetArrivalTimeNs();
+
+    bool IsIoUringEnabled() const { return bUseIoUring; }
+
+    // number of received protocol messages which were dropped since the slot
+    // pool was exhausted
+    uint64_t GetNumDroppedProtPackets() const { return ProtPacketQueue.GetNumDropped(); }
+
+    // false if the port could not be shared although it was requested
+    bool IsReusePortEnabled() const { return bReusePort; }
+
+    // multiple sockets can only share a port with load balancing on Linux
+    static bool IsReusePortSupported()
+    {
+#ifdef __linux__
+        return true;
+#else
+        return false;
+#endif
+    }
 
     bool GetAndResetbJitterBufferOKFlag();
     void Close();
 
+    // parses the queued protocol messages (called in the protocol thread)
+    void ProcessProtocolPackets();
+
 protected:
     void    Init ( const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP );
+    int     ReceiveBatch();
+#ifdef __linux__
+    static int64_t GetRecvTimestampNs ( const struct msghdr& MsgHdr );
+#endif
+    void    InitIoUring();
+    int     ReceiveBatchIoUring();
+    void    SendBatchPackets ( CSendBatch& SendBatch, const int iFirstPacket, const int iEndPacket );
     quint16 iPortNumber;
     quint16 iQosNumber;
     QString strServerBindIP;
@@ -77,20 +295,46 @@ protected:
 
     QMutex Mutex;
 
-    CVector<uint8_t> vecbyRecBuf;
-    CHostAddress     RecHostAddr;
-    QHostAddress     SenderAddress;
-    quint16          SenderPort;
+    // receive batch (on Linux the server drains the socket with recvmmsg,
+    // otherwise a batch consists of a single packet)
+    CVector<CRecvPacket> vecRecPackets;
+#ifdef __linux__
+    std::vector<struct mmsghdr> vecRecMsgHdrs;
+    std::vector<struct iovec>   vecRecIoVecs;
+    std::vector<uRecvCtrlBuf>   vecRecCtrlBufs; // receive timestamps
+    bool                        bUseRecvMMsg;
+    std::atomic<bool>           bUseSendMMsg;
+    std::atomic<bool>           bUseGso; // UDP generic segmentation offload (server)
+#endif
 
     CChannel* pChannel; // for client
     CServer*  pServer;  // for server
 
+    // received protocol messages, the protocol thread is only notified if the
+    // queue was drained before
+    CProtPacketQueue  ProtPacketQueue;
+    std::atomic<bool> bProtPacketsPosted;
+    CVector<uint8_t>  vecbyRecMesBodyData;
+
     bool bIsClient;
 
     bool bJitterBufferOK;
 
     bool bEnableIPv6;
 
+    // for the server: the port can be shared with other sockets (SO_REUSEPORT)
+    bool bReusePort;
+
+    // for the server: use the io_uring network backend (the receive ring
+    // uses a multishot receive into the provided buffers, the send batches
+    // have their own rings)
+    bool bUseIoUring;
+#ifdef HAVE_IO_URING
+    std::unique_ptr<CIoUring> pRecvRing;
+    struct msghdr             RecvRingMsgHdr;
+    bool                      bRecvRingArmed;
+#endif
+
 public:
     void OnDataReceived();
 
@@ -104,9 +348,7 @@ signals:
 
     void InvalidPacketReceived ( CHostAddress RecHostAddr );
 
-    void ProtocolMessageReceived ( int iRecCounter, int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress HostAdr );
-
-    void ProtocolCLMessageReceived ( int iRecID, CVector<uint8_t> vecbyMesBodyData, CHostAddress HostAdr );
+    void ProtocolPacketsQueued();
 };
 
 /* Socket which runs in a separate high priority thread --------------------- */
@@ -131,8 +373,14 @@ public:
         Init();
     }
 
-    CHighPrioSocket ( CServer* pNewServer, const quint16 iPortNumber, const quint16 iQosNumber, const QString& strServerBindIP, bool bEnableIPv6 ) :
-        Socket ( pNewServer, iPortNumber, iQosNumber, strServerBindIP, bEnableIPv6 )
+    CHighPrioSocket ( CServer*       pNewServer,
+                      const quint16  iPortNumber,
+                      const quint16  iQosNumber,
+                      const QString& strServerBindIP,
+                      bool           bEnableIPv6,
+                      bool           bReusePort  = false,
+                      bool           bUseIoUring = false ) :
+        Socket ( pNewServer, iPortNumber, iQosNumber, strServerBindIP, bEnableIPv6, bReusePort, bUseIoUring )
     {
         Init();
     }
@@ -148,8 +396,21 @@ public:
 
     void SendPacket ( const CVector<uint8_t>& vecbySendBuf, const CHostAddress& HostAddr ) { Socket.SendPacket ( vecbySendBuf, HostAddr ); }
 
+    void SendPacket ( const CVector<uint8_t>& vecbySendBuf, const uSockAddr& SockAddr, const int iSockAddrLen )
+    {
+        Socket.SendPacket ( vecbySendBuf, SockAddr, iSockAddrLen );
+    }
+
+    int GetSockAddr ( const CHostAddress& HostAddr, uSockAddr& SockAddr ) const { return Socket.GetSockAddr ( HostAddr, SockAddr ); }
+
+    void InitSendBatch ( CSendBatch& SendBatch ) { SendBatch.Init ( &Socket ); }
+
     bool GetAndResetbJitterBufferOKFlag() { return Socket.GetAndResetbJitterBufferOKFlag(); }
 
+    bool IsReusePortEnabled() const { return Socket.IsReusePortEnabled(); }
+
+    uint64_t GetNumDroppedProtPackets() const { return Socket.GetNumDroppedProtPackets(); }
+
 protected:
     class CSocketThread : public QThread
     {
@@ -215,10 +476,3 @@ signals:
     void InvalidPacketReceived ( CHostAddress RecHostAddr );
 };
 
-// overlay generic, IPv4 and IPv6 sockaddr structures
-typedef union
-{
-    struct sockaddr     sa;
-    struct sockaddr_in  sa4;
-    struct sockaddr_in6 sa6;
-} uSockAddr;
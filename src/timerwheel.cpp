@@ -0,0 +1,254 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#include "timerwheel.h"
+#include <QThread>
+#include <algorithm>
+
+/* Implementation *************************************************************/
+Q_GLOBAL_STATIC ( CTimerWheel, TimerWheelInstance )
+
+CTimerWheel* CTimerWheel::GetInstance() { return TimerWheelInstance; }
+
+void CTimerWheel::CTimer::Start ( const int iTimeOutMs )
+{
+    CTimerWheel* pWheel = CTimerWheel::GetInstance();
+
+    if ( pWheel != nullptr )
+    {
+        pWheel->Start ( this, iTimeOutMs );
+    }
+}
+
+void CTimerWheel::CTimer::Stop()
+{
+    // the wheel may already be destroyed on application exit
+    CTimerWheel* pWheel = CTimerWheel::GetInstance();
+
+    if ( pWheel != nullptr )
+    {
+        pWheel->Stop ( this );
+    }
+}
+
+bool CTimerWheel::CTimer::isActive() const
+{
+    CTimerWheel* pWheel = CTimerWheel::GetInstance();
+
+    return ( pWheel != nullptr ) && pWheel->IsActive ( this );
+}
+
+CTimerWheel::CTimerWheel() : pExpired ( nullptr ), iCurSlot ( 0 ), iNumActive ( 0 ), bTicking ( false ), iLastTickMs ( 0 )
+{
+    for ( int i = 0; i < TIMER_WHEEL_NUM_SLOTS; i++ )
+    {
+        pSlots[i] = nullptr;
+    }
+
+    ElapsedTimer.start();
+
+    // Connections -------------------------------------------------------------
+    QObject::connect ( &TickTimer, &QTimer::timeout, this, &CTimerWheel::OnTick );
+}
+
+void CTimerWheel::Link ( CTimer* pTimer, CTimer*& pHead )
+{
+    pTimer->pPrev  = nullptr;
+    pTimer->pNext  = pHead;
+    pTimer->ppHead = &pHead;
+
+    if ( pHead != nullptr )
+    {
+        pHead->pPrev = pTimer;
+    }
+
+    pHead = pTimer;
+}
+
+void CTimerWheel::Unlink ( CTimer* pTimer )
+{
+    if ( pTimer->pPrev != nullptr )
+    {
+        pTimer->pPrev->pNext = pTimer->pNext;
+    }
+    else
+    {
+        *pTimer->ppHead = pTimer->pNext;
+    }
+
+    if ( pTimer->pNext != nullptr )
+    {
+        pTimer->pNext->pPrev = pTimer->pPrev;
+    }
+
+    pTimer->pPrev  = nullptr;
+    pTimer->pNext  = nullptr;
+    pTimer->ppHead = nullptr;
+}
+
+void CTimerWheel::Start ( CTimer* pTimer, const int iTimeOutMs )
+{
+    bool bStartTicks = false;
+
+    {
+        std::unique_lock<std::mutex> lock ( Mutex );
+
+        // a restart of an active timer moves it to the new slot
+        if ( pTimer->ppHead != nullptr )
+        {
+            Unlink ( pTimer );
+        }
+        else
+        {
+            iNumActive++;
+        }
+
+        // the slot is reached after iNumTicks ticks, each further revolution of
+        // the wheel is counted by the rounds
+        const int iNumTicks = std::max ( 1, ( iTimeOutMs + TIMER_WHEEL_TICK_MS - 1 ) / TIMER_WHEEL_TICK_MS );
+
+        pTimer->iRounds = ( iNumTicks - 1 ) / TIMER_WHEEL_NUM_SLOTS;
+
+        Link ( pTimer, pSlots[( iCurSlot + iNumTicks ) % TIMER_WHEEL_NUM_SLOTS] );
+
+        if ( !bTicking )
+        {
+            bTicking    = true;
+            bStartTicks = true;
+        }
+    }
+
+    if ( bStartTicks )
+    {
+        // the tick timer can only be started in the thread of the wheel
+        if ( QThread::currentThread() == thread() )
+        {
+            StartTicks();
+        }
+        else
+        {
+            QMetaObject::invokeMethod ( this, "OnStartTicks", Qt::QueuedConnection );
+        }
+    }
+}
+
+void CTimerWheel::Stop ( CTimer* pTimer )
+{
+    std::unique_lock<std::mutex> lock ( Mutex );
+
+    if ( pTimer->ppHead != nullptr )
+    {
+        Unlink ( pTimer );
+        iNumActive--;
+    }
+}
+
+bool CTimerWheel::IsActive ( const CTimer* pTimer )
+{
+    std::unique_lock<std::mutex> lock ( Mutex );
+
+    return pTimer->ppHead != nullptr;
+}
+
+void CTimerWheel::OnStartTicks() { StartTicks(); }
+
+void CTimerWheel::StartTicks()
+{
+    // the wheel was idle, the ticks are counted from now on
+    iLastTickMs = ElapsedTimer.elapsed();
+
+    TickTimer.start ( TIMER_WHEEL_TICK_MS );
+}
+
+void CTimerWheel::OnTick()
+{
+    // the number of ticks is derived from the elapsed time so that the wheel
+    // does not fall behind if the event loop was busy
+    const qint64 iNowMs    = ElapsedTimer.elapsed();
+    const int    iNumTicks = static_cast<int> ( ( iNowMs - iLastTickMs ) / TIMER_WHEEL_TICK_MS );
+
+    iLastTickMs += static_cast<qint64> ( iNumTicks ) * TIMER_WHEEL_TICK_MS;
+
+    for ( int iTick = 0; iTick < iNumTicks; iTick++ )
+    {
+        {
+            std::unique_lock<std::mutex> lock ( Mutex );
+
+            // advance the wheel and collect the expired timers of the new slot
+            iCurSlot = ( iCurSlot + 1 ) % TIMER_WHEEL_NUM_SLOTS;
+
+            CTimer* pTimer = pSlots[iCurSlot];
+
+            while ( pTimer != nullptr )
+            {
+                CTimer* pNextTimer = pTimer->pNext;
+
+                if ( pTimer->iRounds == 0 )
+                {
+                    Unlink ( pTimer );
+                    Link ( pTimer, pExpired );
+                }
+                else
+                {
+                    pTimer->iRounds--;
+                }
+
+                pTimer = pNextTimer;
+            }
+        }
+
+        // call the expired timers one by one without holding the mutex (a
+        // callback may start or stop timers, including the expired ones)
+        for ( ;; )
+        {
+            CTimer* pTimer;
+
+            {
+                std::unique_lock<std::mutex> lock ( Mutex );
+
+                pTimer = pExpired;
+
+                if ( pTimer == nullptr )
+                {
+                    break;
+                }
+
+                Unlink ( pTimer );
+                iNumActive--;
+            }
+
+            pTimer->Callback();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock ( Mutex );
+
+    // stop ticking if the wheel is idle
+    if ( iNumActive == 0 )
+    {
+        bTicking = false;
+        TickTimer.stop();
+    }
+}
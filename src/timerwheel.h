@@ -0,0 +1,110 @@
+/******************************************************************************\
+ * Copyright (c) 2004-2022
+ *
+ * Author(s):
+ *  Volker Fischer
+ *
+ ******************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+\******************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <functional>
+#include <mutex>
+
+/* Definitions ****************************************************************/
+// resolution of the timer wheel and number of slots (one revolution of the
+// wheel covers TIMER_WHEEL_TICK_MS * TIMER_WHEEL_NUM_SLOTS, longer time outs
+// need additional rounds)
+#define TIMER_WHEEL_TICK_MS   10
+#define TIMER_WHEEL_NUM_SLOTS 64
+
+/* Classes ********************************************************************/
+// Hashed timer wheel for the protocol retransmission timers. Instead of one
+// QTimer per protocol object there is one tick timer in the thread which uses
+// the wheel first (the main thread) and starting, stopping and expiring a
+// timer is O(1). The tick timer only runs while a timer is active and the
+// callbacks are called in the thread of the wheel.
+class CTimerWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    // a single shot timer, the object is owned by the user and is linked into
+    // a list of the wheel while it is active
+    class CTimer
+    {
+    public:
+        CTimer ( const std::function<void()>& NewCallback ) :
+            Callback ( NewCallback ),
+            pPrev ( nullptr ),
+            pNext ( nullptr ),
+            ppHead ( nullptr ),
+            iRounds ( 0 )
+        {
+            // the wheel lives in the thread which creates the first timer
+            CTimerWheel::GetInstance();
+        }
+
+        ~CTimer() { Stop(); }
+
+        void Start ( const int iTimeOutMs );
+        void Stop();
+        bool isActive() const;
+
+    protected:
+        friend class CTimerWheel;
+
+        std::function<void()> Callback;
+        CTimer*               pPrev;
+        CTimer*               pNext;
+        CTimer**              ppHead; // list the timer is linked into (nullptr if inactive)
+        int                   iRounds;
+    };
+
+    CTimerWheel();
+
+    static CTimerWheel* GetInstance();
+
+protected:
+    void Start ( CTimer* pTimer, const int iTimeOutMs );
+    void Stop ( CTimer* pTimer );
+    bool IsActive ( const CTimer* pTimer );
+    void StartTicks();
+
+    static void Link ( CTimer* pTimer, CTimer*& pHead );
+    static void Unlink ( CTimer* pTimer );
+
+    std::mutex    Mutex;
+    CTimer*       pSlots[TIMER_WHEEL_NUM_SLOTS];
+    CTimer*       pExpired;
+    int           iCurSlot;
+    int           iNumActive;
+    bool          bTicking;
+    QTimer        TickTimer;
+    QElapsedTimer ElapsedTimer;
+    qint64        iLastTickMs;
+
+public slots:
+    void OnTick();
+    void OnStartTicks();
+};
@@ -125,51 +125,209 @@ double CStereoSignalLevelMeter::CalcLogResultForMeter ( const double& dLinearLev
 
     return dLevelForMeterdB;
 }
-
 // CRC -------------------------------------------------------------------------
-void CCRC::Reset()
+CCRC::CTables::CTables()
 {
-    // init state shift-register with ones. Set all registers to "1" with
-    // bit-wise not operation
-    iStateShiftReg = ~uint32_t ( 0 );
-}
+    const uint16_t iPoly = ( 1 << 12 ) | ( 1 << 5 ) | 1;
 
-void CCRC::AddByte ( const uint8_t byNewInput )
-{
-    for ( int i = 0; i < 8; i++ )
+    for ( int i = 0; i < 256; i++ )
     {
-        // shift bits in shift-register for transition
-        iStateShiftReg <<= 1;
+        uint16_t iReg = static_cast<uint16_t> ( i << 8 );
 
-        // take bit, which was shifted out of the register-size and place it
-        // at the beginning (LSB)
-        // (If condition is not satisfied, implicitly a "0" is added)
-        if ( ( iStateShiftReg & iBitOutMask ) > 0 )
+        for ( int iBit = 0; iBit < 8; iBit++ )
         {
-            iStateShiftReg |= 1;
+            iReg = static_cast<uint16_t> ( ( iReg & 0x8000 ) ? ( iReg << 1 ) ^ iPoly : iReg << 1 );
         }
 
-        // add new data bit to the LSB
-        if ( ( byNewInput & ( 1 << ( 8 - i - 1 ) ) ) > 0 )
-        {
-            iStateShiftReg ^= 1;
-        }
+        iTable[0][i] = iReg;
+    }
 
-        // add mask to shift-register if first bit is true
-        if ( iStateShiftReg & 1 )
+    for ( int k = 1; k < 8; k++ )
+    {
+        for ( int i = 0; i < 256; i++ )
         {
-            iStateShiftReg ^= iPoly;
+            const uint16_t iPrev = iTable[k - 1][i];
+            iTable[k][i]         = static_cast<uint16_t> ( ( iPrev << 8 ) ^ iTable[0][iPrev >> 8] );
         }
     }
 }
 
+void CCRC::Reset()
+{
+    // init state shift-register with ones
+    iStateShiftReg = 0xFFFF;
+}
+
+void CCRC::AddByte ( const uint8_t byNewInput )
+{
+    const CTables& Tables = GetTables();
+
+    iStateShiftReg = ( ( iStateShiftReg << 8 ) ^ Tables.iTable[0][( ( iStateShiftReg >> 8 ) ^ byNewInput ) & 0xFF] ) & 0xFFFF;
+}
+
+void CCRC::AddBlock ( const uint8_t* pbyData, const int iNumBytes )
+{
+    const CTables& Tables = GetTables();
+
+    uint32_t iReg = iStateShiftReg & 0xFFFF;
+    int      i    = 0;
+
+    // eight bytes per step: the shift register is combined with the first two
+    // bytes, the other bytes only depend on their distance to the end of the step
+    for ( ; i + 8 <= iNumBytes; i += 8 )
+    {
+        const uint8_t* p = pbyData + i;
+
+        iReg = Tables.iTable[7][( iReg >> 8 ) ^ p[0]] ^ Tables.iTable[6][( iReg & 0xFF ) ^ p[1]] ^ Tables.iTable[5][p[2]] ^ Tables.iTable[4][p[3]] ^
+               Tables.iTable[3][p[4]] ^ Tables.iTable[2][p[5]] ^ Tables.iTable[1][p[6]] ^ Tables.iTable[0][p[7]];
+    }
+
+    // remaining bytes
+    for ( ; i < iNumBytes; i++ )
+    {
+        iReg = ( ( iReg << 8 ) ^ Tables.iTable[0][( iReg >> 8 ) ^ pbyData[i]] ) & 0xFFFF;
+    }
+
+    iStateShiftReg = iReg;
+}
+
 uint32_t CCRC::GetCRC()
 {
     // return inverted shift-register (1's complement)
     iStateShiftReg = ~iStateShiftReg;
 
-    // remove bit which where shifted out of the shift-register frame
-    return iStateShiftReg & ( iBitOutMask - 1 );
+    return iStateShiftReg & 0xFFFF;
+}
+
+// Packet arrival jitter measurement -------------------------------------------
+void CArrivalJitterStatistic::Reset()
+{
+    vecfIntervalsMs.Init ( ARRIVAL_STAT_HISTORY_LEN, 0 );
+    vecfDelaysMs.Init ( ARRIVAL_STAT_HISTORY_LEN, 0 );
+    vecfScratch.Init ( ARRIVAL_STAT_HISTORY_LEN, 0 );
+
+    iHistoryPos        = 0;
+    iNumHistory        = 0;
+    bStarted           = false;
+    iStartTimeNs       = 0;
+    iLastArrivalTimeNs = 0;
+    iNumIntervals      = 0;
+    dNominalIntervalNs = 0;
+    dRefArrivalNs      = 0;
+}
+
+void CArrivalJitterStatistic::Restart ( const int64_t iArrivalTimeNs, const double dNominalIntervalNs )
+{
+    // the history is kept, only the time reference starts again
+    bStarted                 = true;
+    iStartTimeNs             = iArrivalTimeNs;
+    iLastArrivalTimeNs       = iArrivalTimeNs;
+    iNumIntervals            = 0;
+    this->dNominalIntervalNs = dNominalIntervalNs;
+    dRefArrivalNs            = 0;
+}
+
+double CArrivalJitterStatistic::Update ( const int64_t iArrivalTimeNs, const double dNominalIntervalNs )
+{
+    const int64_t iIntervalNs = iArrivalTimeNs - iLastArrivalTimeNs;
+
+    // reordered packets have a negative interval, a large jump in either
+    // direction is a pause of the stream or a step of the system clock
+    if ( !bStarted || ( std::abs ( iIntervalNs ) > ARRIVAL_STAT_MAX_GAP_NS ) || ( dNominalIntervalNs != this->dNominalIntervalNs ) )
+    {
+        Restart ( iArrivalTimeNs, dNominalIntervalNs );
+        return -1;
+    }
+
+    iLastArrivalTimeNs = iArrivalTimeNs;
+    iNumIntervals++;
+
+    // the mean interval since the start includes the clock drift of the sender
+    const double dArrivalNs      = static_cast<double> ( iArrivalTimeNs - iStartTimeNs );
+    const double dMeanIntervalNs = dArrivalNs / iNumIntervals;
+
+    // advance the delay reference by one interval, a packet which arrives
+    // before the reference becomes the new reference
+    dRefArrivalNs += dMeanIntervalNs;
+
+    double dDelayNs = dArrivalNs - dRefArrivalNs;
+
+    if ( dDelayNs < 0 )
+    {
+        dRefArrivalNs = dArrivalNs;
+        dDelayNs      = 0;
+    }
+    else
+    {
+        dRefArrivalNs += dDelayNs * ARRIVAL_STAT_REF_WEIGHT;
+    }
+
+    // store in the history
+    vecfIntervalsMs[iHistoryPos] = static_cast<float> ( iIntervalNs * 1e-6 );
+    vecfDelaysMs[iHistoryPos]    = static_cast<float> ( dDelayNs * 1e-6 );
+
+    iHistoryPos = ( iHistoryPos + 1 ) % ARRIVAL_STAT_HISTORY_LEN;
+    iNumHistory = std::min ( iNumHistory + 1, ARRIVAL_STAT_HISTORY_LEN );
+
+    return dDelayNs;
+}
+
+void CArrivalJitterStatistic::GetSnapshot ( CArrivalJitterStatistic& Snapshot ) const
+{
+    // the order of the history does not matter for the percentiles, the
+    // vectors of the snapshot are already allocated by its Reset()
+    std::copy ( &vecfIntervalsMs[0], &vecfIntervalsMs[0] + iNumHistory, &Snapshot.vecfIntervalsMs[0] );
+    std::copy ( &vecfDelaysMs[0], &vecfDelaysMs[0] + iNumHistory, &Snapshot.vecfDelaysMs[0] );
+
+    Snapshot.iHistoryPos        = iHistoryPos;
+    Snapshot.iNumHistory        = iNumHistory;
+    Snapshot.bStarted           = bStarted;
+    Snapshot.iStartTimeNs       = iStartTimeNs;
+    Snapshot.iLastArrivalTimeNs = iLastArrivalTimeNs;
+    Snapshot.iNumIntervals      = iNumIntervals;
+    Snapshot.dNominalIntervalNs = dNominalIntervalNs;
+    Snapshot.dRefArrivalNs      = dRefArrivalNs;
+}
+
+void CArrivalJitterStatistic::GetInfo ( CArrivalJitterInfo& Info )
+{
+    Info = CArrivalJitterInfo();
+
+    if ( iNumHistory == 0 )
+    {
+        return;
+    }
+
+    Info.iNumPackets = iNumHistory;
+
+    if ( iNumIntervals > 0 )
+    {
+        const double dMeanIntervalNs = static_cast<double> ( iLastArrivalTimeNs - iStartTimeNs ) / iNumIntervals;
+
+        Info.dMeanIntervalMs = dMeanIntervalNs * 1e-6;
+
+        if ( dNominalIntervalNs > 0 )
+        {
+            Info.dDriftPpm = ( dMeanIntervalNs - dNominalIntervalNs ) / dNominalIntervalNs * 1e6;
+        }
+    }
+
+    // percentiles of the sorted history
+    float* const pfBegin = &vecfScratch[0];
+    float* const pfEnd   = pfBegin + iNumHistory;
+
+    std::copy ( &vecfIntervalsMs[0], &vecfIntervalsMs[0] + iNumHistory, pfBegin );
+    std::sort ( pfBegin, pfEnd );
+
+    Info.dIntervalP99Ms = pfBegin[( iNumHistory - 1 ) * 99 / 100];
+
+    std::copy ( &vecfDelaysMs[0], &vecfDelaysMs[0] + iNumHistory, pfBegin );
+    std::sort ( pfBegin, pfEnd );
+
+    Info.dDelayP50Ms = pfBegin[( iNumHistory - 1 ) / 2];
+    Info.dDelayP95Ms = pfBegin[( iNumHistory - 1 ) * 95 / 100];
+    Info.dDelayP99Ms = pfBegin[( iNumHistory - 1 ) * 99 / 100];
+    Info.dDelayMaxMs = pfBegin[iNumHistory - 1];
 }
 
 /******************************************************************************\
@@ -54,6 +54,7 @@
 #include <QTextBoundaryFinder>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include "global.h"
 #ifdef _WIN32
 #    include <winsock2.h>
@@ -505,6 +506,13 @@ enum EGetDataStat
     GS_CHAN_NOT_CONNECTED
 };
 
+// Jitter buffer strategy enum -------------------------------------------------
+enum EJitBufStrategy
+{
+    JS_ERROR_RATE       = 0, // error rates of simulated buffers (default)
+    JS_DELAY_PERCENTILE = 1  // windowed percentile of the packet arrival delays
+};
+
 // GUI design enum -------------------------------------------------------------
 enum EGUIDesign
 {
@@ -1129,19 +1137,44 @@ protected:
 };
 
 // CRC -------------------------------------------------------------------------
+// CRC-16 with the polynomial x^16 + x^12 + x^5 + 1, the shift register is
+// initialized with ones and the result is inverted. The bytes are processed
+// with lookup tables, eight bytes at a time for blocks (slice-by-8).
 class CCRC
 {
 public:
-    CCRC() : iPoly ( ( 1 << 5 ) | ( 1 << 12 ) ), iBitOutMask ( 1 << 16 ) { Reset(); }
+    CCRC() { Reset(); }
 
     void     Reset();
     void     AddByte ( const uint8_t byNewInput );
+    void     AddBlock ( const uint8_t* pbyData, const int iNumBytes );
     bool     CheckCRC ( const uint32_t iCRC ) { return iCRC == GetCRC(); }
     uint32_t GetCRC();
 
+    // CRC of a contiguous block
+    static uint32_t Calc ( const uint8_t* pbyData, const int iNumBytes )
+    {
+        CCRC CRCObj;
+        CRCObj.AddBlock ( pbyData, iNumBytes );
+        return CRCObj.GetCRC();
+    }
+
 protected:
-    uint32_t iPoly;
-    uint32_t iBitOutMask;
+    // table k contains the CRC of a byte followed by k zero bytes
+    class CTables
+    {
+    public:
+        CTables();
+
+        uint16_t iTable[8][256];
+    };
+
+    static const CTables& GetTables()
+    {
+        static const CTables Tables;
+        return Tables;
+    }
+
     uint32_t iStateShiftReg;
 };
 
@@ -1260,6 +1293,120 @@ protected:
     int           iCnt;
 };
 
+// Histogram of measured times with logarithmic buckets (four buckets per
+// octave of microseconds, i.e. a resolution of better than 25 %). Adding a
+// value only needs a few relaxed atomic operations, so it can be used in the
+// real-time threads while another thread reads the histogram.
+#define TIMING_HIST_NUM_BUCKETS 96
+
+class CTimingHistogram
+{
+public:
+    CTimingHistogram() { Reset(); }
+
+    void Reset()
+    {
+        for ( int i = 0; i < TIMING_HIST_NUM_BUCKETS; i++ )
+        {
+            iBuckets[i].store ( 0, std::memory_order_relaxed );
+        }
+
+        iCount.store ( 0, std::memory_order_relaxed );
+        iSumNs.store ( 0, std::memory_order_relaxed );
+        iMaxNs.store ( 0, std::memory_order_relaxed );
+    }
+
+    void Add ( const int64_t iTimeNs )
+    {
+        const uint64_t iValNs = iTimeNs > 0 ? static_cast<uint64_t> ( iTimeNs ) : 0;
+
+        iBuckets[GetBucket ( iValNs / 1000 )].fetch_add ( 1, std::memory_order_relaxed );
+        iCount.fetch_add ( 1, std::memory_order_relaxed );
+        iSumNs.fetch_add ( iValNs, std::memory_order_relaxed );
+
+        uint64_t iCurMaxNs = iMaxNs.load ( std::memory_order_relaxed );
+
+        while ( ( iValNs > iCurMaxNs ) && !iMaxNs.compare_exchange_weak ( iCurMaxNs, iValNs, std::memory_order_relaxed ) )
+        {
+        }
+    }
+
+    uint64_t GetCount() const { return iCount.load ( std::memory_order_relaxed ); }
+    uint64_t GetBucketCount ( const int iBucket ) const { return iBuckets[iBucket].load ( std::memory_order_relaxed ); }
+    double   GetMaxUs() const { return static_cast<double> ( iMaxNs.load ( std::memory_order_relaxed ) ) / 1000; }
+
+    double GetMeanUs() const
+    {
+        const uint64_t iCurCount = GetCount();
+
+        return iCurCount > 0 ? static_cast<double> ( iSumNs.load ( std::memory_order_relaxed ) ) / iCurCount / 1000 : 0;
+    }
+
+    // upper bound of the bucket in microseconds (exclusive)
+    static double GetBucketUpperUs ( const int iBucket )
+    {
+        if ( iBucket < 4 )
+        {
+            return iBucket + 1;
+        }
+
+        const int iShift = iBucket / 4 - 1;
+
+        return static_cast<double> ( static_cast<uint64_t> ( 4 + iBucket % 4 + 1 ) << iShift );
+    }
+
+    // upper bound of the bucket which contains the given percentile (0..100)
+    double GetPercentileUs ( const double dPercentile ) const
+    {
+        const uint64_t iCurCount = GetCount();
+        uint64_t       iSum      = 0;
+
+        if ( iCurCount == 0 )
+        {
+            return 0;
+        }
+
+        for ( int i = 0; i < TIMING_HIST_NUM_BUCKETS; i++ )
+        {
+            iSum += GetBucketCount ( i );
+
+            if ( iSum * 100.0 >= dPercentile * iCurCount )
+            {
+                return std::min ( GetBucketUpperUs ( i ), GetMaxUs() );
+            }
+        }
+
+        return GetMaxUs();
+    }
+
+protected:
+    static int GetBucket ( const uint64_t iTimeUs )
+    {
+        if ( iTimeUs < 4 )
+        {
+            return static_cast<int> ( iTimeUs );
+        }
+
+        // the octave is given by the highest bit, the next two bits select
+        // the bucket in the octave
+        int iOctave = 2;
+
+        while ( ( iTimeUs >> ( iOctave + 1 ) ) != 0 )
+        {
+            iOctave++;
+        }
+
+        const int iBucket = 4 * ( iOctave - 1 ) + static_cast<int> ( ( iTimeUs >> ( iOctave - 2 ) ) & 3 );
+
+        return std::min ( iBucket, TIMING_HIST_NUM_BUCKETS - 1 );
+    }
+
+    std::atomic<uint64_t> iBuckets[TIMING_HIST_NUM_BUCKETS];
+    std::atomic<uint64_t> iCount;
+    std::atomic<uint64_t> iSumNs;
+    std::atomic<uint64_t> iMaxNs;
+};
+
 /******************************************************************************\
 * Statistics                                                                   *
 \******************************************************************************/
@@ -1317,3 +1464,75 @@ protected:
     bool            bBlockOnDoubleErrors;
     bool            bPreviousState;
 };
+
+// Packet arrival jitter measurement -------------------------------------------
+// number of packets in the history of the arrival statistic
+#define ARRIVAL_STAT_HISTORY_LEN 4096
+
+// an arrival time jump larger than this (stream pause, clock step) restarts the statistic
+#define ARRIVAL_STAT_MAX_GAP_NS 500000000LL
+
+// weight with which the delay reference follows the arrivals of delayed
+// packets (so that an underestimated packet interval does not accumulate)
+#define ARRIVAL_STAT_REF_WEIGHT 0.001
+
+class CArrivalJitterInfo
+{
+public:
+    CArrivalJitterInfo() :
+        iNumPackets ( 0 ),
+        dMeanIntervalMs ( 0 ),
+        dIntervalP99Ms ( 0 ),
+        dDelayP50Ms ( 0 ),
+        dDelayP95Ms ( 0 ),
+        dDelayP99Ms ( 0 ),
+        dDelayMaxMs ( 0 ),
+        dDriftPpm ( 0 )
+    {}
+
+    int    iNumPackets;     // number of packets in the history
+    double dMeanIntervalMs; // mean inter-arrival time since the statistic was started
+    double dIntervalP99Ms;  // 99th percentile of the inter-arrival times
+    double dDelayP50Ms;     // percentiles of the delay compared to the fastest packets
+    double dDelayP95Ms;
+    double dDelayP99Ms;
+    double dDelayMaxMs;
+    double dDriftPpm; // deviation of the mean interval from the nominal packet interval
+};
+
+// Measures the jitter of the packet arrival times (kernel receive timestamps
+// if available). The delay of a packet is its arrival time compared to the
+// lower envelope of the arrival times, i.e. to the packets with the smallest
+// network delay, which is what a jitter buffer has to compensate.
+class CArrivalJitterStatistic
+{
+public:
+    CArrivalJitterStatistic() { Reset(); }
+
+    void Reset();
+    void GetInfo ( CArrivalJitterInfo& Info );
+
+    // copies the history and the counters without evaluating them so that the
+    // lock of the updating thread is only held for the copy, GetInfo() of the
+    // snapshot can then be called without the lock
+    void GetSnapshot ( CArrivalJitterStatistic& Snapshot ) const;
+
+    // returns the delay of the packet or -1 if the statistic was restarted
+    double Update ( const int64_t iArrivalTimeNs, const double dNominalIntervalNs );
+
+protected:
+    void Restart ( const int64_t iArrivalTimeNs, const double dNominalIntervalNs );
+
+    CVector<float> vecfIntervalsMs;
+    CVector<float> vecfDelaysMs;
+    CVector<float> vecfScratch;
+    int            iHistoryPos;
+    int            iNumHistory;
+
+    bool    bStarted;
+    int64_t iStartTimeNs;
+    int64_t iLastArrivalTimeNs;
+    int64_t iNumIntervals;
+    double  dNominalIntervalNs;
+    double  dRefArrivalNs; // delay reference relative to the start time
+};